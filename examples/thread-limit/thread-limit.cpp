@@ -0,0 +1,69 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+long
+fib(long n) __attribute__((noinline));
+
+void
+run(long n) __attribute__((noinline));
+
+std::atomic<long>   total{ 0 };
+std::atomic<size_t> completed{ 0 };
+
+long
+fib(long n)
+{
+    return (n < 2) ? n : fib(n - 1) + fib(n - 2);
+}
+
+void
+run(long n)
+{
+    total += fib(n);
+    ++completed;
+}
+
+int
+main(int argc, char** argv)
+{
+    std::string _name = argv[0];
+    auto        _pos  = _name.find_last_of('/');
+    if(_pos != std::string::npos) _name = _name.substr(_pos + 1);
+
+    // spawns "nthread" short-lived threads in waves of "nwave" concurrent threads
+    // so that the total number of threads created over the lifetime of the process
+    // exceeds the number of threads which are ever alive at the same time
+    size_t nthread = 4096;
+    size_t nwave   = 32;
+    long   nfib    = 10;
+
+    if(argc > 1) nthread = std::stoul(argv[1]);
+    if(argc > 2) nwave = std::stoul(argv[2]);
+    if(argc > 3) nfib = std::stol(argv[3]);
+
+    if(nwave == 0) nwave = 1;
+
+    printf("[%s] spawning %zu threads in waves of %zu...\n", _name.c_str(), nthread,
+           nwave);
+
+    auto _threads = std::vector<std::thread>{};
+    _threads.reserve(nwave);
+    for(size_t i = 0; i < nthread; i += nwave)
+    {
+        for(size_t j = i; j < std::min(i + nwave, nthread); ++j)
+            _threads.emplace_back(&run, nfib);
+        for(auto& itr : _threads)
+            itr.join();
+        _threads.clear();
+    }
+
+    printf("[%s] completed %zu threads. fibonacci(%li) x %zu = %li\n", _name.c_str(),
+           completed.load(), nfib, nthread, total.load());
+
+    return (completed.load() == nthread) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,194 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "critical-path.hpp"
+
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+namespace omnitrace
+{
+namespace critical_trace
+{
+namespace
+{
+// waves smaller than this are not worth distributing across the thread-pool
+constexpr size_t min_parallel_wave = 4096;
+
+std::pair<size_t, size_t>
+get_partition(size_t _n, size_t _npartitions, size_t _idx)
+{
+    return { (_n * _idx) / _npartitions, (_n * (_idx + 1)) / _npartitions };
+}
+}  // namespace
+
+critical_path::critical_path(const call_chain& _chain, const call_graph_index& _index,
+                             size_t _npartitions,
+                             const call_graph_index::parallel_for_t& _parallel_for)
+: m_chain{ _chain }
+, m_index{ _index }
+{
+    const size_t _n = m_index.nodes.size();
+    _npartitions    = std::max<size_t>(_npartitions, 1);
+
+    auto _run = [&](size_t _size, auto&& _func) {
+        if(_size < min_parallel_wave || _npartitions == 1)
+        {
+            for(size_t i = 0; i < _size; ++i)
+                _func(i);
+            return;
+        }
+        _parallel_for(_npartitions, [&](size_t _idx) {
+            auto _range = get_partition(_size, _npartitions, _idx);
+            for(size_t i = _range.first; i < _range.second; ++i)
+                _func(i);
+        });
+    };
+
+    // duplicate entries share a node so a node may be listed as a child more than once
+    m_children.resize(_n);
+    _run(_n, [&](size_t i) {
+        auto& _children = m_children.at(i);
+        _children       = m_index.children.at(i);
+        std::sort(_children.begin(), _children.end());
+        _children.erase(std::unique(_children.begin(), _children.end()),
+                        _children.end());
+        _children.erase(std::remove(_children.begin(), _children.end(), i),
+                        _children.end());
+    });
+
+    auto _remaining = std::vector<size_t>(_n, 0);
+    auto _parents   = std::vector<std::vector<size_t>>(_n);
+    for(size_t i = 0; i < _n; ++i)
+    {
+        _remaining.at(i) = m_children.at(i).size();
+        for(auto itr : m_children.at(i))
+            _parents.at(itr).emplace_back(i);
+    }
+
+    // reverse topological order: a node is ready once the costs of all of its
+    // children have been computed
+    auto _wave = std::vector<size_t>{};
+    for(size_t i = 0; i < _n; ++i)
+    {
+        if(_remaining.at(i) == 0) _wave.emplace_back(i);
+    }
+    num_leaves = _wave.size();
+
+    cost.assign(_n, -1);
+    while(!_wave.empty())
+    {
+        _run(_wave.size(), [&](size_t i) {
+            auto    _node  = _wave.at(i);
+            int64_t _child = 0;
+            for(auto itr : m_children.at(_node))
+                _child = std::max(_child, cost.at(itr));
+            cost.at(_node) = m_chain.at(m_index.nodes.at(_node)).get_cost() + _child;
+        });
+
+        auto _next = std::vector<size_t>{};
+        for(auto itr : _wave)
+        {
+            for(auto pitr : _parents.at(itr))
+                if(--_remaining.at(pitr) == 0) _next.emplace_back(pitr);
+        }
+        std::swap(_wave, _next);
+    }
+
+    for(size_t i = 0; i < _n; ++i)
+    {
+        if(cost.at(i) < 0)
+            ++num_cyclic;
+        else if(_parents.at(i).empty())
+            roots.emplace_back(i);
+    }
+}
+
+std::vector<call_chain>
+critical_path::get_top(size_t _count) const
+{
+    // a path prefix is stored as its last node and the prefix it extends
+    struct prefix
+    {
+        size_t node   = npos;
+        size_t parent = npos;
+    };
+
+    struct candidate
+    {
+        int64_t bound  = 0;  // cost of the best path through this prefix
+        int64_t cost   = 0;  // cost of the prefix
+        size_t  prefix = npos;
+        size_t  order  = 0;  // insertion order to break ties deterministically
+
+        bool operator<(const candidate& _rhs) const
+        {
+            return (bound == _rhs.bound) ? (order > _rhs.order) : (bound < _rhs.bound);
+        }
+    };
+
+    // the number of leaves is only the default number of paths
+    if(_count == 0) _count = num_leaves;
+
+    auto _get_cost = [this](size_t _node) {
+        return m_chain.at(m_index.nodes.at(_node)).get_cost();
+    };
+
+    auto _prefixes = std::vector<prefix>{};
+    auto _queue    = std::priority_queue<candidate>{};
+    auto _push     = [&](size_t _node, size_t _parent, int64_t _cost, int64_t _bound) {
+        auto _idx = _prefixes.size();
+        _prefixes.emplace_back(prefix{ _node, _parent });
+        _queue.emplace(candidate{ _bound, _cost, _idx, _idx });
+    };
+
+    for(auto itr : roots)
+        _push(itr, npos, _get_cost(itr), cost.at(itr));
+
+    // the bound is the exact cost of the longest completion of the prefix so the
+    // complete paths are popped in descending order of cost
+    auto _paths = std::vector<call_chain>{};
+    while(!_queue.empty() && _paths.size() < _count)
+    {
+        auto _top = _queue.top();
+        _queue.pop();
+
+        auto _node = _prefixes.at(_top.prefix).node;
+        if(m_children.at(_node).empty())
+        {
+            auto _path = call_chain{};
+            for(auto itr = _top.prefix; itr != npos; itr = _prefixes.at(itr).parent)
+                _path.emplace_back(m_chain.at(m_index.nodes.at(_prefixes.at(itr).node)));
+            std::reverse(_path.begin(), _path.end());
+            _paths.emplace_back(std::move(_path));
+            continue;
+        }
+
+        for(auto itr : m_children.at(_node))
+            _push(itr, _top.prefix, _top.cost + _get_cost(itr), _top.cost + cost.at(itr));
+    }
+
+    return _paths;
+}
+}  // namespace critical_trace
+}  // namespace omnitrace
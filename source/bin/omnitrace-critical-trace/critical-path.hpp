@@ -0,0 +1,77 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "graph-index.hpp"
+
+#include "library/critical_trace.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace omnitrace
+{
+namespace critical_trace
+{
+// longest (highest cost) paths through the DAG formed by the parent/child
+// relationships in the call-graph index. Edges follow parent_cid so they include
+// dependencies across threads and devices, e.g. a kernel launched by a CPU thread.
+//
+// The cost of each node to the end of its longest path is computed by dynamic
+// programming in reverse topological order, one dependency wave at a time: a wave
+// contains the nodes whose children are all in earlier waves. The waves are
+// processed in order and the nodes within a dependency wave are processed in
+// parallel, split into one partition per thread when the wave is large enough.
+// The top paths are then extracted in order with a best-first search which uses the
+// exact longest-path cost as its bound, so only the prefixes of the reported paths
+// (and their immediate alternatives) are ever visited.
+struct critical_path
+{
+    static constexpr auto npos = static_cast<size_t>(-1);
+
+    critical_path(const call_chain& _chain, const call_graph_index& _index,
+                  size_t _npartitions, const call_graph_index::parallel_for_t& _func);
+
+    /// the top paths in descending order of cost. When count is zero, the top
+    /// num_leaves paths are returned: this is the number of paths, not one path per
+    /// leaf, so several of the paths may end at the same leaf
+    std::vector<call_chain> get_top(size_t _count) const;
+
+    /// the cost of each node and its longest path of descendants. Nodes which are
+    /// part of a cycle have a cost of -1
+    std::vector<int64_t> cost = {};
+    /// the nodes without a parent, i.e. where the paths begin
+    std::vector<size_t> roots = {};
+    /// the number of nodes without children
+    size_t num_leaves = 0;
+    /// the number of nodes excluded because they are part of a cycle
+    size_t num_cyclic = 0;
+
+private:
+    const call_chain&                m_chain;
+    const call_graph_index&          m_index;
+    std::vector<std::vector<size_t>> m_children = {};
+};
+}  // namespace critical_trace
+}  // namespace omnitrace
@@ -21,6 +21,8 @@
 // SOFTWARE.
 
 #include "critical-trace.hpp"
+#include "critical-path.hpp"
+#include "graph-index.hpp"
 
 #include "api.hpp"
 #include "library/config.hpp"
@@ -70,8 +72,12 @@ main(int argc, char** argv)
     {
         critical_trace::complete_call_chain = {};
         OMNITRACE_BASIC_PRINT_F("Loading call-chain %s...\n", argv[i]);
-        critical_trace::load_call_chain(argv[i], "call_chain",
-                                        critical_trace::complete_call_chain);
+        if(!critical_trace::load_call_chain(argv[i], "call_chain",
+                                            critical_trace::complete_call_chain))
+        {
+            OMNITRACE_BASIC_PRINT_F("Error loading call-chain %s\n", argv[i]);
+            std::exit(EXIT_FAILURE);
+        }
         for(const auto& itr : *tim::get_hash_ids())
             critical_trace::complete_hash_ids.emplace(itr.second);
         OMNITRACE_BASIC_PRINT_F("Computing critical trace for %s...\n", argv[i]);
@@ -369,110 +375,73 @@ save_call_chain_json(const std::string& _fname, const std::string& _label,
     }
 }
 
-void
+bool
 load_call_chain(const std::string& _fname, const std::string& _label,
                 call_chain& _call_chain)
 {
+    if(is_call_chain_binary(_fname)) return load_call_chain_binary(_fname, _call_chain);
+
     std::ifstream ifs{};
     ifs.open(_fname);
-    if(ifs && ifs.is_open())
+    if(!ifs || !ifs.is_open())
     {
-        namespace cereal = tim::cereal;
-        auto ar          = tim::policy::input_archive<cereal::JSONInputArchive>::get(ifs);
-
-        ar->setNextName("omnitrace");
-        ar->startNode();
-        (*ar)(cereal::make_nvp(_label.c_str(), _call_chain));
-        ar->finishNode();
+        OMNITRACE_BASIC_PRINT_F("Error opening '%s'\n", _fname.c_str());
+        return false;
     }
-}
-
-auto
-get_indexed(const call_chain& _chain)
-{
-    OMNITRACE_CT_DEBUG("\n");
-    std::map<int64_t, std::vector<entry>> _indexed = {};
 
-    // allocate for all cpu correlation ids
-    for(const auto& itr : _chain)
-    {
-        _indexed.emplace(static_cast<int64_t>(itr.cpu_cid), std::vector<entry>{});
-        _indexed.emplace(static_cast<int64_t>(itr.parent_cid), std::vector<entry>{});
-    }
-
-    // index based on parent correlation id
-    for(const auto& itr : _chain)
-    {
-        if(itr.depth < 1 && itr.phase == Phase::BEGIN) continue;
-        _indexed[static_cast<int64_t>(itr.parent_cid)].emplace_back(itr);
-    }
+    namespace cereal = tim::cereal;
+    auto ar          = tim::policy::input_archive<cereal::JSONInputArchive>::get(ifs);
 
-    for(auto& itr : _indexed)
-        std::sort(itr.second.begin(), itr.second.end(),
-                  [](const entry& lhs, const entry& rhs) {
-                      // return lhs.cpu_cid < rhs.cpu_cid;
-                      return lhs.begin_ns < rhs.begin_ns;
-                  });
+    ar->setNextName("omnitrace");
+    ar->startNode();
+    (*ar)(cereal::make_nvp(_label.c_str(), _call_chain));
+    ar->finishNode();
+    return true;
+}
 
-    return _indexed;
+call_graph_index::parallel_for_t
+get_parallel_for(PTL::ThreadPool& _tp)
+{
+    return [&_tp](size_t _n, const std::function<void(size_t)>& _func) {
+        PTL::TaskGroup<void> _tg{ &_tp };
+        for(size_t i = 0; i < _n; ++i)
+            _tg.run(_func, i);
+        _tg.join();
+    };
 }
 
 void
-find_children(PTL::ThreadPool& _tp, call_graph_t& _graph, const call_chain& _chain)
+find_children(call_graph_t& _graph, const call_chain& _chain,
+              const call_graph_index& _index)
 {
     OMNITRACE_CT_DEBUG("\n");
 
-    using iterator_t      = call_graph_sibling_itr_t;
-    using itr_entry_vec_t = std::vector<std::pair<iterator_t, entry>>;
-    using task_group_t    = PTL::TaskGroup<void>;
-
-    auto                                _indexed = get_indexed(_chain);
-    std::map<entry, std::vector<entry>> _entry_map{};
+    using iterator_t     = call_graph_sibling_itr_t;
+    using itr_node_vec_t = std::vector<std::pair<iterator_t, size_t>>;
 
-    // allocate all entries
-    OMNITRACE_CT_DEBUG_F("Allocating...\n");
-    for(const auto& itr : _chain)
+    for(const auto& itr : _index.duplicates)
     {
-        auto _ins = _entry_map.emplace(itr, std::vector<entry>{});
-        if(!_ins.second)
-        {
-            auto _existing = _ins.first->first;
-            OMNITRACE_BASIC_PRINT("Warning! Duplicate entry for [%s] :: [%s]\n",
-                                  JOIN("", _existing).c_str(), JOIN("", itr).c_str());
-        }
+        OMNITRACE_BASIC_PRINT("Warning! Duplicate entry for [%s] :: [%s]\n",
+                              JOIN("", _chain.at(itr.first)).c_str(),
+                              JOIN("", _chain.at(itr.second)).c_str());
     }
 
-    task_group_t _tg{ &_tp };
-    OMNITRACE_CT_DEBUG_F("Parallel mapping...\n");
-    for(const auto& itr : _chain)
-    {
-        _tg.run([&]() { _entry_map[itr] = _indexed.at(itr.cpu_cid); });
-    }
-    _tg.join();
-
-    std::function<void(iterator_t, const entry&)> _recursive_func;
-    _recursive_func = [&](iterator_t itr, const entry& _v) {
-        auto _child    = _graph.append_child(itr, _v);
-        auto _children = std::move(_entry_map[_v]);
-        _entry_map[_v].clear();
-        for(auto&& vitr : _children)
-        {
-            _recursive_func(_child, vitr);
-        }
-    };
-
-    // the recursive version of _func + _loop_func has a tendency to overflow the stack
-    auto _func = [&](iterator_t itr, const entry& _v) {
-        auto _child    = _graph.append_child(itr, _v);
-        auto _children = std::move(_entry_map[_v]);
-        _entry_map[_v].clear();
-        itr_entry_vec_t _data{};
-        for(auto&& vitr : _children)
+    // the children of a node are only added to the graph the first time it is visited
+    auto _visited = std::vector<bool>(_index.nodes.size(), false);
+
+    // the recursive version of this has a tendency to overflow the stack
+    auto _func = [&](iterator_t itr, size_t _node) {
+        const auto&    _v     = _chain.at(_index.nodes.at(_node));
+        auto           _child = _graph.append_child(itr, _v);
+        itr_node_vec_t _data{};
+        if(_visited.at(_node)) return _data;
+        _visited.at(_node) = true;
+        for(auto vitr : _index.children.at(_node))
             _data.emplace_back(_child, vitr);
         return _data;
     };
 
-    auto _loop_func = [&_func](itr_entry_vec_t& _data) {
+    auto _loop_func = [&_func](itr_node_vec_t& _data) {
         auto _inp = _data;
         _data.clear();
         for(auto itr : _inp)
@@ -484,10 +453,10 @@ find_children(PTL::ThreadPool& _tp, call_graph_t& _graph, const call_chain& _cha
         return !_data.empty();
     };
 
-    if(!_indexed.at(-1).empty())
+    if(!_index.roots.empty())
     {
         OMNITRACE_CT_DEBUG_F("Setting root (line %i)...\n", __LINE__);
-        _graph.set_head(_indexed.at(-1).front());
+        _graph.set_head(_chain.at(_index.roots.front()));
     }
     else
     {
@@ -499,171 +468,18 @@ find_children(PTL::ThreadPool& _tp, call_graph_t& _graph, const call_chain& _cha
     }
 
     iterator_t _root = _graph.begin();
-    for(auto&& itr : _entry_map)
+    for(size_t i = 0; i < _index.nodes.size(); ++i)
     {
-        if(itr.first.depth == _root->depth + 1)
+        if(_chain.at(_index.nodes.at(i)).depth == _root->depth + 1)
         {
             OMNITRACE_CT_DEBUG_F("Generating call-graph...\n");
-            // _recursive_func(_root, itr.first);
-            itr_entry_vec_t _data = _func(_root, itr.first);
+            itr_node_vec_t _data = _func(_root, i);
             while(_loop_func(_data))
             {}
         }
     }
 }
 
-void
-find_sequences(PTL::ThreadPool& _tp, call_graph_t& _graph,
-               std::vector<call_chain>& _chain)
-{
-    OMNITRACE_CT_DEBUG("\n");
-    /*
-    using sibling_itr_t = call_graph_sibling_itr_t;
-    using sibling_vec_t = std::vector<sibling_itr_t>;
-    using sibling_map_t = std::map<int64_t, sibling_vec_t>;
-
-    std::function<void(sibling_map_t & _v, sibling_itr_t root)> _no_overlap{};
-    _no_overlap = [&](sibling_map_t& _v, sibling_itr_t root) {
-        sibling_map_t _l{};
-        int64_t       n = _graph.number_of_children(root);
-        if(n == 0) return;
-
-        //_graph.sort(sibling_itr_t{ root },
-        //            [](auto lhs, auto rhs) { return lhs.get_cost() > rhs.get_cost(); });
-
-        for(int64_t i = 0; i < n; ++i)
-        {
-            if(_l.empty())
-            {
-                auto itr = _graph.child(root, i);
-                _l[itr->tid].emplace_back(itr);
-            }
-            else
-            {
-                auto itr       = _graph.child(root, i);
-                bool _overlaps = false;
-                for(auto& litr : _l[itr->tid])
-                {
-                    if(litr->device == itr->device && litr->get_overlap(*itr) > 0)
-                    {
-                        _overlaps = true;
-                        break;
-                    }
-                }
-                if(!_overlaps) _l[itr->tid].emplace_back(itr);
-            }
-        }
-        for(auto& iitr : _l)
-        {
-            for(auto itr : iitr.second)
-            {
-                _v[iitr.first].emplace_back(itr);
-                _no_overlap(_v, itr);
-            }
-        }
-    };
-
-    std::map<int64_t, sibling_vec_t> _tot{};
-    for(sibling_itr_t itr = _graph.begin(); itr != _graph.end(); ++itr)
-    {
-        _no_overlap(_tot, itr);
-    }
-
-    for(const auto& iitr : _tot)
-    {
-        call_chain _cc{};
-        _cc.emplace_back(*_graph.begin());
-        for(const auto& itr : iitr.second)
-            _cc.emplace_back(*itr);
-        _chain.emplace_back(_cc);
-    }
-
-    (void) _tp;
-    */
-
-    using iterator_t = call_graph_preorder_itr_t;
-    std::vector<iterator_t> _end_nodes{};
-    size_t                  _n = 0;
-    for(iterator_t itr = _graph.begin(); itr != _graph.end(); ++itr, ++_n)
-    {
-        auto _nchild = _graph.number_of_children(itr);
-        if(_nchild > 0)
-        {
-            // OMNITRACE_CT_DEBUG("Skipping node #%zu with %u children :: %s\n", _n,
-            // _nchild, JOIN("", *itr).c_str());
-            continue;
-        }
-        _end_nodes.emplace_back(itr);
-    }
-    OMNITRACE_CT_DEBUG("Number of end nodes: %zu\n", _end_nodes.size());
-    _chain.resize(_end_nodes.size());
-
-    auto _construct = [&](size_t i) {
-        auto itr = _end_nodes.at(i);
-        while(itr != nullptr && _graph.is_valid(itr))
-        {
-            _chain.at(i).emplace_back(*itr);
-            itr = _graph.parent(itr);
-        }
-        std::reverse(_chain.at(i).begin(), _chain.at(i).end());
-        std::sort(
-            _chain.at(i).begin(), _chain.at(i).end(),
-            [](const entry& lhs, const entry& rhs) { return lhs.begin_ns > rhs.end_ns; });
-    };
-
-    PTL::TaskGroup<void> _tg{ &_tp };
-    for(size_t i = 0; i < _end_nodes.size(); ++i)
-        _tg.run(_construct, i);
-    _tg.join();
-
-    std::sort(_chain.begin(), _chain.end(),
-              [](const call_chain& lhs, const call_chain& rhs) {
-                  return lhs.get_cost() > rhs.get_cost();
-              });
-
-    /*
-    std::vector<call_chain> _new_chain{};
-    for(auto& itr : _chain)
-    {
-        if(itr.empty()) continue;
-        if(_new_chain.empty())
-        {
-            _new_chain.emplace_back(std::move(itr));
-            continue;
-        }
-        std::sort(itr.begin(), itr.end(), [](const entry& lhs, const entry& rhs) {
-            return lhs.get_cost() > rhs.get_cost();
-        });
-
-        call_chain* _append_chain = nullptr;
-        for(auto& nitr : _new_chain)
-        {
-            if(nitr.at(0).tid == itr.at(0).tid && nitr.at(0).get_overlap(itr.at(0)) <= 0)
-            {
-                _append_chain = &nitr;
-                break;
-            }
-        }
-
-        if(_append_chain)
-        {
-            for(auto& oitr : itr)
-                _append_chain->emplace_back(oitr);
-            std::sort(_append_chain->begin(), _append_chain->end(),
-                      [](const entry& lhs, const entry& rhs) {
-                          return lhs.get_cost() > rhs.get_cost();
-                      });
-        }
-        else
-        {
-            _new_chain.emplace_back(std::move(itr));
-        }
-        itr.clear();
-    }
-
-    _chain = _new_chain;*/
-}
-
 template <typename ArchiveT, typename T, typename AllocatorT>
 void
 serialize_graph(ArchiveT& ar, const tim::graph<T, AllocatorT>& t)
@@ -768,68 +584,6 @@ generate_perfetto(const std::vector<call_chain>& _data)
     }
 }
 
-template <typename Tp, template <typename...> class ContainerT, typename... Args,
-          typename FuncT = bool (*)(const Tp&, const Tp&)>
-inline Tp*
-find(
-    const Tp& _v, ContainerT<Tp, Args...>& _vec,
-    FuncT&& _func = [](const Tp& _lhs, const Tp& _rhs) { return (_lhs == _rhs); })
-{
-    for(auto& itr : _vec)
-    {
-        if(std::forward<FuncT>(_func)(_v, itr)) return &itr;
-    }
-    return nullptr;
-};
-
-template <typename FuncT = bool (*)(const entry&, const entry&)>
-inline entry*
-find(
-    const entry& _v, call_chain& _vec,
-    FuncT&& _func = [](const entry& _lhs, const entry& _rhs) { return (_lhs == _rhs); })
-{
-    return find(_v, reinterpret_cast<std::vector<entry>&>(_vec),
-                std::forward<FuncT>(_func));
-}
-
-void
-squash_critical_path(call_chain& _targ)
-{
-    OMNITRACE_CT_DEBUG("\n");
-    static auto _strict_equal = [](const entry& _lhs, const entry& _rhs) {
-        auto _same_phase  = (_lhs.phase == _rhs.phase);
-        bool _phase_check = true;
-        if(_same_phase) _phase_check = (_lhs.get_timestamp() == _rhs.get_timestamp());
-        return (_lhs == _rhs && _lhs.parent_cid == _rhs.parent_cid && _phase_check);
-    };
-
-    std::sort(_targ.begin(), _targ.end());
-
-    call_chain _squashed{};
-    for(auto& itr : _targ)
-    {
-        if(itr.phase == Phase::DELTA)
-        {
-            _squashed.emplace_back(itr);
-        }
-        else if(itr.phase == Phase::BEGIN)
-        {
-            if(!find(itr, _squashed, _strict_equal)) _squashed.emplace_back(itr);
-        }
-        else
-        {
-            entry* _match = nullptr;
-            if((_match = find(itr, _squashed)) != nullptr)
-                *_match += itr;
-            else
-                _squashed.emplace_back(itr);
-        }
-    }
-
-    std::swap(_targ, _squashed);
-    std::sort(_targ.begin(), _targ.end());
-}
-
 void
 compute_critical_trace()
 {
@@ -886,9 +640,14 @@ compute_critical_trace()
             _report_perf(_perf, __FUNCTION__, "perfetto generation");
         }
 
+        OMNITRACE_BASIC_PRINT_F("indexing call chain...\n");
+        auto _parallel_for = get_parallel_for(_tp);
+        auto _index = call_graph_index{ complete_call_chain, _tp.size(), _parallel_for };
+        _report_perf(_perf, __FUNCTION__, "indexing call chain");
+
         OMNITRACE_BASIC_PRINT_F("finding children...\n");
         call_graph_t _graph{};
-        find_children(_tp, _graph, complete_call_chain);
+        find_children(_graph, complete_call_chain, _index);
         _report_perf(_perf, __FUNCTION__, "finding children");
 
         // sort the call-graph based on cost
@@ -902,10 +661,17 @@ compute_critical_trace()
                         "call_graph", _graph, true, __FUNCTION__);
         _report_perf(_perf, __FUNCTION__, "saving call-graph");
 
-        OMNITRACE_BASIC_PRINT_F("finding sequences...\n");
-        std::vector<call_chain> _top{};
-        find_sequences(_tp, _graph, _top);
-        _report_perf(_perf, __FUNCTION__, "call-graph sequence search");
+        OMNITRACE_BASIC_PRINT_F("computing critical paths...\n");
+        auto _critical_path =
+            critical_path{ complete_call_chain, _index, _tp.size(), _parallel_for };
+        if(_critical_path.num_cyclic > 0)
+        {
+            OMNITRACE_BASIC_PRINT_F("Warning! %zu call-graph nodes are part of a cycle "
+                                    "and were excluded from the critical paths\n",
+                                    _critical_path.num_cyclic);
+        }
+        std::vector<call_chain> _top = _critical_path.get_top(get_critical_trace_count());
+        _report_perf(_perf, __FUNCTION__, "critical path computation");
 
         OMNITRACE_BASIC_PRINT_F("number of sequences found: %zu (%zu)...\n", _top.size(),
                                 (_top.empty()) ? 0 : _top.at(0).size());
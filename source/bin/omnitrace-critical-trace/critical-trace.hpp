@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include "graph-index.hpp"
+
 #include "library/config.hpp"
 #include "library/critical_trace.hpp"
 #include "library/debug.hpp"
@@ -65,23 +67,19 @@ std::mutex complete_call_mutex{};
 void
 update_critical_path(call_chain _chain, int64_t _tid);
 
-void
+bool
 load_call_chain(const std::string& _fname, const std::string& _label,
                 call_chain& _call_chain);
 
 void
 compute_critical_trace();
 
-void
-find_children(PTL::ThreadPool& _tp, call_graph_t& _graph, const call_chain& _chain);
-
-void
-find_sequences(PTL::ThreadPool& _tp, call_graph_t& _graph,
-               std::vector<call_chain>& _chain);
+call_graph_index::parallel_for_t
+get_parallel_for(PTL::ThreadPool& _tp);
 
 void
-find_sequences(PTL::ThreadPool& _tp, call_graph_t& _graph, call_graph_itr_t _root,
-               std::vector<call_chain>& _chain);
+find_children(call_graph_t& _graph, const call_chain& _chain,
+              const call_graph_index& _index);
 
 template <typename ArchiveT, typename T, typename AllocatorT>
 void
@@ -0,0 +1,173 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "graph-index.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
+namespace omnitrace
+{
+namespace critical_trace
+{
+namespace
+{
+using position_vec_t = std::vector<size_t>;
+using parent_map_t   = std::unordered_map<uint64_t, position_vec_t>;
+
+constexpr auto no_parent = std::numeric_limits<uint64_t>::max();
+
+// half-open range of the call-chain positions in a partition
+std::pair<size_t, size_t>
+get_partition(size_t _n, size_t _npartitions, size_t _idx)
+{
+    return { (_n * _idx) / _npartitions, (_n * (_idx + 1)) / _npartitions };
+}
+}  // namespace
+
+call_graph_index::call_graph_index(const call_chain& _chain, size_t _npartitions,
+                                   const parallel_for_t& _parallel_for)
+{
+    const size_t _n = _chain.size();
+    _npartitions    = std::max<size_t>(std::min<size_t>(_npartitions, _n), 1);
+
+    // index the children of each parent correlation id within each partition. The
+    // positions in each partition are in ascending order
+    auto _partitions = std::vector<parent_map_t>(_npartitions);
+    _parallel_for(_npartitions, [&](size_t _idx) {
+        auto  _range = get_partition(_n, _npartitions, _idx);
+        auto& _local = _partitions.at(_idx);
+        for(size_t i = _range.first; i < _range.second; ++i)
+        {
+            const auto& itr = _chain.at(i);
+            if(itr.depth < 1 && itr.phase == Phase::BEGIN) continue;
+            // entry is packed so copy the field instead of binding a reference to it
+            uint64_t _parent_cid = itr.parent_cid;
+            _local[_parent_cid].emplace_back(i);
+        }
+    });
+
+    // merge the partitions in order so that the positions for each parent remain
+    // in ascending order
+    auto _parents = parent_map_t{};
+    for(auto& pitr : _partitions)
+    {
+        for(auto& itr : pitr)
+        {
+            auto& _v = _parents[itr.first];
+            _v.insert(_v.end(), itr.second.begin(), itr.second.end());
+        }
+        pitr = parent_map_t{};
+    }
+
+    // order the children by their start time. Ties are broken by position so that
+    // the order does not depend on the sorting algorithm
+    auto _by_start = [&_chain](size_t _lhs, size_t _rhs) {
+        int64_t _lhs_beg = _chain.at(_lhs).begin_ns;
+        int64_t _rhs_beg = _chain.at(_rhs).begin_ns;
+        return (_lhs_beg == _rhs_beg) ? (_lhs < _rhs) : (_lhs_beg < _rhs_beg);
+    };
+
+    auto _child_lists = std::vector<position_vec_t*>{};
+    _child_lists.reserve(_parents.size());
+    for(auto& itr : _parents)
+        _child_lists.emplace_back(&itr.second);
+
+    _parallel_for(_npartitions, [&](size_t _idx) {
+        auto _range = get_partition(_child_lists.size(), _npartitions, _idx);
+        for(size_t i = _range.first; i < _range.second; ++i)
+            std::sort(_child_lists.at(i)->begin(), _child_lists.at(i)->end(),
+                      _by_start);
+    });
+
+    // sort the positions by entry and then by position: sort each partition
+    // concurrently and then merge the sorted partitions
+    auto _by_entry = [&_chain](size_t _lhs, size_t _rhs) {
+        const auto& _lhs_v = _chain.at(_lhs);
+        const auto& _rhs_v = _chain.at(_rhs);
+        if(_lhs_v < _rhs_v) return true;
+        if(_rhs_v < _lhs_v) return false;
+        return (_lhs < _rhs);
+    };
+
+    auto _sorted = position_vec_t(_n);
+    for(size_t i = 0; i < _n; ++i)
+        _sorted.at(i) = i;
+
+    _parallel_for(_npartitions, [&](size_t _idx) {
+        auto _range = get_partition(_n, _npartitions, _idx);
+        std::sort(_sorted.begin() + _range.first, _sorted.begin() + _range.second,
+                  _by_entry);
+    });
+
+    for(size_t i = 1; i < _npartitions; ++i)
+    {
+        auto _mid = get_partition(_n, _npartitions, i).first;
+        auto _end = get_partition(_n, _npartitions, i).second;
+        std::inplace_merge(_sorted.begin(), _sorted.begin() + _mid,
+                           _sorted.begin() + _end, _by_entry);
+    }
+
+    // equivalent entries are adjacent after sorting and the first one (lowest
+    // position) represents the node
+    node_of.resize(_n);
+    nodes.reserve(_n);
+    for(size_t i = 0; i < _n; ++i)
+    {
+        auto _pos = _sorted.at(i);
+        if(i > 0 && !(_chain.at(nodes.back()) < _chain.at(_pos)))
+            duplicates.emplace_back(nodes.back(), _pos);
+        else
+            nodes.emplace_back(_pos);
+        node_of.at(_pos) = nodes.size() - 1;
+    }
+
+    // resolve the children of each node
+    children.resize(nodes.size());
+    _parallel_for(_npartitions, [&](size_t _idx) {
+        auto _range = get_partition(nodes.size(), _npartitions, _idx);
+        for(size_t i = _range.first; i < _range.second; ++i)
+        {
+            uint64_t _cpu_cid = _chain.at(nodes.at(i)).cpu_cid;
+            auto     itr      = _parents.find(_cpu_cid);
+            if(itr == _parents.end()) continue;
+            auto& _children = children.at(i);
+            _children.reserve(itr->second.size());
+            for(auto _pos : itr->second)
+                _children.emplace_back(node_of.at(_pos));
+        }
+    });
+
+    auto ritr = _parents.find(no_parent);
+    if(ritr != _parents.end()) roots = ritr->second;
+}
+
+bool
+call_graph_index::operator==(const call_graph_index& _rhs) const
+{
+    return (nodes == _rhs.nodes && node_of == _rhs.node_of &&
+            children == _rhs.children && roots == _rhs.roots &&
+            duplicates == _rhs.duplicates);
+}
+}  // namespace critical_trace
+}  // namespace omnitrace
@@ -0,0 +1,70 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "library/critical_trace.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace omnitrace
+{
+namespace critical_trace
+{
+// index of the parent/child relationships in a call-chain used to construct the
+// call-graph. Entries which are equivalent w.r.t. entry::operator< share a node and
+// the children of a node are the entries whose parent_cid is the cpu_cid of the node,
+// ordered by their start time.
+//
+// The index is built by partitioning the call-chain, indexing each partition
+// independently, and merging the partitions in order so the result is identical
+// regardless of the number of partitions or the order in which they are processed.
+struct call_graph_index
+{
+    // invokes the function for [0, N), possibly concurrently, and returns once all
+    // the invocations have completed
+    using parallel_for_t =
+        std::function<void(size_t, const std::function<void(size_t)>&)>;
+
+    call_graph_index(const call_chain& _chain, size_t _npartitions,
+                     const parallel_for_t& _parallel_for);
+
+    bool operator==(const call_graph_index&) const;
+    bool operator!=(const call_graph_index& _rhs) const { return !(*this == _rhs); }
+
+    /// position in the call-chain of the first entry of each node, in sorted order
+    std::vector<size_t> nodes = {};
+    /// node of each entry in the call-chain
+    std::vector<size_t> node_of = {};
+    /// nodes of the children of each node
+    std::vector<std::vector<size_t>> children = {};
+    /// positions in the call-chain of the entries without a parent
+    std::vector<size_t> roots = {};
+    /// positions in the call-chain of the {existing, duplicate} entries of a node
+    std::vector<std::pair<size_t, size_t>> duplicates = {};
+};
+}  // namespace critical_trace
+}  // namespace omnitrace
@@ -161,6 +161,7 @@ extern bool   loop_level_instr;
 extern bool   instr_dynamic_callsites;
 extern bool   instr_traps;
 extern bool   instr_loop_traps;
+extern bool   use_region_ids;
 extern size_t min_address_range;
 extern size_t min_loop_address_range;
 extern size_t min_instructions;
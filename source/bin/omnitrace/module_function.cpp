@@ -657,8 +657,10 @@ module_function::operator()(address_space_t* _addr_space, procedure_t* _entr_tra
     auto _name       = signature.get();
     auto _trace_entr = omnitrace_call_expr(_name.c_str());
     auto _trace_exit = omnitrace_call_expr(_name.c_str());
-    auto _entr       = _trace_entr.get(_entr_trace);
-    auto _exit       = _trace_exit.get(_exit_trace);
+    auto _entr       = (use_region_ids) ? get_region_ids().get(_entr_trace, _name)
+                                        : _trace_entr.get(_entr_trace);
+    auto _exit       = (use_region_ids) ? get_region_ids().get(_exit_trace, _name)
+                                        : _trace_exit.get(_exit_trace);
 
     if(insert_instr(_addr_space, function, _entr, BPatch_entry) &&
        insert_instr(_addr_space, function, _exit, BPatch_exit))
@@ -707,8 +709,10 @@ module_function::operator()(address_space_t* _addr_space, procedure_t* _entr_tra
 
         auto _ltrace_entr = omnitrace_call_expr(_lname.c_str());
         auto _ltrace_exit = omnitrace_call_expr(_lname.c_str());
-        auto _lentr       = _ltrace_entr.get(_entr_trace);
-        auto _lexit       = _ltrace_exit.get(_exit_trace);
+        auto _lentr       = (use_region_ids) ? get_region_ids().get(_entr_trace, _lname)
+                                             : _ltrace_entr.get(_entr_trace);
+        auto _lexit       = (use_region_ids) ? get_region_ids().get(_exit_trace, _lname)
+                                             : _ltrace_exit.get(_exit_trace);
 
         if(insert_instr(_addr_space, function, _lentr, BPatch_entry, flow_graph, itr,
                         instr_loop_traps) &&
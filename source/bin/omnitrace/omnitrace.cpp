@@ -68,6 +68,7 @@ bool     loop_level_instr        = false;
 bool     instr_dynamic_callsites = false;
 bool     instr_traps             = false;
 bool     instr_loop_traps        = false;
+bool     use_region_ids          = false;
 size_t   min_address_range       = (1 << 8);  // 256
 size_t   min_loop_address_range  = (1 << 8);  // 256
 size_t   min_instructions        = (1 << 6);  // 64
@@ -602,6 +603,16 @@ main(int argc, char** argv)
                     default_components = _strcomp;
             }
         });
+    parser
+        .add_argument({ "--region-ids" },
+                      "Register the name of each instrumented function and loop once at "
+                      "start-up and start/stop the regions via an integer identifier "
+                      "instead of the name. This avoids processing the name on every "
+                      "call to the instrumentation")
+        .max_count(1)
+        .dtype("boolean")
+        .set_default(use_region_ids)
+        .action([](parser_t& p) { use_region_ids = p.get<bool>("region-ids"); });
     parser.add_argument({ "--env" },
                         "Environment variables to add to the runtime in form "
                         "VARIABLE=VALUE. E.g. use '--env OMNITRACE_USE_TIMEMORY=ON' to "
@@ -1403,6 +1414,9 @@ main(int argc, char** argv)
     auto* exit_trace   = find_function(app_image, "omnitrace_pop_trace");
     auto* reg_src_func = find_function(app_image, "omnitrace_register_source");
     auto* reg_cov_func = find_function(app_image, "omnitrace_register_coverage");
+    auto* reg_rgn_func = find_function(app_image, "omnitrace_register_region");
+    auto* entr_trace_i = find_function(app_image, "omnitrace_push_trace_id");
+    auto* exit_trace_i = find_function(app_image, "omnitrace_pop_trace_id");
 
     if(!main_func && main_fname == "main") main_func = find_function(app_image, "_main");
 
@@ -1533,6 +1547,18 @@ main(int argc, char** argv)
         }
     }
 
+    if(use_region_ids && (!reg_rgn_func || !entr_trace_i || !exit_trace_i ||
+                          !get_region_ids().initialize(addr_space, reg_rgn_func)))
+    {
+        verbprintf(0, "Warning! region identifiers are not available. Instrumentation "
+                      "will use the region names\n");
+        use_region_ids = false;
+    }
+
+    // functions used to instrument each function and loop (main uses the name)
+    auto* func_entr_trace = (use_region_ids) ? entr_trace_i : entr_trace;
+    auto* func_exit_trace = (use_region_ids) ? exit_trace_i : exit_trace;
+
     //----------------------------------------------------------------------------------//
     //
     //  Find the entry/exit point of either the main (if executable) or the _init
@@ -1813,7 +1839,7 @@ main(int argc, char** argv)
         for(const auto& itr : instrumented_module_functions)
         {
             if(itr.function == main_func) continue;
-            auto _count = itr(addr_space, entr_trace, exit_trace);
+            auto _count = itr(addr_space, func_entr_trace, func_exit_trace);
             _pass_info[itr.module_name].first += _count.first;
             _pass_info[itr.module_name].second += _count.second;
 
@@ -1896,22 +1922,22 @@ main(int argc, char** argv)
             verbprintf(
                 1,
                 "Using insertion set failed. Restarting with individual insertion...\n");
-            auto _execute_batch = [&addr_space, &entr_trace, &exit_trace](size_t _beg,
-                                                                          size_t _end) {
+            auto _execute_batch = [&addr_space, &func_entr_trace,
+                                   &func_exit_trace](size_t _beg, size_t _end) {
                 verbprintf(1, "Instrumenting batch of functions [%lu, %lu)\n",
                            (unsigned long) _beg, (unsigned long) _end);
                 addr_space->beginInsertionSet();
                 auto itr = instrumented_module_functions.begin();
                 std::advance(itr, _beg);
                 for(size_t i = _beg; i < _end; ++i, ++itr)
-                    (*itr)(addr_space, entr_trace, exit_trace);
+                    (*itr)(addr_space, func_entr_trace, func_exit_trace);
                 bool _modified = true;
                 bool _success  = addr_space->finalizeInsertionSet(true, &_modified);
                 return _success;
             };
 
-            auto execute_batch = [&_execute_batch, &addr_space, &entr_trace,
-                                  &exit_trace](size_t _beg) {
+            auto execute_batch = [&_execute_batch, &addr_space, &func_entr_trace,
+                                  &func_exit_trace](size_t _beg) {
                 if(!_execute_batch(_beg, _beg + batch_size))
                 {
                     verbprintf(1,
@@ -1923,7 +1949,7 @@ main(int argc, char** argv)
                     std::advance(itr, _beg);
                     for(size_t i = _beg; i < _beg + batch_size && itr != _end; ++i, ++itr)
                     {
-                        (*itr)(addr_space, entr_trace, exit_trace);
+                        (*itr)(addr_space, func_entr_trace, func_exit_trace);
                     }
                 }
                 return _beg + batch_size;
@@ -1937,6 +1963,36 @@ main(int argc, char** argv)
         }
     }
 
+    //----------------------------------------------------------------------------------//
+    //
+    //  Register the region identifiers before any instrumentation is executed
+    //
+    //----------------------------------------------------------------------------------//
+
+    if(use_region_ids && get_region_ids().size() > 0)
+    {
+        verbprintf(1, "Adding %zu region registration snippets...\n",
+                   get_region_ids().size());
+        auto _reg_names    = get_region_ids().get_registrations();
+        auto _reg_sequence = sequence_t{ _reg_names };
+        if(app_thread && is_attached)
+        {
+            for(auto* itr : _reg_names)
+                app_thread->oneTimeCode(*itr);
+        }
+        else if(main_entr_points)
+        {
+            // inserted as the first snippet so it precedes the initialization snippets
+            addr_space->insertSnippet(_reg_sequence, *main_entr_points,
+                                      BPatch_callBefore, BPatch_firstSnippet);
+        }
+        else
+        {
+            for(auto* itr : _objs)
+                itr->insertInitCallback(_reg_sequence);
+        }
+    }
+
     //----------------------------------------------------------------------------------//
     //
     //  Dump the available instrumented modules/functions (re-dump available)
@@ -127,6 +127,77 @@ private:
 //
 //======================================================================================//
 //
+// maps each region name to a variable in the address space which holds the identifier
+// returned by omnitrace_register_region. The registration snippets must be executed
+// before the instrumentation which reads the variables; until then the variables are
+// zero, which the library treats as an unregistered region
+struct omnitrace_region_ids
+{
+    using variable_t     = BPatch_variableExpr;
+    using variable_map_t = std::map<string_t, variable_t*>;
+
+    bool initialize(address_space_t* _addr_space, procedure_t* _register_func)
+    {
+        m_addr_space    = _addr_space;
+        m_register_func = _register_func;
+        for(const char* itr : { "unsigned long", "long", "size_t" })
+        {
+            if(m_type) break;
+            m_type = _addr_space->getImage()->findType(itr);
+        }
+        return (m_addr_space && m_register_func && m_type);
+    }
+
+    call_expr_pointer_t get(procedure_t* _trace_func, const string_t& _name)
+    {
+        auto* _var = get_variable(_name);
+        if(!_trace_func || !_var) return call_expr_pointer_t{};
+        return std::make_shared<call_expr_t>(*_trace_func, snippet_vec_t{ _var });
+    }
+
+    snippet_vec_t get_registrations() const
+    {
+        snippet_vec_t _ret{};
+        for(const auto& itr : m_registrations)
+            _ret.push_back(itr.get());
+        return _ret;
+    }
+
+    size_t size() const { return m_registrations.size(); }
+
+private:
+    variable_t* get_variable(const string_t& _name)
+    {
+        auto itr = m_variables.find(_name);
+        if(itr != m_variables.end()) return itr->second;
+
+        auto* _var = m_addr_space->malloc(*m_type);
+        if(!_var) return nullptr;
+
+        // <variable> = omnitrace_register_region("<name>")
+        auto _arg  = const_expr_t{ _name.c_str() };
+        auto _call = call_expr_t{ *m_register_func, snippet_vec_t{ &_arg } };
+        m_registrations.emplace_back(
+            std::make_shared<BPatch_arithExpr>(BPatch_assign, *_var, _call));
+        return (m_variables[_name] = _var);
+    }
+
+    address_space_t*      m_addr_space    = nullptr;
+    procedure_t*          m_register_func = nullptr;
+    BPatch_type*          m_type          = nullptr;
+    variable_map_t        m_variables     = {};
+    snippet_pointer_vec_t m_registrations = {};
+};
+
+inline omnitrace_region_ids&
+get_region_ids()
+{
+    static auto _v = omnitrace_region_ids{};
+    return _v;
+}
+//
+//======================================================================================//
+//
 struct omnitrace_snippet_vec
 {
     using entry_type = std::vector<omnitrace_call_expr>;
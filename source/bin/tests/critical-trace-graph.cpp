@@ -0,0 +1,274 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "critical-path.hpp"
+#include "graph-index.hpp"
+
+#include "library/critical_trace.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// builds the call-graph index and the critical paths of a synthetic call-chain with a
+// varying number of threads and verifies the results are identical for every thread
+// count and that the top critical paths match an exhaustive search. This test is
+// intended to be run with ThreadSanitizer
+
+namespace critical_trace = omnitrace::critical_trace;
+
+using critical_trace::call_chain;
+using critical_trace::call_graph_index;
+using critical_trace::critical_path;
+using critical_trace::Device;
+using critical_trace::entry;
+using critical_trace::Phase;
+
+namespace
+{
+// a random tree of calls spread across a few threads with a handful of duplicate
+// entries, entries which start at the same time, and calls which are also recorded
+// with a different parent (which makes the call-graph a DAG)
+call_chain
+generate(std::mt19937_64& _rng, size_t _n)
+{
+    auto _rand = [&_rng](int64_t _lo, int64_t _hi) {
+        return std::uniform_int_distribution<int64_t>{ _lo, _hi }(_rng);
+    };
+
+    std::vector<entry> _calls{};
+    _calls.reserve(_n);
+
+    auto _root       = entry{};
+    _root.phase      = Phase::DELTA;
+    _root.cpu_cid    = 1;
+    _root.parent_cid = static_cast<uint64_t>(-1);
+    _root.begin_ns   = 0;
+    _root.end_ns     = 100 * _n;
+    _root.hash       = 1;
+    _calls.emplace_back(_root);
+
+    for(size_t i = 1; i < _n; ++i)
+    {
+        const auto& _parent = _calls.at(_rand(0, i - 1));
+        auto        _v      = entry{};
+        _v.device           = (_rand(0, 7) == 0) ? Device::GPU : Device::CPU;
+        _v.phase            = Phase::DELTA;
+        _v.depth            = _parent.depth + 1;
+        _v.tid              = _rand(0, 7);
+        _v.cpu_cid          = i + 1;
+        _v.parent_cid       = _parent.cpu_cid;
+        _v.begin_ns         = _parent.begin_ns + _rand(0, 3);
+        _v.end_ns           = _v.begin_ns + _rand(1, 100);
+        _v.hash             = _rand(1, 16);
+        _calls.emplace_back(_v);
+    }
+
+    call_chain _chain{};
+    _chain.reserve(_n + (_n / 10));
+    for(size_t i = 0; i < _n; ++i)
+    {
+        const auto& _v = _calls.at(i);
+        _chain.emplace_back(_v);
+        if(_rand(0, 49) == 0) _chain.emplace_back(_v);
+        if(i > 1 && _rand(0, 99) == 0)
+        {
+            // ancestors always have a lower correlation id so this cannot create a
+            // cycle
+            auto _w       = _v;
+            _w.parent_cid = _calls.at(_rand(1, i - 1)).cpu_cid;
+            _chain.emplace_back(_w);
+        }
+    }
+
+    std::shuffle(_chain.begin(), _chain.end(), _rng);
+    return _chain;
+}
+
+auto
+get_parallel_for(size_t _nthreads)
+{
+    return [_nthreads](size_t _n, const std::function<void(size_t)>& _f) {
+        auto _threads = std::vector<std::thread>{};
+        for(size_t t = 0; t < _nthreads; ++t)
+        {
+            _threads.emplace_back([t, _n, _nthreads, &_f]() {
+                for(size_t i = t; i < _n; i += _nthreads)
+                    _f(i);
+            });
+        }
+        for(auto& itr : _threads)
+            itr.join();
+    };
+}
+
+call_graph_index
+get_index(const call_chain& _chain, size_t _nthreads)
+{
+    return call_graph_index{ _chain, _nthreads, get_parallel_for(_nthreads) };
+}
+
+std::vector<int64_t>
+get_costs(const std::vector<call_chain>& _paths)
+{
+    auto _v = std::vector<int64_t>{};
+    for(const auto& itr : _paths)
+        _v.emplace_back(itr.get_cost());
+    return _v;
+}
+
+// enumerates every path from a node without a parent to a node without children
+std::vector<int64_t>
+get_all_costs(const call_chain& _chain, const call_graph_index& _index)
+{
+    const size_t _n        = _index.nodes.size();
+    auto         _children = std::vector<std::vector<size_t>>(_n);
+    auto         _nparents = std::vector<size_t>(_n, 0);
+    for(size_t i = 0; i < _n; ++i)
+    {
+        auto& _v = _children.at(i);
+        _v       = _index.children.at(i);
+        std::sort(_v.begin(), _v.end());
+        _v.erase(std::unique(_v.begin(), _v.end()), _v.end());
+        for(auto itr : _v)
+            ++_nparents.at(itr);
+    }
+
+    auto _costs = std::vector<int64_t>{};
+    auto _stack = std::vector<std::pair<size_t, int64_t>>{};
+    for(size_t i = 0; i < _n; ++i)
+    {
+        if(_nparents.at(i) == 0) _stack.emplace_back(i, 0);
+    }
+
+    while(!_stack.empty())
+    {
+        auto _v = _stack.back();
+        _stack.pop_back();
+        auto _cost = _v.second + _chain.at(_index.nodes.at(_v.first)).get_cost();
+        if(_children.at(_v.first).empty()) _costs.emplace_back(_cost);
+        for(auto itr : _children.at(_v.first))
+            _stack.emplace_back(itr, _cost);
+    }
+
+    std::sort(_costs.begin(), _costs.end(), std::greater<int64_t>{});
+    return _costs;
+}
+
+// every child refers to its parent and the children are ordered by start time
+size_t
+validate(const call_chain& _chain, const call_graph_index& _index)
+{
+    size_t _nerror = 0;
+    for(size_t i = 0; i < _index.nodes.size(); ++i)
+    {
+        const auto& _parent = _chain.at(_index.nodes.at(i));
+        int64_t     _prev   = std::numeric_limits<int64_t>::min();
+        for(auto itr : _index.children.at(i))
+        {
+            const auto& _child = _chain.at(_index.nodes.at(itr));
+            if(_child.parent_cid != _parent.cpu_cid || _child.begin_ns < _prev)
+                ++_nerror;
+            _prev = _child.begin_ns;
+        }
+    }
+    return _nerror;
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    size_t _nsize = (argc > 1) ? std::stoul(argv[1]) : 100000;
+    auto   _seed  = (argc > 2) ? std::stoul(argv[2]) : std::random_device{}();
+
+    printf("[%s] size: %zu, seed: %lu\n", argv[0], _nsize,
+           static_cast<unsigned long>(_seed));
+
+    auto _rng   = std::mt19937_64{ _seed };
+    auto _chain = generate(_rng, _nsize);
+    auto _base  = get_index(_chain, 1);
+
+    size_t _nerror = validate(_chain, _base);
+    if(_nerror > 0) printf("[%s] %zu invalid children\n", argv[0], _nerror);
+
+    auto _base_paths = critical_path{ _chain, _base, 1, get_parallel_for(1) };
+    auto _base_top   = get_costs(_base_paths.get_top(100));
+
+    for(size_t _nthreads : { 2, 3, 4, 7, 8, 16 })
+    {
+        auto _index = get_index(_chain, _nthreads);
+        if(_index != _base)
+        {
+            printf("[%s] index with %zu threads mismatch\n", argv[0], _nthreads);
+            ++_nerror;
+        }
+
+        auto _paths =
+            critical_path{ _chain, _index, _nthreads, get_parallel_for(_nthreads) };
+        if(_paths.cost != _base_paths.cost || _paths.roots != _base_paths.roots ||
+           get_costs(_paths.get_top(100)) != _base_top)
+        {
+            printf("[%s] critical paths with %zu threads mismatch\n", argv[0],
+                   _nthreads);
+            ++_nerror;
+        }
+    }
+
+    // compare against an exhaustive search on a smaller call-chain
+    {
+        auto _small_chain = generate(_rng, 2000);
+        auto _small_index = get_index(_small_chain, 4);
+        auto _small_paths = critical_path{ _small_chain, _small_index, 4,
+                                           get_parallel_for(4) };
+        auto _expected    = get_all_costs(_small_chain, _small_index);
+        for(size_t _count : { size_t{ 1 }, size_t{ 10 }, _expected.size() })
+        {
+            auto _costs = get_costs(_small_paths.get_top(_count));
+            if(_costs.size() != _count ||
+               !std::equal(_costs.begin(), _costs.end(), _expected.begin()))
+            {
+                printf("[%s] top %zu critical paths mismatch\n", argv[0], _count);
+                ++_nerror;
+            }
+        }
+    }
+
+    if(_nerror > 0)
+    {
+        printf("[%s] %zu errors (seed: %lu)\n", argv[0], _nerror,
+               static_cast<unsigned long>(_seed));
+        return EXIT_FAILURE;
+    }
+
+    printf("[%s] call-graph index and critical paths are identical for all thread "
+           "counts\n",
+           argv[0]);
+    return EXIT_SUCCESS;
+}
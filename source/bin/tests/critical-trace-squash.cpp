@@ -0,0 +1,275 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "api.hpp"
+#include "library/critical_trace.hpp"
+#include "library/debug.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+// generates randomized call-chains and verifies that the hash-indexed
+// critical_trace::squash_critical_path and critical_trace::combine_critical_path
+// produce output identical to the original linear-search implementations
+
+namespace critical_trace = omnitrace::critical_trace;
+
+using critical_trace::call_chain;
+using critical_trace::Device;
+using critical_trace::entry;
+using critical_trace::Phase;
+
+namespace
+{
+// reference implementations which search the entire call-chain for a match
+template <typename FuncT>
+entry*
+find(const entry& _v, call_chain& _vec, FuncT&& _func)
+{
+    for(auto& itr : _vec)
+    {
+        if(std::forward<FuncT>(_func)(_v, itr)) return &itr;
+    }
+    return nullptr;
+}
+
+entry*
+find(const entry& _v, call_chain& _vec)
+{
+    return find(_v, _vec,
+                [](const entry& _lhs, const entry& _rhs) { return (_lhs == _rhs); });
+}
+
+void
+reference_squash(call_chain& _targ)
+{
+    auto _strict_equal = [](const entry& _lhs, const entry& _rhs) {
+        auto _same_phase  = (_lhs.phase == _rhs.phase);
+        bool _phase_check = true;
+        if(_same_phase) _phase_check = (_lhs.get_timestamp() == _rhs.get_timestamp());
+        return (_lhs == _rhs && _lhs.parent_cid == _rhs.parent_cid && _phase_check);
+    };
+
+    std::sort(_targ.begin(), _targ.end());
+
+    call_chain _squashed{};
+    for(auto& itr : _targ)
+    {
+        if(itr.phase == Phase::DELTA)
+        {
+            _squashed.emplace_back(itr);
+        }
+        else if(itr.phase == Phase::BEGIN)
+        {
+            if(!find(itr, _squashed, _strict_equal)) _squashed.emplace_back(itr);
+        }
+        else
+        {
+            entry* _match = nullptr;
+            if((_match = find(itr, _squashed)) != nullptr)
+                *_match += itr;
+            else
+                _squashed.emplace_back(itr);
+        }
+    }
+
+    std::swap(_targ, _squashed);
+    std::sort(_targ.begin(), _targ.end());
+}
+
+call_chain
+reference_combine(call_chain _chain)
+{
+    call_chain _delta{};
+    call_chain _begin{};
+    call_chain _end{};
+    for(auto& itr : _chain)
+    {
+        if(itr.phase == Phase::DELTA)
+            _delta.emplace_back(itr);
+        else if(itr.phase == Phase::BEGIN)
+            _begin.emplace_back(itr);
+        else if(itr.phase == Phase::END)
+        {
+            entry* _match = nullptr;
+            if((_match = find(itr, _begin)) != nullptr)
+                *_match += itr;
+            else
+                _end.emplace_back(itr);
+        }
+    }
+
+    call_chain _combined{};
+    _combined.reserve(_delta.size() + _begin.size() + _end.size());
+    for(auto& itr : _delta)
+        _combined.emplace_back(itr);
+    for(auto& itr : _begin)
+        _combined.emplace_back(itr);
+    for(auto& itr : _end)
+        _combined.emplace_back(itr);
+    std::sort(_combined.begin(), _combined.end());
+    return _combined;
+}
+
+// entry::operator== only compares a subset of the fields
+bool
+is_identical(const entry& _lhs, const entry& _rhs)
+{
+    return (_lhs == _rhs && _lhs.phase == _rhs.phase &&
+            _lhs.parent_cid == _rhs.parent_cid && _lhs.begin_ns == _rhs.begin_ns &&
+            _lhs.end_ns == _rhs.end_ns);
+}
+
+bool
+is_identical(const call_chain& _lhs, const call_chain& _rhs)
+{
+    if(_lhs.size() != _rhs.size()) return false;
+    for(size_t i = 0; i < _lhs.size(); ++i)
+        if(!is_identical(_lhs.at(i), _rhs.at(i))) return false;
+    return true;
+}
+
+// a small pool of correlation ids, thread ids, etc. is used so that the chains
+// contain duplicate begins, unmatched ends, and multiple candidates for a match
+call_chain
+generate(std::mt19937_64& _rng, size_t _n)
+{
+    auto _rand = [&_rng](int64_t _lo, int64_t _hi) {
+        return std::uniform_int_distribution<int64_t>{ _lo, _hi }(_rng);
+    };
+
+    call_chain _chain{};
+    _chain.reserve(2 * _n);
+    for(size_t i = 0; i < _n; ++i)
+    {
+        auto _v       = entry{};
+        _v.device     = (_rand(0, 3) == 0) ? Device::GPU : Device::CPU;
+        _v.priority   = _rand(0, 1);
+        _v.depth      = _rand(0, 4);
+        _v.devid      = _rand(0, 1);
+        _v.pid        = _rand(0, 1);
+        _v.tid        = _rand(0, 3);
+        _v.cpu_cid    = _rand(0, _n / 2);
+        _v.gpu_cid    = (_v.device == Device::GPU) ? _rand(1, 4) : 0;
+        _v.parent_cid = _rand(0, 2);
+        _v.queue_id   = _rand(0, 1);
+        _v.hash       = _rand(0, 3);
+        // every end timestamp is after every begin timestamp so that any begin/end
+        // pairing is valid
+        _v.begin_ns = _rand(0, 999);
+        _v.end_ns   = _rand(1000, 1999);
+
+        switch(_rand(0, 9))
+        {
+            case 0:
+            {
+                _v.phase = Phase::DELTA;
+                _chain.emplace_back(_v);
+                break;
+            }
+            case 1:
+            {
+                _v.phase = Phase::BEGIN;
+                _chain.emplace_back(_v);
+                break;
+            }
+            case 2:
+            {
+                _v.phase = Phase::END;
+                _chain.emplace_back(_v);
+                break;
+            }
+            case 3:
+            {
+                // duplicate begin
+                _v.phase = Phase::BEGIN;
+                _chain.emplace_back(_v);
+                _chain.emplace_back(_v);
+                break;
+            }
+            default:
+            {
+                _v.phase = Phase::BEGIN;
+                _chain.emplace_back(_v);
+                _v.phase = Phase::END;
+                _chain.emplace_back(_v);
+                break;
+            }
+        }
+    }
+
+    std::shuffle(_chain.begin(), _chain.end(), _rng);
+    return _chain;
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    omnitrace_init_library();
+
+    size_t _niter = (argc > 1) ? std::stoul(argv[1]) : 100;
+    size_t _nsize = (argc > 2) ? std::stoul(argv[2]) : 1000;
+    auto   _seed  = (argc > 3) ? std::stoul(argv[3]) : std::random_device{}();
+
+    OMNITRACE_BASIC_PRINT_F("iterations: %zu, size: %zu, seed: %lu\n", _niter, _nsize,
+                            static_cast<unsigned long>(_seed));
+
+    auto _rng    = std::mt19937_64{ _seed };
+    auto _nerror = size_t{ 0 };
+    for(size_t i = 0; i < _niter; ++i)
+    {
+        auto _chain = generate(_rng, _nsize);
+
+        auto _combine_ref = reference_combine(_chain);
+        auto _combine_val = critical_trace::combine_critical_path(_chain);
+        if(!is_identical(_combine_ref, _combine_val))
+        {
+            OMNITRACE_BASIC_PRINT_F("[%zu] combine_critical_path mismatch\n", i);
+            ++_nerror;
+        }
+
+        auto _squash_ref = _chain;
+        auto _squash_val = _chain;
+        reference_squash(_squash_ref);
+        critical_trace::squash_critical_path(_squash_val);
+        if(!is_identical(_squash_ref, _squash_val))
+        {
+            OMNITRACE_BASIC_PRINT_F("[%zu] squash_critical_path mismatch\n", i);
+            ++_nerror;
+        }
+    }
+
+    if(_nerror > 0)
+    {
+        OMNITRACE_BASIC_PRINT_F("%zu mismatches (seed: %lu)\n", _nerror,
+                                static_cast<unsigned long>(_seed));
+        return EXIT_FAILURE;
+    }
+
+    OMNITRACE_BASIC_PRINT_F("critical trace squash and combine validated\n");
+    return EXIT_SUCCESS;
+}
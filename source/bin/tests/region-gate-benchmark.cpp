@@ -0,0 +1,177 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "api.hpp"
+#include "library/components/category_region.hpp"
+#include "library/config.hpp"
+#include "library/debug.hpp"
+#include "library/region_gate.hpp"
+#include "library/runtime.hpp"
+#include "library/tracing.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+// measures the cost of deciding whether a region start/stop should be recorded with the
+// individual checks which category_region previously performed versus the single
+// thread-local region gate load, as well as the cost of complete push/pop pairs when
+// the thread is enabled and disabled
+
+namespace region_gate = omnitrace::region_gate;
+
+using omnitrace::State;
+using omnitrace::ThreadState;
+
+namespace
+{
+volatile uint64_t sink = 0;
+
+// the sequence of checks performed by category_region<...>::start before the gate
+uint64_t
+legacy_gate()
+{
+    using namespace omnitrace;
+
+    if(get_thread_state() == ThreadState::Disabled) return 0;
+    if(get_state() == State::Finalized) return 0;
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    if(get_state() != State::Active) return 0;
+
+    tracing::thread_init();
+    if(get_thread_state() == ThreadState::Disabled) return 0;
+    tracing::thread_init_sampling();
+
+    return static_cast<uint64_t>(get_use_perfetto()) +
+           static_cast<uint64_t>(get_use_timemory()) +
+           static_cast<uint64_t>(get_use_critical_trace());
+}
+
+uint64_t
+fast_gate()
+{
+    auto _gate = region_gate::load();
+    if(!(_gate & region_gate::Start))
+    {
+        if(_gate & region_gate::Skip) return 0;
+        _gate = region_gate::initialize_thread();
+        if(!(_gate & region_gate::Start)) return 0;
+    }
+
+    auto _internal = region_gate::scoped_internal{};
+    return static_cast<uint64_t>((_gate & region_gate::Perfetto) != 0) +
+           static_cast<uint64_t>((_gate & region_gate::Timemory) != 0) +
+           static_cast<uint64_t>((_gate & region_gate::CriticalTrace) != 0);
+}
+
+template <typename FuncT>
+double
+measure(size_t _n, FuncT&& _func)
+{
+    using clock_type = std::chrono::steady_clock;
+
+    auto _beg = clock_type::now();
+    for(size_t i = 0; i < _n; ++i)
+        std::forward<FuncT>(_func)();
+    auto _end = clock_type::now();
+    return std::chrono::duration<double, std::nano>(_end - _beg).count() /
+           static_cast<double>(_n);
+}
+
+void
+report(const char* _label, double _legacy, double _gate)
+{
+    OMNITRACE_BASIC_PRINT_F(
+        "%-24s :: legacy = %8.3f ns, gate = %8.3f ns, ratio = %.2fx\n", _label, _legacy,
+        _gate, (_gate > 0.0) ? _legacy / _gate : 0.0);
+}
+}  // namespace
+
+int
+main(int argc, char** argv)
+{
+    size_t _n = (argc > 1) ? std::stoul(argv[1]) : 1000000;
+
+    omnitrace_init_library();
+    omnitrace_init_hidden("trace", false, argv[0]);
+    omnitrace_push_trace_hidden("main");
+
+    using host_region_t =
+        omnitrace::component::category_region<omnitrace::category::host>;
+
+    auto _nerror = size_t{ 0 };
+    if(!(region_gate::get() & region_gate::Start))
+    {
+        OMNITRACE_BASIC_PRINT_F("error! region gate does not permit starting regions\n");
+        ++_nerror;
+    }
+
+    // warm-up
+    measure(_n / 10, []() { sink += legacy_gate() + fast_gate(); });
+
+    auto _enabled_legacy = measure(_n, []() { sink += legacy_gate(); });
+    auto _enabled_gate   = measure(_n, []() { sink += fast_gate(); });
+    auto _enabled_region = measure(_n, []() {
+        host_region_t::start("region-gate-benchmark");
+        host_region_t::stop("region-gate-benchmark");
+    });
+
+    omnitrace::set_thread_state(ThreadState::Disabled);
+    if(!(region_gate::get() & region_gate::Skip))
+    {
+        OMNITRACE_BASIC_PRINT_F(
+            "error! region gate was not updated for disabled thread\n");
+        ++_nerror;
+    }
+
+    auto _disabled_legacy = measure(_n, []() { sink += legacy_gate(); });
+    auto _disabled_gate   = measure(_n, []() { sink += fast_gate(); });
+    auto _disabled_region = measure(_n, []() {
+        host_region_t::start("region-gate-benchmark");
+        host_region_t::stop("region-gate-benchmark");
+    });
+
+    omnitrace::set_thread_state(ThreadState::Enabled);
+    if(!(region_gate::get() & region_gate::Start))
+    {
+        OMNITRACE_BASIC_PRINT_F(
+            "error! region gate was not updated for enabled thread\n");
+        ++_nerror;
+    }
+
+    OMNITRACE_BASIC_PRINT_F("iterations: %zu\n", _n);
+    report("enabled thread", _enabled_legacy, _enabled_gate);
+    report("disabled thread", _disabled_legacy, _disabled_gate);
+    OMNITRACE_BASIC_PRINT_F("%-24s :: enabled = %8.3f ns, disabled = %8.3f ns\n",
+                            "push/pop pair", _enabled_region, _disabled_region);
+
+    omnitrace_pop_trace_hidden("main");
+    omnitrace_finalize_hidden();
+
+    if(_nerror > 0) return EXIT_FAILURE;
+
+    OMNITRACE_BASIC_PRINT_F("region gate benchmark completed\n");
+    return EXIT_SUCCESS;
+}
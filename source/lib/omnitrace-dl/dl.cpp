@@ -224,6 +224,16 @@ struct OMNITRACE_HIDDEN_API indirect
         OMNITRACE_DLSYM(omnitrace_pop_trace_f, m_omnihandle, "omnitrace_pop_trace");
         OMNITRACE_DLSYM(omnitrace_push_region_f, m_omnihandle, "omnitrace_push_region");
         OMNITRACE_DLSYM(omnitrace_pop_region_f, m_omnihandle, "omnitrace_pop_region");
+        OMNITRACE_DLSYM(omnitrace_register_region_f, m_omnihandle,
+                        "omnitrace_register_region");
+        OMNITRACE_DLSYM(omnitrace_push_trace_id_f, m_omnihandle,
+                        "omnitrace_push_trace_id");
+        OMNITRACE_DLSYM(omnitrace_pop_trace_id_f, m_omnihandle, "omnitrace_pop_trace_id");
+        OMNITRACE_DLSYM(omnitrace_push_region_id_f, m_omnihandle,
+                        "omnitrace_push_region_id");
+        OMNITRACE_DLSYM(omnitrace_pop_region_id_f, m_omnihandle,
+                        "omnitrace_pop_region_id");
+        OMNITRACE_DLSYM(omnitrace_dump_trace_f, m_omnihandle, "omnitrace_dump_trace");
         OMNITRACE_DLSYM(omnitrace_register_source_f, m_omnihandle,
                         "omnitrace_register_source");
         OMNITRACE_DLSYM(omnitrace_register_coverage_f, m_omnihandle,
@@ -305,6 +315,16 @@ struct OMNITRACE_HIDDEN_API indirect
                 OMNITRACE_USER_REGION,
                 reinterpret_cast<void*>(&omnitrace_user_push_region_dl),
                 reinterpret_cast<void*>(&omnitrace_user_pop_region_dl));
+            (*omnitrace_user_configure_f)(
+                OMNITRACE_USER_REGION_ID,
+                reinterpret_cast<void*>(&omnitrace_user_push_region_id_dl),
+                reinterpret_cast<void*>(&omnitrace_user_pop_region_id_dl));
+            (*omnitrace_user_configure_f)(
+                OMNITRACE_USER_REGION_REGISTER,
+                reinterpret_cast<void*>(&omnitrace_user_register_region_dl), nullptr);
+            (*omnitrace_user_configure_f)(
+                OMNITRACE_USER_DUMP_TRACE,
+                reinterpret_cast<void*>(&omnitrace_user_dump_trace_dl), nullptr);
         }
     }
 
@@ -322,6 +342,12 @@ public:
     void (*omnitrace_pop_trace_f)(const char*)                              = nullptr;
     int (*omnitrace_push_region_f)(const char*)                             = nullptr;
     int (*omnitrace_pop_region_f)(const char*)                              = nullptr;
+    size_t (*omnitrace_register_region_f)(const char*)                      = nullptr;
+    void (*omnitrace_push_trace_id_f)(size_t)                               = nullptr;
+    void (*omnitrace_pop_trace_id_f)(size_t)                                = nullptr;
+    int (*omnitrace_push_region_id_f)(size_t)                               = nullptr;
+    int (*omnitrace_pop_region_id_f)(size_t)                                = nullptr;
+    int (*omnitrace_dump_trace_f)(void)                                     = nullptr;
     int (*omnitrace_user_configure_f)(int, void*, void*)                    = nullptr;
 
     // KokkosP functions
@@ -586,6 +612,70 @@ extern "C"
         }
     }
 
+    size_t omnitrace_register_region(const char* name)
+    {
+        // registration only interns the name so it is permitted before initialization
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_region_f, name);
+    }
+
+    void omnitrace_push_trace_id(size_t id)
+    {
+        if(!dl::get_active()) return;
+        if(dl::get_thread_enabled())
+        {
+            OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_trace_id_f, id);
+        }
+        else
+        {
+            ++dl::get_thread_count();
+        }
+    }
+
+    void omnitrace_pop_trace_id(size_t id)
+    {
+        if(!dl::get_active()) return;
+        if(dl::get_thread_enabled())
+        {
+            OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_trace_id_f, id);
+        }
+        else
+        {
+            if(dl::get_thread_count()-- == 0) omnitrace_user_start_thread_trace_dl();
+        }
+    }
+
+    void omnitrace_push_region_id(size_t id)
+    {
+        if(!dl::get_active()) return;
+        if(dl::get_thread_enabled())
+        {
+            OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_region_id_f, id);
+        }
+        else
+        {
+            ++dl::get_thread_count();
+        }
+    }
+
+    void omnitrace_pop_region_id(size_t id)
+    {
+        if(!dl::get_active()) return;
+        if(dl::get_thread_enabled())
+        {
+            OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_region_id_f, id);
+        }
+        else
+        {
+            if(dl::get_thread_count()-- == 0) omnitrace_user_start_thread_trace_dl();
+        }
+    }
+
+    int omnitrace_dump_trace(void)
+    {
+        // snapshots are requested regardless of whether tracing is currently enabled
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_dump_trace_f);
+    }
+
     void omnitrace_set_env(const char* a, const char* b)
     {
         if(dl::get_inited() && dl::get_active())
@@ -658,6 +748,30 @@ extern "C"
         return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_region_f, name);
     }
 
+    int omnitrace_user_register_region_dl(const char* name, size_t* id)
+    {
+        if(!id) return -1;
+        *id = OMNITRACE_DL_INVOKE(get_indirect().omnitrace_register_region_f, name);
+        return (*id == 0) ? -1 : 0;
+    }
+
+    int omnitrace_user_push_region_id_dl(size_t id)
+    {
+        if(!dl::get_active()) return 0;
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_push_region_id_f, id);
+    }
+
+    int omnitrace_user_pop_region_id_dl(size_t id)
+    {
+        if(!dl::get_active()) return 0;
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_pop_region_id_f, id);
+    }
+
+    int omnitrace_user_dump_trace_dl(void)
+    {
+        return OMNITRACE_DL_INVOKE(get_indirect().omnitrace_dump_trace_f);
+    }
+
     //----------------------------------------------------------------------------------//
     //
     //      KokkosP
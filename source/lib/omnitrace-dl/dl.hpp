@@ -75,6 +75,12 @@ extern "C"
     void omnitrace_pop_trace(const char* name) OMNITRACE_PUBLIC_API;
     void omnitrace_push_region(const char*) OMNITRACE_PUBLIC_API;
     void omnitrace_pop_region(const char*) OMNITRACE_PUBLIC_API;
+    size_t omnitrace_register_region(const char*) OMNITRACE_PUBLIC_API;
+    void omnitrace_push_trace_id(size_t) OMNITRACE_PUBLIC_API;
+    void omnitrace_pop_trace_id(size_t) OMNITRACE_PUBLIC_API;
+    void omnitrace_push_region_id(size_t) OMNITRACE_PUBLIC_API;
+    void omnitrace_pop_region_id(size_t) OMNITRACE_PUBLIC_API;
+    int omnitrace_dump_trace(void) OMNITRACE_PUBLIC_API;
     void omnitrace_register_source(const char* file, const char* func, size_t line,
                                    size_t      address,
                                    const char* source) OMNITRACE_PUBLIC_API;
@@ -91,6 +97,11 @@ extern "C"
     int omnitrace_user_push_region_dl(const char*) OMNITRACE_HIDDEN_API;
     int omnitrace_user_pop_region_dl(const char*) OMNITRACE_HIDDEN_API;
 
+    int omnitrace_user_register_region_dl(const char*, size_t*) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_push_region_id_dl(size_t) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_pop_region_id_dl(size_t) OMNITRACE_HIDDEN_API;
+    int omnitrace_user_dump_trace_dl(void) OMNITRACE_HIDDEN_API;
+
     // KokkosP
     struct OMNITRACE_HIDDEN_API SpaceHandle
     {
@@ -45,6 +45,8 @@
 #    endif
 #endif
 
+#include <stddef.h>
+
 #if defined(__cplusplus)
 extern "C"
 {
@@ -98,6 +100,12 @@ extern "C"
         OMNITRACE_USER_START_STOP_THREAD,  ///< Function pointers which control per-thread
                                            ///< start/stop
         OMNITRACE_USER_REGION,  ///< Function pointers which generate user-defined regions
+        OMNITRACE_USER_REGION_ID,  ///< Function pointers which generate pre-registered
+                                   ///< user-defined regions
+        OMNITRACE_USER_REGION_REGISTER,  ///< Function pointer which registers a
+                                         ///< user-defined region (end_func is unused)
+        OMNITRACE_USER_DUMP_TRACE,  ///< Function pointer which requests a snapshot of
+                                    ///< the trace (end_func is unused)
         OMNITRACE_USER_BINDINGS_LAST
     };
 
@@ -140,6 +148,38 @@ extern "C"
     /// results in timemory vs. perfetto.
     extern int omnitrace_user_pop_region(const char*) OMNITRACE_PUBLIC_API;
 
+    /// @fn int omnitrace_user_register_region(const char* name, size_t* id)
+    /// @param[in] name The string identifier for the region
+    /// @param[out] id The integer identifier for the region
+    /// @return @ref OMNITRACE_USER_ERROR value
+    /// @brief Register a user defined region once so that it can be started and ended
+    /// via @ref omnitrace_user_push_region_id and @ref omnitrace_user_pop_region_id.
+    /// These avoid processing the string identifier on every call and are thus
+    /// preferred for regions which are entered frequently. Registering the same name
+    /// multiple times returns the same identifier.
+    extern int omnitrace_user_register_region(const char*, size_t*) OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_push_region_id(size_t id)
+    /// @param id The identifier returned by @ref omnitrace_user_register_region
+    /// @return @ref OMNITRACE_USER_ERROR value
+    /// @brief Start a pre-registered user defined region.
+    extern int omnitrace_user_push_region_id(size_t) OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_pop_region_id(size_t id)
+    /// @param id The identifier returned by @ref omnitrace_user_register_region
+    /// @return @ref OMNITRACE_USER_ERROR value
+    /// @brief End a pre-registered user defined region. The same ordering caveats as
+    /// @ref omnitrace_user_pop_region apply.
+    extern int omnitrace_user_pop_region_id(size_t) OMNITRACE_PUBLIC_API;
+
+    /// @fn int omnitrace_user_dump_trace(void)
+    /// @return @ref OMNITRACE_USER_ERROR value
+    /// @brief Request a snapshot of the perfetto trace while tracing continues. This
+    /// requires OMNITRACE_PERFETTO_FLIGHT_RECORDER to be enabled: the snapshot is
+    /// written to a new numbered file by a background thread and only contains the
+    /// events recorded since the previous snapshot.
+    extern int omnitrace_user_dump_trace(void) OMNITRACE_PUBLIC_API;
+
     /// @fn int omnitrace_user_configure(int category, void* begin_func, void* end_func)
     /// @param category An @ref OMNITRACE_USER_BINDINGS value
     /// @param begin_func The pointer to the function which corresponds to "starting" the
@@ -33,6 +33,8 @@ namespace
 {
 using trace_func_t  = int (*)(void);
 using region_func_t = int (*)(const char*);
+using rid_func_t    = int (*)(size_t);
+using reg_func_t    = int (*)(const char*, size_t*);
 
 trace_func_t  _start_trace        = nullptr;
 trace_func_t  _stop_trace         = nullptr;
@@ -40,6 +42,10 @@ trace_func_t  _start_thread_trace = nullptr;
 trace_func_t  _stop_thread_trace  = nullptr;
 region_func_t _push_region        = nullptr;
 region_func_t _pop_region         = nullptr;
+rid_func_t    _push_region_id     = nullptr;
+rid_func_t    _pop_region_id      = nullptr;
+reg_func_t    _register_region    = nullptr;
+trace_func_t  _dump_trace         = nullptr;
 
 const char*
 as_string(OMNITRACE_USER_BINDINGS _category)
@@ -49,6 +55,9 @@ as_string(OMNITRACE_USER_BINDINGS _category)
         case OMNITRACE_USER_START_STOP: return "OMNITRACE_USER_START_STOP";
         case OMNITRACE_USER_START_STOP_THREAD: return "OMNITRACE_USER_START_STOP_THREAD";
         case OMNITRACE_USER_REGION: return "OMNITRACE_USER_REGION";
+        case OMNITRACE_USER_REGION_ID: return "OMNITRACE_USER_REGION_ID";
+        case OMNITRACE_USER_REGION_REGISTER: return "OMNITRACE_USER_REGION_REGISTER";
+        case OMNITRACE_USER_DUMP_TRACE: return "OMNITRACE_USER_DUMP_TRACE";
         default:
         {
             fprintf(stderr, "[omnitrace][user] Unknown user binding category: %i\n",
@@ -78,6 +87,14 @@ extern "C"
     int omnitrace_user_stop_thread_trace(void) { return invoke(_stop_thread_trace); }
     int omnitrace_user_push_region(const char* id) { return invoke(_push_region, id); }
     int omnitrace_user_pop_region(const char* id) { return invoke(_pop_region, id); }
+    int omnitrace_user_push_region_id(size_t id) { return invoke(_push_region_id, id); }
+    int omnitrace_user_pop_region_id(size_t id) { return invoke(_pop_region_id, id); }
+    int omnitrace_user_dump_trace(void) { return invoke(_dump_trace); }
+
+    int omnitrace_user_register_region(const char* name, size_t* id)
+    {
+        return invoke(_register_region, name, id);
+    }
 
     int omnitrace_user_configure(int category, void* begin_func, void* end_func)
     {
@@ -103,6 +120,23 @@ extern "C"
                 if(end_func) _pop_region = reinterpret_cast<region_func_t>(end_func);
                 break;
             }
+            case OMNITRACE_USER_REGION_ID:
+            {
+                if(begin_func) _push_region_id = reinterpret_cast<rid_func_t>(begin_func);
+                if(end_func) _pop_region_id = reinterpret_cast<rid_func_t>(end_func);
+                break;
+            }
+            case OMNITRACE_USER_REGION_REGISTER:
+            {
+                if(begin_func)
+                    _register_region = reinterpret_cast<reg_func_t>(begin_func);
+                break;
+            }
+            case OMNITRACE_USER_DUMP_TRACE:
+            {
+                if(begin_func) _dump_trace = reinterpret_cast<trace_func_t>(begin_func);
+                break;
+            }
             default:
             {
                 return OMNITRACE_USER_ERROR_INVALID_CATEGORY;
@@ -134,6 +168,24 @@ extern "C"
                 if(end_func) *end_func = reinterpret_cast<void*>(_pop_region);
                 break;
             }
+            case OMNITRACE_USER_REGION_ID:
+            {
+                if(begin_func) *begin_func = reinterpret_cast<void*>(_push_region_id);
+                if(end_func) *end_func = reinterpret_cast<void*>(_pop_region_id);
+                break;
+            }
+            case OMNITRACE_USER_REGION_REGISTER:
+            {
+                if(begin_func) *begin_func = reinterpret_cast<void*>(_register_region);
+                if(end_func) *end_func = nullptr;
+                break;
+            }
+            case OMNITRACE_USER_DUMP_TRACE:
+            {
+                if(begin_func) *begin_func = reinterpret_cast<void*>(_dump_trace);
+                if(end_func) *end_func = nullptr;
+                break;
+            }
             default:
             {
                 return OMNITRACE_USER_ERROR_INVALID_CATEGORY;
@@ -66,6 +66,72 @@ omnitrace_pop_region(const char* _name)
     return 0;
 }
 
+extern "C" size_t
+omnitrace_register_region(const char* _name)
+{
+    try
+    {
+        return omnitrace_register_region_hidden(_name);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_VERBOSE_F(1, "Exception caught: %s\n", _e.what());
+    }
+    return 0;
+}
+
+extern "C" void
+omnitrace_push_trace_id(size_t _id)
+{
+    omnitrace_push_trace_id_hidden(_id);
+}
+
+extern "C" void
+omnitrace_pop_trace_id(size_t _id)
+{
+    omnitrace_pop_trace_id_hidden(_id);
+}
+
+extern "C" int
+omnitrace_push_region_id(size_t _id)
+{
+    try
+    {
+        omnitrace_push_region_id_hidden(_id);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_VERBOSE_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" int
+omnitrace_pop_region_id(size_t _id)
+{
+    try
+    {
+        omnitrace_pop_region_id_hidden(_id);
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_VERBOSE_F(1, "Exception caught: %s\n", _e.what());
+        return -1;
+    }
+    return 0;
+}
+
+extern "C" int
+omnitrace_dump_trace(void)
+{
+    try
+    {
+        return (omnitrace_dump_trace_hidden()) ? 0 : -1;
+    } catch(std::exception& _e)
+    {
+        OMNITRACE_VERBOSE_F(1, "Exception caught: %s\n", _e.what());
+    }
+    return -1;
+}
+
 extern "C" void
 omnitrace_init_library(void)
 {
@@ -59,6 +59,25 @@ extern "C"
     /// stops an instrumentation region (user-defined)
     int omnitrace_pop_region(const char* name) OMNITRACE_PUBLIC_API;
 
+    /// registers an instrumentation region and returns its identifier (zero on failure)
+    size_t omnitrace_register_region(const char* name) OMNITRACE_PUBLIC_API;
+
+    /// starts a registered instrumentation region
+    void omnitrace_push_trace_id(size_t id) OMNITRACE_PUBLIC_API;
+
+    /// stops a registered instrumentation region
+    void omnitrace_pop_trace_id(size_t id) OMNITRACE_PUBLIC_API;
+
+    /// starts a registered instrumentation region (user-defined)
+    int omnitrace_push_region_id(size_t id) OMNITRACE_PUBLIC_API;
+
+    /// stops a registered instrumentation region (user-defined)
+    int omnitrace_pop_region_id(size_t id) OMNITRACE_PUBLIC_API;
+
+    /// requests a snapshot of the perfetto trace when the flight recorder is enabled.
+    /// Returns zero if the snapshot was requested
+    int omnitrace_dump_trace(void) OMNITRACE_PUBLIC_API;
+
     /// stores source code information
     void omnitrace_register_source(const char* file, const char* func, size_t line,
                                    size_t      address,
@@ -80,6 +99,12 @@ extern "C"
     void omnitrace_pop_trace_hidden(const char* name) OMNITRACE_HIDDEN_API;
     void omnitrace_push_region_hidden(const char* name) OMNITRACE_HIDDEN_API;
     void omnitrace_pop_region_hidden(const char* name) OMNITRACE_HIDDEN_API;
+    size_t omnitrace_register_region_hidden(const char* name) OMNITRACE_HIDDEN_API;
+    void omnitrace_push_trace_id_hidden(size_t id) OMNITRACE_HIDDEN_API;
+    void omnitrace_pop_trace_id_hidden(size_t id) OMNITRACE_HIDDEN_API;
+    void omnitrace_push_region_id_hidden(size_t id) OMNITRACE_HIDDEN_API;
+    void omnitrace_pop_region_id_hidden(size_t id) OMNITRACE_HIDDEN_API;
+    bool omnitrace_dump_trace_hidden(void) OMNITRACE_HIDDEN_API;
     void omnitrace_register_source_hidden(const char* file, const char* func, size_t line,
                                           size_t      address,
                                           const char* source) OMNITRACE_HIDDEN_API;
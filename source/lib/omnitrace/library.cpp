@@ -23,6 +23,7 @@
 #include "api.hpp"
 #include "common/setup.hpp"
 #include "library/components/category_region.hpp"
+#include "library/components/comm_data.hpp"
 #include "library/components/exit_gotcha.hpp"
 #include "library/components/fork_gotcha.hpp"
 #include "library/components/fwd.hpp"
@@ -34,19 +35,27 @@
 #include "library/critical_trace.hpp"
 #include "library/debug.hpp"
 #include "library/defines.hpp"
+#include "library/event_buffer.hpp"
+#include "library/flight_recorder.hpp"
 #include "library/gpu.hpp"
+#include "library/lock_contention.hpp"
 #include "library/ompt.hpp"
+#include "library/overhead.hpp"
 #include "library/process_sampler.hpp"
 #include "library/ptl.hpp"
 #include "library/rcclp.hpp"
+#include "library/region_table.hpp"
 #include "library/rocprofiler.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 #include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
+#include "library/throttle.hpp"
 #include "library/timemory.hpp"
+#include "library/timestamp.hpp"
 #include "library/tracing.hpp"
 
+#include <timemory/backends/mpi.hpp>
 #include <timemory/hash/types.hpp>
 #include <timemory/operations/types/file_output_message.hpp>
 #include <timemory/sampling/signals.hpp>
@@ -58,6 +67,10 @@
 #include <mutex>
 #include <string_view>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 using namespace omnitrace;
 
 //======================================================================================//
@@ -105,6 +118,264 @@ is_system_backend()
     return (get_backend() != "inprocess");
 }
 
+// file which perfetto periodically writes the trace into when streaming
+struct perfetto_stream
+{
+    int         fd       = -1;
+    std::string filename = {};
+};
+
+auto&
+get_perfetto_stream()
+{
+    static auto _v = perfetto_stream{};
+    return _v;
+}
+
+bool
+open_perfetto_stream()
+{
+    auto& _stream    = get_perfetto_stream();
+    _stream.filename = get_perfetto_output_filename();
+
+    // creates the output directory if necessary
+    std::ofstream ofs{};
+    if(!tim::filepath::open(ofs, _stream.filename, std::ios::out | std::ios::binary))
+        return false;
+    ofs.close();
+
+    _stream.fd = ::open(_stream.filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    return (_stream.fd >= 0);
+}
+
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+struct combined_perfetto_output
+{
+    bool        root     = false;
+    bool        error    = false;
+    size_t      size     = 0;
+    std::string filename = {};
+};
+
+// concatenated perfetto traces are a valid perfetto trace so instead of gathering the
+// traces onto one rank, each rank writes its trace directly into the combined file at
+// the offset given by the exclusive prefix sum of the trace sizes. Thus no rank holds
+// more than its own trace in memory.
+combined_perfetto_output
+write_combined_perfetto(const std::vector<char>& _data)
+{
+    auto _ret  = combined_perfetto_output{};
+    auto _comm = MPI_Comm{ MPI_COMM_WORLD };
+    int  _rank = 0;
+    int  _size = 1;
+    PMPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+    PMPI_Comm_size(MPI_COMM_WORLD, &_size);
+
+    // one combined trace per node when the node count is specified
+    auto _nnodes = std::max<int64_t>(std::min<int64_t>(settings::node_count(), _size), 1);
+    if(_nnodes > 1)
+    {
+        auto _color = static_cast<int>((_rank * _nnodes) / _size);
+        PMPI_Comm_split(MPI_COMM_WORLD, _color, _rank, &_comm);
+    }
+
+    int _local_rank = 0;
+    PMPI_Comm_rank(_comm, &_local_rank);
+    _ret.root = (_local_rank == 0);
+
+    // every rank uses the filename of the root rank
+    _ret.filename = get_perfetto_output_filename();
+    auto _len     = static_cast<unsigned long long>(_ret.filename.length());
+    PMPI_Bcast(&_len, 1, MPI_UNSIGNED_LONG_LONG, 0, _comm);
+    _ret.filename.resize(_len);
+    PMPI_Bcast(_ret.filename.data(), static_cast<int>(_len), MPI_CHAR, 0, _comm);
+
+    auto _nbytes = static_cast<unsigned long long>(_data.size());
+    auto _offset = 0ULL;
+    auto _total  = 0ULL;
+    PMPI_Exscan(&_nbytes, &_offset, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, _comm);
+    PMPI_Allreduce(&_nbytes, &_total, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, _comm);
+    // the result of the exclusive scan is undefined on the first rank
+    if(_ret.root) _offset = 0;
+    _ret.size = _total;
+
+    if(_total > 0)
+    {
+        // creates the output directory if necessary
+        if(_ret.root)
+        {
+            std::ofstream ofs{};
+            if(tim::filepath::open(ofs, _ret.filename, std::ios::out | std::ios::binary))
+                ofs.close();
+        }
+        PMPI_Barrier(_comm);
+
+        MPI_File _fh  = {};
+        int      _err = PMPI_File_open(_comm, _ret.filename.c_str(),
+                                       MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL,
+                                       &_fh);
+        if(_err == MPI_SUCCESS)
+        {
+            PMPI_File_set_size(_fh, static_cast<MPI_Offset>(_total));
+            // the count argument is an int so large traces are written in chunks
+            constexpr size_t _chunk = (1UL << 30);
+            for(size_t i = 0; i < _data.size() && _err == MPI_SUCCESS; i += _chunk)
+            {
+                auto _n = std::min<size_t>(_chunk, _data.size() - i);
+                _err    = PMPI_File_write_at(_fh, static_cast<MPI_Offset>(_offset + i),
+                                             _data.data() + i, static_cast<int>(_n),
+                                             MPI_BYTE, MPI_STATUS_IGNORE);
+            }
+            PMPI_File_close(&_fh);
+        }
+        _ret.error = (_err != MPI_SUCCESS);
+    }
+
+    if(_comm != MPI_COMM_WORLD) PMPI_Comm_free(&_comm);
+    return _ret;
+}
+#endif
+
+// stops the perfetto tracing session and writes the trace. Returns false if the
+// output file could not be written
+bool
+finalize_perfetto()
+{
+    bool _perfetto_output_error = false;
+    bool _perfetto_combined     = false;
+
+    auto& tracing_session = tracing::get_trace_session();
+
+    OMNITRACE_CI_THROW(tracing_session == nullptr, "Null pointer to the tracing session");
+
+    OMNITRACE_VERBOSE_F(0, "Finalizing perfetto...\n");
+
+    // Make sure the last event is closed for this example.
+    perfetto::TrackEvent::Flush();
+    tracing_session->FlushBlocking();
+
+    OMNITRACE_VERBOSE_F(3, "Stopping the blocking perfetto trace session...\n");
+    tracing_session->StopBlocking();
+
+    using char_vec_t = std::vector<char>;
+    OMNITRACE_VERBOSE_F(3, "Getting the trace data...\n");
+
+    auto trace_data = char_vec_t{};
+    if(get_perfetto_stream().fd >= 0)
+    {
+        // perfetto has already written the trace into the file
+        auto& _stream = get_perfetto_stream();
+        ::close(_stream.fd);
+        _stream.fd = -1;
+
+        // the output filename may have changed since initialization, e.g. MPI
+        // was initialized afterwards and the filename now has a rank suffix
+        auto _fname = get_perfetto_output_filename();
+        if(_fname != _stream.filename &&
+           std::rename(_stream.filename.c_str(), _fname.c_str()) != 0)
+        {
+            OMNITRACE_VERBOSE_F(0, "Error renaming '%s' to '%s'...\n",
+                                _stream.filename.c_str(), _fname.c_str());
+            _fname = _stream.filename;
+        }
+
+        struct stat _stat = {};
+        auto        _size = (::stat(_fname.c_str(), &_stat) == 0)
+                                ? static_cast<double>(_stat.st_size)
+                                : 0.0;
+
+        operation::file_output_message<tim::project::omnitrace> _fom{};
+        if(get_verbose() >= 0)
+            _fom(_fname, std::string{ "perfetto" },
+                 " (%.2f KB / %.2f MB / %.2f GB)... ", _size / units::KB,
+                 _size / units::MB, _size / units::GB);
+        if(get_verbose() >= 0) _fom.append("%s", "Done");  // NOLINT
+        auto _manager = tim::manager::instance();
+        if(_manager) _manager->add_file_output("protobuf", "perfetto", _fname);
+    }
+#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
+    else if(get_perfetto_combined_traces() && tim::mpi::is_initialized() &&
+            !tim::mpi::is_finalized())
+    {
+        auto _combined = write_combined_perfetto(tracing_session->ReadTraceBlocking());
+        if(_combined.root && _combined.size > 0)
+        {
+            auto _size = static_cast<double>(_combined.size);
+            operation::file_output_message<tim::project::omnitrace> _fom{};
+            if(get_verbose() >= 0)
+                _fom(_combined.filename, std::string{ "perfetto" },
+                     " (%.2f KB / %.2f MB / %.2f GB)... ", _size / units::KB,
+                     _size / units::MB, _size / units::GB);
+            if(_combined.error)
+            {
+                _fom.append("Error writing '%s'...", _combined.filename.c_str());
+                _perfetto_output_error = true;
+            }
+            else
+            {
+                if(get_verbose() >= 0) _fom.append("%s", "Done");  // NOLINT
+                auto _manager = tim::manager::instance();
+                if(_manager)
+                    _manager->add_file_output("protobuf", "perfetto", _combined.filename);
+            }
+        }
+        else if(_combined.root)
+        {
+            OMNITRACE_VERBOSE_F(
+                0, "trace data is empty. File '%s' will not be written...\n",
+                _combined.filename.c_str());
+        }
+        _perfetto_combined = true;
+    }
+    else
+    {
+        trace_data = tracing_session->ReadTraceBlocking();
+    }
+#else
+    else
+    {
+        trace_data = tracing_session->ReadTraceBlocking();
+    }
+#endif
+
+    if(!trace_data.empty())
+    {
+        operation::file_output_message<tim::project::omnitrace> _fom{};
+        // Write the trace into a file.
+        if(get_verbose() >= 0)
+            _fom(get_perfetto_output_filename(), std::string{ "perfetto" },
+                 " (%.2f KB / %.2f MB / %.2f GB)... ",
+                 static_cast<double>(trace_data.size()) / units::KB,
+                 static_cast<double>(trace_data.size()) / units::MB,
+                 static_cast<double>(trace_data.size()) / units::GB);
+        std::ofstream ofs{};
+        if(!tim::filepath::open(ofs, get_perfetto_output_filename(),
+                                std::ios::out | std::ios::binary))
+        {
+            _fom.append("Error opening '%s'...", get_perfetto_output_filename().c_str());
+            _perfetto_output_error = true;
+        }
+        else
+        {
+            // Write the trace into a file.
+            ofs.write(&trace_data[0], trace_data.size());
+            if(get_verbose() >= 0) _fom.append("%s", "Done");  // NOLINT
+            auto _manager = tim::manager::instance();
+            if(_manager)
+                _manager->add_file_output("protobuf", "perfetto",
+                                          get_perfetto_output_filename());
+        }
+        ofs.close();
+    }
+    else if(dmp::rank() == 0 && !get_perfetto_streaming() && !_perfetto_combined)
+    {
+        OMNITRACE_VERBOSE_F(0, "trace data is empty. File '%s' will not be written...\n",
+                            get_perfetto_output_filename().c_str());
+    }
+
+    return !_perfetto_output_error;
+}
+
 using Device = critical_trace::Device;
 using Phase  = critical_trace::Phase;
 }  // namespace
@@ -147,6 +418,53 @@ omnitrace_pop_region_hidden(const char* name)
 ///
 //======================================================================================//
 
+extern "C" size_t
+omnitrace_register_region_hidden(const char* name)
+{
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    return region_table::register_region(name);
+}
+
+extern "C" void
+omnitrace_push_trace_id_hidden(size_t id)
+{
+    const auto* _info = region_table::find(id);
+    if(_info) component::category_region<category::host>::start(*_info);
+}
+
+extern "C" void
+omnitrace_pop_trace_id_hidden(size_t id)
+{
+    const auto* _info = region_table::find(id);
+    if(_info) component::category_region<category::host>::stop(*_info);
+}
+
+extern "C" void
+omnitrace_push_region_id_hidden(size_t id)
+{
+    const auto* _info = region_table::find(id);
+    if(_info) component::category_region<category::user>::start(*_info);
+}
+
+extern "C" void
+omnitrace_pop_region_id_hidden(size_t id)
+{
+    const auto* _info = region_table::find(id);
+    if(_info) component::category_region<category::user>::stop(*_info);
+}
+
+extern "C" bool
+omnitrace_dump_trace_hidden(void)
+{
+    return flight_recorder::request();
+}
+
+//======================================================================================//
+///
+///
+///
+//======================================================================================//
+
 namespace
 {
 struct set_env_s  // NOLINT
@@ -330,6 +648,9 @@ omnitrace_init_tooling_hidden()
 
     omnitrace_init_library_hidden();
 
+    // select the timestamp source before any timestamps are recorded by the tooling
+    timestamp::initialize();
+
     OMNITRACE_DEBUG_F("\n");
 
     auto _dtor = scope::destructor{ []() {
@@ -415,6 +736,14 @@ omnitrace_init_tooling_hidden()
         buffer_config->set_size_kb(buffer_size);
         buffer_config->set_fill_policy(_policy);
 
+        if(get_perfetto_streaming())
+        {
+            // periodically drain the buffer into the output file
+            cfg.set_write_into_file(true);
+            cfg.set_file_write_period_ms(get_perfetto_streaming_period());
+            cfg.set_flush_period_ms(get_perfetto_streaming_period());
+        }
+
         std::set<std::string> _available_categories = {};
         std::set<std::string> _disabled_categories  = {};
         for(auto itr : { OMNITRACE_PERFETTO_CATEGORIES })
@@ -458,6 +787,10 @@ omnitrace_init_tooling_hidden()
         rcclp::setup();
     }
 
+    // measure the cost of the instrumentation before any region is recorded and before
+    // the trace session is started
+    if(overhead::enabled()) overhead::calibrate(cfg);
+
     if(get_use_perfetto() && !is_system_backend())
     {
 #if defined(CUSTOM_DATA_SOURCE)
@@ -476,10 +809,29 @@ omnitrace_init_tooling_hidden()
 #endif
         auto& tracing_session = tracing::get_trace_session();
         tracing_session       = perfetto::Tracing::NewTrace();
-        tracing_session->Setup(cfg);
+        if(get_perfetto_streaming() && open_perfetto_stream())
+        {
+            OMNITRACE_VERBOSE_F(1, "Streaming perfetto trace to '%s'...\n",
+                                get_perfetto_stream().filename.c_str());
+            tracing_session->Setup(cfg, get_perfetto_stream().fd);
+        }
+        else
+        {
+            OMNITRACE_CONDITIONAL_PRINT_F(get_perfetto_streaming(),
+                                          "Error opening '%s' for streaming perfetto "
+                                          "output. Trace will be written at exit...\n",
+                                          get_perfetto_stream().filename.c_str());
+            tracing_session->Setup(cfg);
+        }
         tracing_session->StartBlocking();
     }
 
+    if(get_use_perfetto() && get_perfetto_flight_recorder())
+    {
+        OMNITRACE_VERBOSE_F(1, "Setting up the perfetto flight recorder...\n");
+        flight_recorder::setup(cfg);
+    }
+
     // if static objects are destroyed in the inverse order of when they are
     // created this should ensure that finalization is called before perfetto
     // ends the tracing session
@@ -586,7 +938,7 @@ omnitrace_finalize_hidden(void)
     if(get_verbose() >= 0 || get_debug()) fprintf(stderr, "\n");
 
     OMNITRACE_VERBOSE_F(0, "finalizing...\n");
-    thread_info::set_stop(comp::wall_clock::record());
+    thread_info::set_stop(tracing::now());
 
     tim::sampling::block_signals(get_sampling_signals(),
                                  tim::sampling::sigmask_scope::process);
@@ -628,24 +980,8 @@ omnitrace_finalize_hidden(void)
     OMNITRACE_VERBOSE_F(1, "omnitrace_pop_trace  :: called %zux\n", _pop_count);
 
     OMNITRACE_DEBUG_F("Copying over all timemory hash information to main thread...\n");
-    // copy these over so that all hashes are known
-    auto& _hzero = tracing::get_timemory_hash_ids(0);
-    auto& _azero = tracing::get_timemory_hash_aliases(0);
-    for(size_t i = 1; i < max_supported_threads; ++i)
-    {
-        auto& _hitr = tracing::get_timemory_hash_ids(i);
-        auto& _aitr = tracing::get_timemory_hash_aliases(i);
-        if(_hzero && _hitr)
-        {
-            for(const auto& itr : *_hitr)
-                _hzero->emplace(itr.first, itr.second);
-        }
-        if(_azero && _aitr)
-        {
-            for(auto itr : *_aitr)
-                _azero->emplace(itr.first, itr.second);
-        }
-    }
+    // the string table contains the names from every thread
+    tracing::copy_timemory_hash_ids();
 
     // stop the main bundle which has stats for run
     if(get_main_bundle())
@@ -667,10 +1003,12 @@ omnitrace_finalize_hidden(void)
     }
 
     OMNITRACE_DEBUG_F("Stopping and destroying instrumentation bundles...\n");
-    for(size_t i = 0; i < max_supported_threads; ++i)
+    size_t _instrumented_threads = 0;
+    for(size_t i = 0; i < instrumentation_bundles::instances().size(); ++i)
     {
         auto&       itr   = instrumentation_bundles::instances().at(i);
         const auto& _info = thread_info::get(i, InternalTID);
+        if(itr.count > 0) ++_instrumented_threads;
         while(!itr.bundles.empty())
         {
             int _lvl = 1;
@@ -687,11 +1025,11 @@ omnitrace_finalize_hidden(void)
 
             itr.bundles.back()->stop();
             itr.bundles.back()->pop();
-            itr.allocator.destroy(itr.bundles.back());
-            itr.allocator.deallocate(itr.bundles.back(), 1);
-            itr.bundles.pop_back();
+            itr.release(&itr.bundles.back());
         }
     }
+    OMNITRACE_VERBOSE_F(1, "Recorded instrumentation on %zu threads\n",
+                        _instrumented_threads);
 
     // stop the main gotcha which shuts down the pthread gotchas
     if(get_init_bundle())
@@ -714,6 +1052,13 @@ omnitrace_finalize_hidden(void)
         process_sampler::shutdown();
     }
 
+    // the pending snapshot is written before the data sources are flushed and stopped
+    if(flight_recorder::enabled())
+    {
+        OMNITRACE_VERBOSE_F(1, "Shutting down the flight recorder...\n");
+        flight_recorder::shutdown();
+    }
+
     if(get_use_roctracer())
     {
         OMNITRACE_VERBOSE_F(1, "Shutting down roctracer...\n");
@@ -769,159 +1114,199 @@ omnitrace_finalize_hidden(void)
 
     if(get_verbose() >= 0 || get_debug()) fprintf(stderr, "\n");
 
-    // ensure that all the MT instances are flushed
-    if(get_use_sampling())
-    {
-        OMNITRACE_VERBOSE_F(1, "Post-processing the sampling backtraces...\n");
-        sampling::post_process();
-    }
+    bool _use_critical_trace =
+        get_use_critical_trace() || (get_use_rocm_smi() && get_use_roctracer());
 
-    if(get_use_critical_trace() || (get_use_rocm_smi() && get_use_roctracer()))
+    if(_use_critical_trace)
     {
-        OMNITRACE_VERBOSE_F(1, "Generating the critical trace...\n");
         // (potentially) increase the thread-pool size since application
         // shouldn't be using threads during finalization
         tasking::initialize_threadpool(std::min<uint64_t>(
             { std::thread::hardware_concurrency(), get_thread_pool_size(), 8 }));
+    }
 
-        for(size_t i = 0; i < max_supported_threads; ++i)
-        {
-            using critical_trace_hash_data =
-                thread_data<critical_trace::hash_ids, critical_trace::id>;
+    using finalization::stage_policy;
+
+    // the post-processing stages only wait on the stages whose output they consume.
+    // The stages which record into the timemory storage of this thread, require MPI, or
+    // join the tasks of the thread-pool (sampling, critical trace, process sampling,
+    // communication data, and perfetto) run on this thread in the order they become
+    // ready. The critical-trace updates are launched first so that they are processed
+    // on the thread-pool while this thread post-processes the samples and the
+    // communication data. The event-buffer conversion and the reports also run on the
+    // thread-pool alongside them. Stages which are not enabled are disabled so that the
+    // dependencies on them are satisfied
+    bool _perfetto_output_error = false;
+    auto _stages                = finalization::stage_graph{};
 
-            if(critical_trace_hash_data::instances().at(i))
-                critical_trace::add_hash_id(*critical_trace_hash_data::instances().at(i));
-        }
+    if(_use_critical_trace)
+    {
+        _stages.add(
+            "critical-trace", {},
+            []() {
+                OMNITRACE_VERBOSE(1, "Launching the critical trace updates...\n");
+                using critical_trace_hash_data =
+                    thread_data<critical_trace::hash_ids, critical_trace::id>;
+                using critical_trace_chain_data = thread_data<critical_trace::call_chain>;
+
+                for(size_t i = 0; i < critical_trace_hash_data::size(); ++i)
+                {
+                    auto& _hash_ids = critical_trace_hash_data::instances().at(i);
+                    if(_hash_ids) critical_trace::add_hash_id(*_hash_ids);
+                }
+
+                for(size_t i = 0; i < critical_trace_chain_data::size(); ++i)
+                {
+                    if(critical_trace_chain_data::instances().at(i))
+                        critical_trace::update(i);  // launch update task
+                }
+            },
+            stage_policy::calling_thread);
+    }
+    else
+        _stages.disable("critical-trace");
 
-        for(size_t i = 0; i < max_supported_threads; ++i)
-        {
-            using critical_trace_chain_data = thread_data<critical_trace::call_chain>;
+    // ensure that all the MT instances are flushed
+    if(get_use_sampling())
+    {
+        _stages.add(
+            "sampling", {},
+            []() {
+                OMNITRACE_VERBOSE(1, "Post-processing the sampling backtraces...\n");
+                sampling::post_process();
+            },
+            stage_policy::calling_thread);
+    }
+    else
+        _stages.disable("sampling");
 
-            if(critical_trace_chain_data::instances().at(i))
-                critical_trace::update(i);  // launch update task
-        }
+    if(get_use_perfetto() && get_perfetto_event_buffer())
+    {
+        _stages.add("event-buffer", {}, []() {
+            OMNITRACE_VERBOSE(1, "Converting the event buffers to perfetto...\n");
+            event_buffer::post_process();
+            // commit the events written by this thread before the session is stopped
+            perfetto::TrackEvent::Flush();
+        });
+    }
+    else
+        _stages.disable("event-buffer");
 
-        OMNITRACE_VERBOSE_F(1, "Waiting on critical trace updates...\n");
-        tasking::join();
+    // the updates of the critical trace are processed on the thread-pool while the
+    // samples are post-processed
+    if(_use_critical_trace)
+    {
+        _stages.add(
+            "critical-trace-compute", { "critical-trace" },
+            []() {
+                OMNITRACE_VERBOSE(1, "Waiting on critical trace updates...\n");
+                tasking::join();
+
+                if(!get_use_critical_trace()) return;
+
+                // launch compute task
+                OMNITRACE_VERBOSE(1, "launching critical trace compute task...\n");
+                critical_trace::compute();
+
+                OMNITRACE_VERBOSE(1, "Waiting on critical trace tasks...\n");
+                tasking::join();
+            },
+            stage_policy::calling_thread);
     }
+    else
+        _stages.disable("critical-trace-compute");
 
     if(get_use_process_sampling())
     {
-        OMNITRACE_VERBOSE_F(1, "Post-processing the system-level samples...\n");
-        process_sampler::post_process();
+        // the GPU samples are attributed to the entries of the critical trace
+        _stages.add(
+            "process-sampling", { "critical-trace-compute" },
+            []() {
+                OMNITRACE_VERBOSE(1, "Post-processing the system-level samples...\n");
+                process_sampler::post_process();
+            },
+            stage_policy::calling_thread);
     }
+    else
+        _stages.disable("process-sampling");
 
-    if(get_use_critical_trace())
+    if(throttle::enabled())
     {
-        // make sure outstanding hash tasks completed before compute
-        tasking::join();
-
-        // launch compute task
-        OMNITRACE_VERBOSE_F(1, "launching critical trace compute task...\n");
-        critical_trace::compute();
+        _stages.add(
+            "throttle", {},
+            []() {
+                OMNITRACE_VERBOSE(1, "Reporting the throttled regions...\n");
+                throttle::post_process();
+            },
+            stage_policy::serialized);
+    }
 
-        OMNITRACE_VERBOSE_F(1, "Waiting on critical trace tasks...\n");
-        tasking::join();
+    if(lock_contention::enabled())
+    {
+        _stages.add(
+            "lock-contention", {},
+            []() {
+                OMNITRACE_VERBOSE(1, "Reporting the lock profile...\n");
+                lock_contention::post_process();
+            },
+            stage_policy::serialized);
     }
 
-    // shutdown tasking before timemory is finalized, especially the roctracer thread-pool
-    OMNITRACE_VERBOSE_F(1, "Shutting down thread-pools...\n");
-    tasking::shutdown();
+    if(overhead::enabled())
+    {
+        _stages.add(
+            "overhead", {},
+            []() {
+                OMNITRACE_VERBOSE(1, "Reporting the overhead compensation...\n");
+                overhead::post_process();
+            },
+            stage_policy::serialized);
+    }
 
     if(get_use_code_coverage())
     {
-        OMNITRACE_VERBOSE_F(1, "Post-processing the code coverage...\n");
-        coverage::post_process();
+        _stages.add(
+            "coverage", {},
+            []() {
+                OMNITRACE_VERBOSE(1, "Post-processing the code coverage...\n");
+                coverage::post_process();
+            },
+            stage_policy::serialized);
     }
 
-    bool _perfetto_output_error = false;
-    if(get_use_perfetto() && !is_system_backend())
+    if((get_use_timemory() && (get_use_mpip() || get_use_rcclp())) ||
+       (get_use_mpip() && get_mpip_comm_matrix()))
     {
-        auto& tracing_session = tracing::get_trace_session();
-
-        OMNITRACE_CI_THROW(tracing_session == nullptr,
-                           "Null pointer to the tracing session");
-
-        OMNITRACE_VERBOSE_F(0, "Finalizing perfetto...\n");
-
-        // Make sure the last event is closed for this example.
-        perfetto::TrackEvent::Flush();
-        tracing_session->FlushBlocking();
-
-        OMNITRACE_VERBOSE_F(3, "Stopping the blocking perfetto trace session...\n");
-        tracing_session->StopBlocking();
+        // writes the communication data into the timemory storage of each thread and
+        // collects the communication matrix, which requires MPI on the calling thread
+        _stages.add(
+            "comm-data", {},
+            []() {
+                OMNITRACE_VERBOSE(1, "Post-processing the communication data...\n");
+                component::comm_data::post_process();
+            },
+            stage_policy::calling_thread);
+    }
 
-        using char_vec_t = std::vector<char>;
-        OMNITRACE_VERBOSE_F(3, "Getting the trace data...\n");
+    if(get_use_perfetto() && !is_system_backend())
+    {
+        _stages.add(
+            "perfetto",
+            { "sampling", "event-buffer", "critical-trace", "process-sampling",
+              "critical-trace-compute" },
+            [&_perfetto_output_error]() {
+                _perfetto_output_error = !finalize_perfetto();
+            },
+            stage_policy::calling_thread);
+    }
 
-        auto trace_data = char_vec_t{};
-#if defined(TIMEMORY_USE_MPI) && TIMEMORY_USE_MPI > 0
-        if(get_perfetto_combined_traces())
-        {
-            using perfetto_mpi_get_t =
-                tim::operation::finalize::mpi_get<char_vec_t, true>;
-
-            char_vec_t              _trace_data{ tracing_session->ReadTraceBlocking() };
-            std::vector<char_vec_t> _rank_data = {};
-            auto _combine = [](char_vec_t& _dst, const char_vec_t& _src) -> char_vec_t& {
-                _dst.reserve(_dst.size() + _src.size());
-                for(auto&& itr : _src)
-                    _dst.emplace_back(itr);
-                return _dst;
-            };
-
-            perfetto_mpi_get_t{ get_perfetto_combined_traces(), settings::node_count() }(
-                _rank_data, _trace_data, _combine);
-            for(auto& itr : _rank_data)
-                trace_data =
-                    (trace_data.empty()) ? std::move(itr) : _combine(trace_data, itr);
-        }
-        else
-        {
-            trace_data = tracing_session->ReadTraceBlocking();
-        }
-#else
-        trace_data = tracing_session->ReadTraceBlocking();
-#endif
+    _stages.execute(get_parallel_finalize());
 
-        if(!trace_data.empty())
-        {
-            operation::file_output_message<tim::project::omnitrace> _fom{};
-            // Write the trace into a file.
-            if(get_verbose() >= 0)
-                _fom(get_perfetto_output_filename(), std::string{ "perfetto" },
-                     " (%.2f KB / %.2f MB / %.2f GB)... ",
-                     static_cast<double>(trace_data.size()) / units::KB,
-                     static_cast<double>(trace_data.size()) / units::MB,
-                     static_cast<double>(trace_data.size()) / units::GB);
-            std::ofstream ofs{};
-            if(!tim::filepath::open(ofs, get_perfetto_output_filename(),
-                                    std::ios::out | std::ios::binary))
-            {
-                _fom.append("Error opening '%s'...",
-                            get_perfetto_output_filename().c_str());
-                _perfetto_output_error = true;
-            }
-            else
-            {
-                // Write the trace into a file.
-                ofs.write(&trace_data[0], trace_data.size());
-                if(get_verbose() >= 0) _fom.append("%s", "Done");  // NOLINT
-                auto _manager = tim::manager::instance();
-                if(_manager)
-                    _manager->add_file_output("protobuf", "perfetto",
-                                              get_perfetto_output_filename());
-            }
-            ofs.close();
-        }
-        else if(dmp::rank() == 0)
-        {
-            OMNITRACE_VERBOSE_F(0,
-                                "trace data is empty. File '%s' will not be written...\n",
-                                get_perfetto_output_filename().c_str());
-        }
-    }
+    // shutdown tasking before timemory is finalized, especially the roctracer thread-pool
+    OMNITRACE_VERBOSE_F(1, "Shutting down thread-pools...\n");
+    tasking::shutdown();
 
+    // timemory is finalized once the thread-pools are shut down
     tim::manager::instance()->add_metadata([](auto& ar) {
         auto _maps = tim::procfs::read_maps(process::get_id());
         auto _libs = std::set<std::string>{};
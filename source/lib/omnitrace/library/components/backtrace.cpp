@@ -50,6 +50,7 @@
 #include <timemory/units.hpp>
 #include <timemory/utility/backtrace.hpp>
 #include <timemory/utility/demangle.hpp>
+#include <timemory/utility/procfs/maps.hpp>
 #include <timemory/utility/types.hpp>
 #include <timemory/variadic.hpp>
 
@@ -57,12 +58,16 @@
 #include <cstring>
 #include <ctime>
 #include <initializer_list>
+#include <map>
 #include <mutex>
 #include <regex>
+#include <shared_mutex>
 #include <sstream>
 #include <string>
 #include <string_view>
 #include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <pthread.h>
@@ -72,44 +77,253 @@ namespace omnitrace
 {
 namespace component
 {
-std::vector<std::string>
-backtrace::get() const
+namespace
 {
-    std::vector<std::string> _v = {};
-    if(size() == 0) return _v;
-    _v.reserve(m_data.size());
-    for(const auto& itr : m_data.call_stack)
+// symbols are keyed by the base address of the module they reside in + the offset
+// into that module so that the key is stable regardless of where the IP was
+// recorded from
+using symbol_key_t = std::pair<uintptr_t, uintptr_t>;
+
+struct symbol_key_hash
+{
+    size_t operator()(const symbol_key_t& _v) const
     {
-        if(!itr) continue;
+        return std::hash<uintptr_t>{}(_v.first) ^ (std::hash<uintptr_t>{}(_v.second) << 1);
+    }
+};
+
+// check whether the call-stack entry should be used. -1 means break, 0 means continue
+short
+use_label(std::string_view _lbl)
+{
+    // debugging feature
+    bool       _keep_internal = get_sampling_keep_internal();
+    const auto _npos          = std::string::npos;
+    if(_keep_internal) return 1;
+    if(_lbl.find("omnitrace::common::") != _npos) return 0;
+    if(_lbl.find("omnitrace::") != _npos) return 0;
+    if(_lbl.find("tim::") != _npos) return 0;
+    if(_lbl.find("DYNINST_") != _npos) return 0;
+    if(_lbl.find("omnitrace_") != _npos) return -1;
+    if(_lbl.find("rocprofiler_") != _npos) return -1;
+    if(_lbl.find("roctracer_") != _npos) return -1;
+    if(_lbl.find("perfetto::") != _npos) return -1;
+    return 1;
+}
+
+// demangles the name. In the dyninst binary rewrite runtime, instrumented functions are
+// appended with "_dyninst", i.e. "main" will show up as "main_dyninst" in the backtrace
+// so the suffix is removed
+std::string
+get_label(std::string_view _lbl)
+{
+    // debugging feature
+    static bool _keep_suffix = tim::get_env<bool>(
+        "OMNITRACE_SAMPLING_KEEP_DYNINST_SUFFIX", get_debug_sampling());
+
+    if(_keep_suffix) return tim::demangle(std::string{ _lbl });
+    const std::string _dyninst{ "_dyninst" };
+    auto              _pos = _lbl.find(_dyninst);
+    if(_pos == std::string::npos) return tim::demangle(std::string{ _lbl });
+    return tim::demangle(std::string{ _lbl }.replace(_pos, _dyninst.length(), ""));
+}
+
+struct symbol_name
+{
+    std::string name  = {};  // the name as resolved
+    std::string label = {};  // the demangled name, see get_label
+};
+
+struct symbol_cache
+{
+    using module_map_t = std::map<uintptr_t, std::pair<uintptr_t, uintptr_t>>;
+    using name_map_t   = std::unordered_map<symbol_key_t, symbol_name, symbol_key_hash>;
+
+    symbol_key_t       get_key(uintptr_t _addr);
+    const symbol_name* find(const symbol_key_t& _key) const;
+    const symbol_name* emplace(const symbol_key_t& _key, std::string&& _name);
+
+private:
+    bool find_module(uintptr_t _addr, symbol_key_t& _key) const;
+    void read_modules();
+
+    mutable std::shared_mutex m_mutex   = {};
+    module_map_t              m_modules = {};
+    name_map_t                m_names   = {};
+};
+
+symbol_cache&
+get_symbol_cache()
+{
+    static auto _v = symbol_cache{};
+    return _v;
+}
+
+bool
+symbol_cache::find_module(uintptr_t _addr, symbol_key_t& _key) const
+{
+    // m_modules maps the end address of each mapping to {first address, base address}
+    auto itr = m_modules.upper_bound(_addr);
+    if(itr == m_modules.end() || _addr < itr->second.first) return false;
+    _key = { itr->second.second, _addr - itr->second.second };
+    return true;
+}
+
+void
+symbol_cache::read_modules()
+{
+    auto _base = std::map<std::string, uintptr_t>{};
+    auto _maps = tim::procfs::read_maps(tim::process::get_id());
+    for(const auto& itr : _maps)
+    {
+        auto& _v = _base[itr.pathname];
+        if(_v == 0 || itr.load_address < _v) _v = itr.load_address;
+    }
+
+    m_modules.clear();
+    for(const auto& itr : _maps)
+    {
+        auto _base_addr = (itr.pathname.empty()) ? itr.load_address : _base[itr.pathname];
+        m_modules[itr.last_address] = { itr.load_address, _base_addr };
+    }
+}
+
+symbol_key_t
+symbol_cache::get_key(uintptr_t _addr)
+{
+    auto _key = symbol_key_t{ 0, _addr };
+    {
+        auto _lk = std::shared_lock<std::shared_mutex>{ m_mutex };
+        if(find_module(_addr, _key)) return _key;
+    }
+
+    // the address may reside in a library that was loaded after the maps were read
+    auto _lk = std::unique_lock<std::shared_mutex>{ m_mutex };
+    if(!find_module(_addr, _key))
+    {
+        read_modules();
+        find_module(_addr, _key);
+    }
+    return _key;
+}
+
+const symbol_name*
+symbol_cache::find(const symbol_key_t& _key) const
+{
+    auto _lk = std::shared_lock<std::shared_mutex>{ m_mutex };
+    auto itr = m_names.find(_key);
+    return (itr != m_names.end()) ? &itr->second : nullptr;
+}
+
+const symbol_name*
+symbol_cache::emplace(const symbol_key_t& _key, std::string&& _name)
+{
+    // the name is demangled once per symbol instead of once per sample
+    auto _label = get_label(_name);
+    // references into an unordered_map remain valid after a rehash
+    auto _lk = std::unique_lock<std::shared_mutex>{ m_mutex };
+    return &m_names.emplace(_key, symbol_name{ std::move(_name), std::move(_label) })
+                .first->second;
+}
 
+template <typename EntryT, typename ContextT>
+std::string
+resolve_symbol(const EntryT& _entry, ContextT _context)
+{
 #if defined(OMNITRACE_CI) && OMNITRACE_CI > 0
-        std::string _name = {};
-        _name.reserve(1024);
-        const char* _addr = _name.data();
-        _name             = itr->get_name(m_data.context, _name);
-
-        OMNITRACE_CONDITIONAL_PRINT(
-            _name.data() != _addr,
-            "[backtrace::get()] processing unw_get_proc_name_from_ip for '%s' "
-            "caused a reallocation. Before=%p, After=%p\n",
-            _name.c_str(), _addr, _name.data());
+    std::string _name = {};
+    _name.reserve(1024);
+    const char* _addr = _name.data();
+    _name             = _entry.get_name(_context, _name);
+
+    OMNITRACE_CONDITIONAL_PRINT(
+        _name.data() != _addr,
+        "[backtrace::get()] processing unw_get_proc_name_from_ip for '%s' "
+        "caused a reallocation. Before=%p, After=%p\n",
+        _name.c_str(), _addr, _name.data());
+    return _name;
 #else
-        auto _name = itr->get_name(m_data.context);
+    return _entry.get_name(_context);
 #endif
+}
+
+// returns the symbols of the call-stack with the bottom of the call-stack on top
+std::vector<const symbol_name*>
+get_symbols(const backtrace::data_t& _data)
+{
+    static const auto _known_excludes =
+        std::set<std::string_view>{ "funlockfile", "killpg", "__restore_rt" };
 
-        if(!_name.empty()) _v.emplace_back(_name);
+    auto _v = std::vector<const symbol_name*>{};
+    _v.reserve(_data.size());
+
+    auto& _cache = get_symbol_cache();
+    for(const auto& itr : _data.call_stack)
+    {
+        if(!itr) continue;
+
+        auto        _key  = _cache.get_key(itr->address());
+        const auto* _name = _cache.find(_key);
+        if(!_name) _name = _cache.emplace(_key, resolve_symbol(*itr, _data.context));
+
+        if(!_name->name.empty()) _v.emplace_back(_name);
     }
     // put the bottom of the call-stack on top
     std::reverse(_v.begin(), _v.end());
-    //
-    auto _known_excludes =
-        std::set<std::string>{ "funlockfile", "killpg", "__restore_rt" };
     // remove some known functions which are by-products of interrupts
-    while(!_v.empty() && _known_excludes.find(_v.back()) != _known_excludes.end())
+    while(!_v.empty() && _known_excludes.find(_v.back()->name) != _known_excludes.end())
         _v.pop_back();
 
     return _v;
 }
+}  // namespace
+
+size_t
+backtrace::resolve(const std::vector<const backtrace*>& _data)
+{
+    auto& _cache = get_symbol_cache();
+    auto  _count = size_t{ 0 };
+
+    // collect the unique, unresolved addresses first so that each symbol is only
+    // looked up once regardless of how many samples it appears in
+    auto _unresolved = std::map<symbol_key_t, std::pair<const data_t*, size_t>>{};
+    for(const auto* itr : _data)
+    {
+        if(!itr) continue;
+        const auto& _stack = itr->m_data.call_stack;
+        for(size_t i = 0; i < _stack.size(); ++i)
+        {
+            if(!_stack[i]) continue;
+            auto _key = _cache.get_key(_stack[i]->address());
+            if(_cache.find(_key)) continue;
+            _unresolved.emplace(_key, std::make_pair(&itr->m_data, i));
+        }
+    }
+
+    for(const auto& itr : _unresolved)
+    {
+        const auto* _stack = itr.second.first;
+        const auto& _entry = _stack->call_stack[itr.second.second];
+        _cache.emplace(itr.first, resolve_symbol(*_entry, _stack->context));
+        ++_count;
+    }
+
+    return _count;
+}
+
+std::vector<std::string>
+backtrace::get() const
+{
+    std::vector<std::string> _v = {};
+    if(size() == 0) return _v;
+
+    auto _symbols = get_symbols(m_data);
+    _v.reserve(_symbols.size());
+    for(const auto* itr : _symbols)
+        _v.emplace_back(itr->name);
+
+    return _v;
+}
 
 std::string
 backtrace::label()
@@ -126,42 +340,11 @@ backtrace::description()
 std::vector<std::string>
 backtrace::filter_and_patch(const std::vector<std::string>& _data)
 {
-    // check whether the call-stack entry should be used. -1 means break, 0 means continue
-    auto _use_label = [](std::string_view _lbl) -> short {
-        // debugging feature
-        bool       _keep_internal = get_sampling_keep_internal();
-        const auto _npos          = std::string::npos;
-        if(_keep_internal) return 1;
-        if(_lbl.find("omnitrace::common::") != _npos) return 0;
-        if(_lbl.find("omnitrace::") != _npos) return 0;
-        if(_lbl.find("tim::") != _npos) return 0;
-        if(_lbl.find("DYNINST_") != _npos) return 0;
-        if(_lbl.find("omnitrace_") != _npos) return -1;
-        if(_lbl.find("rocprofiler_") != _npos) return -1;
-        if(_lbl.find("roctracer_") != _npos) return -1;
-        if(_lbl.find("perfetto::") != _npos) return -1;
-        return 1;
-    };
-
-    bool _keep_suffix = tim::get_env<bool>("OMNITRACE_SAMPLING_KEEP_DYNINST_SUFFIX",
-                                           get_debug_sampling());
-
-    // in the dyninst binary rewrite runtime, instrumented functions are appended with
-    // "_dyninst", i.e. "main" will show up as "main_dyninst" in the backtrace.
-    auto _patch_label = [_keep_suffix](std::string_view _lbl) -> std::string {
-        // debugging feature
-        if(_keep_suffix) return std::string{ _lbl };
-        const std::string _dyninst{ "_dyninst" };
-        auto              _pos = _lbl.find(_dyninst);
-        if(_pos == std::string::npos) return std::string{ _lbl };
-        return std::string{ _lbl }.replace(_pos, _dyninst.length(), "");
-    };
-
     auto _ret = std::vector<std::string>{};
     for(const auto& itr : _data)
     {
-        auto _name = tim::demangle(_patch_label(itr));
-        auto _use  = _use_label(_name);
+        auto _name = get_label(itr);
+        auto _use  = use_label(_name);
         if(_use == -1) break;
         if(_use == 0) continue;
         _ret.emplace_back(_name);
@@ -170,6 +353,24 @@ backtrace::filter_and_patch(const std::vector<std::string>& _data)
     return _ret;
 }
 
+std::vector<std::string>
+backtrace::filter_and_patch(const backtrace& _bt)
+{
+    auto _ret = std::vector<std::string>{};
+    if(_bt.size() == 0) return _ret;
+
+    // the demangled names are cached with the symbols
+    for(const auto* itr : get_symbols(_bt.m_data))
+    {
+        auto _use = use_label(itr->label);
+        if(_use == -1) break;
+        if(_use == 0) continue;
+        _ret.emplace_back(itr->label);
+    }
+
+    return _ret;
+}
+
 void
 backtrace::start()
 {}
@@ -68,6 +68,11 @@ struct backtrace
     backtrace& operator=(backtrace&&) noexcept = default;
 
     static std::vector<std::string> filter_and_patch(const std::vector<std::string>&);
+    static std::vector<std::string> filter_and_patch(const backtrace&);
+
+    /// symbolizes all the unique instruction pointers in the given backtraces and
+    /// caches the result. Returns the number of symbols which were newly resolved
+    static size_t resolve(const std::vector<const backtrace*>&);
 
     static void start();
     static void stop();
@@ -29,7 +29,6 @@
 #include "library/ptl.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
-#include "library/thread_info.hpp"
 #include "library/tracing.hpp"
 
 #include <timemory/backends/papi.hpp>
@@ -209,6 +208,21 @@ backtrace_metrics::configure(bool _setup, int64_t _tid)
     }
 }
 
+void
+backtrace_metrics::retire(int64_t _tid)
+{
+    // the hardware counters are bound to the thread which started them so they are
+    // released before the index of this thread is assigned to another thread
+    if(_tid != threading::get_id()) return;
+
+    configure(false, _tid);
+
+    if constexpr(tim::trait::is_available<hw_counters>::value)
+    {
+        get_papi_vector(_tid).reset();
+    }
+}
+
 void
 backtrace_metrics::init_perfetto(int64_t _tid)
 {
@@ -240,15 +254,9 @@ backtrace_metrics::init_perfetto(int64_t _tid)
 }
 
 void
-backtrace_metrics::fini_perfetto(int64_t _tid)
+backtrace_metrics::fini_perfetto(int64_t _tid, uint64_t _ts)
 {
-    auto        _hw_cnt_labels = *get_papi_labels(_tid);
-    const auto& _thread_info   = thread_info::get(_tid, InternalTID);
-
-    OMNITRACE_CI_THROW(!_thread_info, "Error! missing thread info for tid=%li\n", _tid);
-    if(!_thread_info) return;
-
-    uint64_t _ts = _thread_info->get_stop();
+    auto _hw_cnt_labels = *get_papi_labels(_tid);
 
     TRACE_COUNTER("thread_peak_memory",
                   perfetto_counter_track<perfetto_rusage>::at(_tid, 0), _ts, 0);
@@ -73,7 +73,8 @@ struct backtrace_metrics
 
     static void configure(bool, int64_t _tid = threading::get_id());
     static void init_perfetto(int64_t _tid);
-    static void fini_perfetto(int64_t _tid);
+    static void fini_perfetto(int64_t _tid, uint64_t _ts);
+    static void retire(int64_t _tid = threading::get_id());
 
     static void start();
     static void stop();
@@ -22,6 +22,7 @@
 
 #include "library/components/backtrace_timestamp.hpp"
 #include "library/thread_info.hpp"
+#include "library/timestamp.hpp"
 
 #include <timemory/components/timing/backends.hpp>
 
@@ -46,7 +47,7 @@ void
 backtrace_timestamp::sample(int)
 {
     m_tid  = tim::threading::get_id();
-    m_real = tim::get_clock_real_now<uint64_t, std::nano>();
+    m_real = timestamp::now();
 }
 }  // namespace component
 }  // namespace omnitrace
@@ -25,7 +25,14 @@
 #include "library/config.hpp"
 #include "library/critical_trace.hpp"
 #include "library/defines.hpp"
+#include "library/event_buffer.hpp"
+#include "library/flight_recorder.hpp"
+#include "library/overhead.hpp"
+#include "library/region_gate.hpp"
+#include "library/region_table.hpp"
 #include "library/runtime.hpp"
+#include "library/string_table.hpp"
+#include "library/throttle.hpp"
 #include "library/timemory.hpp"
 #include "library/tracing.hpp"
 
@@ -69,6 +76,13 @@ struct category_region : comp::base<category_region<CategoryT>, void>
     template <typename... OptsT, typename... Args>
     static void stop(std::string_view name, Args&&...);
 
+    // pre-registered regions do not require hashing the name
+    template <typename... OptsT, typename... Args>
+    static void start(const region_table::region_info&, Args&&...);
+
+    template <typename... OptsT, typename... Args>
+    static void stop(const region_table::region_info&, Args&&...);
+
     template <typename... OptsT, typename... Args>
     static void audit(const gotcha_data_t&, audit::incoming, Args&&...);
 
@@ -83,6 +97,13 @@ struct category_region : comp::base<category_region<CategoryT>, void>
 
     template <typename... OptsT, typename... Args>
     static void audit(quirk::config<OptsT...>, Args&&...);
+
+private:
+    template <typename... OptsT, typename HashT, typename... Args>
+    static void start_impl(const char* name, HashT&& _get_hash, Args&&...);
+
+    template <typename... OptsT, typename HashT, typename... Args>
+    static void stop_impl(const char* name, HashT&& _get_hash, Args&&...);
 };
 
 template <typename CategoryT>
@@ -90,23 +111,68 @@ template <typename... OptsT, typename... Args>
 void
 category_region<CategoryT>::start(std::string_view name, Args&&... args)
 {
-    // unconditionally return if thread is disabled or finalized
-    if(get_thread_state() == ThreadState::Disabled) return;
-    if(get_state() == State::Finalized) return;
+    start_impl<OptsT...>(
+        name.data(), [name]() { return string_table::get_id(name); },
+        std::forward<Args>(args)...);
+}
 
-    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+template <typename CategoryT>
+template <typename... OptsT, typename... Args>
+void
+category_region<CategoryT>::stop(std::string_view name, Args&&... args)
+{
+    stop_impl<OptsT...>(
+        name.data(), [name]() { return string_table::get_id(name); },
+        std::forward<Args>(args)...);
+}
+
+template <typename CategoryT>
+template <typename... OptsT, typename... Args>
+void
+category_region<CategoryT>::start(const region_table::region_info& _info,
+                                  Args&&... args)
+{
+    start_impl<OptsT...>(
+        _info.name, [&_info]() { return _info.hash; }, std::forward<Args>(args)...);
+}
+
+template <typename CategoryT>
+template <typename... OptsT, typename... Args>
+void
+category_region<CategoryT>::stop(const region_table::region_info& _info, Args&&... args)
+{
+    stop_impl<OptsT...>(
+        _info.name, [&_info]() { return _info.hash; }, std::forward<Args>(args)...);
+}
 
-    // the expectation here is that if the state is not active then the call
-    // to omnitrace_init_tooling_hidden will activate all the appropriate
-    // tooling one time and as it exits set it to active and return true.
-    if(get_state() != State::Active && !omnitrace_init_tooling_hidden()) return;
+template <typename CategoryT>
+template <typename... OptsT, typename HashT, typename... Args>
+void
+category_region<CategoryT>::start_impl(const char* name, HashT&& _get_hash,
+                                       Args&&... args)
+{
+    // a single thread-local load decides whether this is the common case: active and
+    // the thread has been initialized. Otherwise, return if the thread is disabled or
+    // finalized, or perform the one-time initialization of the tooling and/or thread
+    auto _gate = region_gate::load();
+    if(!(_gate & region_gate::Start))
+    {
+        if(_gate & region_gate::Skip) return;
+        _gate = region_gate::initialize_thread();
+        if(!(_gate & region_gate::Start)) return;
+    }
 
-    tracing::thread_init();
+    auto _sample   = overhead::scoped_sample{ _gate, &overhead::thread_overhead::entry };
+    auto _internal = region_gate::scoped_internal{};
 
-    // thread initialization may have disabled the thread
-    if(get_thread_state() == ThreadState::Disabled) return;
+    // entering one of the trigger regions requests a flight-recorder snapshot
+    if(_gate & region_gate::FlightRecorder) flight_recorder::trigger(_get_hash());
 
-    tracing::thread_init_sampling();
+    // instrumented functions which are called too frequently are throttled
+    if constexpr(tim::is_one_of<CategoryT, tim::type_list<category::host>>::value)
+    {
+        if((_gate & region_gate::Throttle) && !throttle::start(_get_hash())) return;
+    }
 
     constexpr bool _ct_use_timemory =
         (sizeof...(OptsT) == 0 ||
@@ -116,10 +182,15 @@ category_region<CategoryT>::start(std::string_view name, Args&&... args)
         (sizeof...(OptsT) == 0 ||
          tim::is_one_of<quirk::perfetto, tim::type_list<OptsT...>>::value);
 
+    // the event buffers only record the name and timestamp of instrumented functions
+    constexpr bool _ct_use_event_buffer =
+        (sizeof...(Args) == 0 &&
+         tim::is_one_of<CategoryT, tim::type_list<category::host>>::value);
+
     OMNITRACE_CONDITIONAL_PRINT(tracing::debug_push,
                                 "[%s][PID=%i][state=%s] omnitrace_push_region(%s)\n",
                                 category_name, process::get_id(),
-                                std::to_string(get_state()).c_str(), name.data());
+                                std::to_string(get_state()).c_str(), name);
 
     if constexpr(tim::is_one_of<CategoryT, tim::type_list<category::host>>::value)
     {
@@ -128,17 +199,21 @@ category_region<CategoryT>::start(std::string_view name, Args&&... args)
 
     if constexpr(_ct_use_perfetto)
     {
-        if(get_use_perfetto())
+        if(_ct_use_event_buffer && (_gate & region_gate::EventBuffer))
+        {
+            event_buffer::begin(_get_hash());
+        }
+        else if(_gate & region_gate::Perfetto)
         {
-            tracing::push_perfetto(CategoryT{}, name.data(), std::forward<Args>(args)...);
+            tracing::push_perfetto(CategoryT{}, name, std::forward<Args>(args)...);
         }
     }
 
     if constexpr(_ct_use_timemory)
     {
-        if(get_use_timemory())
+        if(_gate & region_gate::Timemory)
         {
-            tracing::push_timemory(CategoryT{}, name.data(), std::forward<Args>(args)...);
+            tracing::push_timemory(CategoryT{}, _get_hash(), std::forward<Args>(args)...);
         }
     }
 
@@ -147,28 +222,47 @@ category_region<CategoryT>::start(std::string_view name, Args&&... args)
         using Device = critical_trace::Device;
         using Phase  = critical_trace::Phase;
 
-        if(get_use_critical_trace())
+        if(_gate & region_gate::CriticalTrace)
         {
             uint64_t _cid                       = 0;
             uint64_t _parent_cid                = 0;
             uint32_t _depth                     = 0;
             std::tie(_cid, _parent_cid, _depth) = create_cpu_cid_entry();
-            auto _ts                            = comp::wall_clock::record();
+            auto _ts                            = tracing::now();
             add_critical_trace<Device::CPU, Phase::BEGIN>(
-                threading::get_id(), _cid, 0, _parent_cid, _ts, 0, 0, 0,
-                critical_trace::add_hash_id(name.data()), _depth);
+                threading::get_id(), _cid, 0, _parent_cid, _ts, 0, 0, 0, _get_hash(),
+                _depth);
         }
     }
 }
 
 template <typename CategoryT>
-template <typename... OptsT, typename... Args>
+template <typename... OptsT, typename HashT, typename... Args>
 void
-category_region<CategoryT>::stop(std::string_view name, Args&&... args)
+category_region<CategoryT>::stop_impl(const char* name, HashT&& _get_hash,
+                                      Args&&... args)
 {
-    if(get_thread_state() == ThreadState::Disabled) return;
+    auto _gate = region_gate::get();
 
-    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+    // only execute when active
+    if(!(_gate & region_gate::Stop))
+    {
+        if(get_thread_state() == ThreadState::Disabled) return;
+
+        static auto _debug = get_debug_env();
+        OMNITRACE_CONDITIONAL_BASIC_PRINT(
+            _debug, "[%s] omnitrace_pop_region(%s) ignored :: state = %s\n",
+            category_name, name, std::to_string(get_state()).c_str());
+        return;
+    }
+
+    auto _sample   = overhead::scoped_sample{ _gate, &overhead::thread_overhead::exit };
+    auto _internal = region_gate::scoped_internal{};
+
+    if constexpr(tim::is_one_of<CategoryT, tim::type_list<category::host>>::value)
+    {
+        if((_gate & region_gate::Throttle) && !throttle::stop(_get_hash())) return;
+    }
 
     constexpr bool _ct_use_timemory =
         (sizeof...(OptsT) == 0 ||
@@ -178,68 +272,64 @@ category_region<CategoryT>::stop(std::string_view name, Args&&... args)
         (sizeof...(OptsT) == 0 ||
          tim::is_one_of<quirk::perfetto, tim::type_list<OptsT...>>::value);
 
+    // the event buffers only record the name and timestamp of instrumented functions
+    constexpr bool _ct_use_event_buffer =
+        (sizeof...(Args) == 0 &&
+         tim::is_one_of<CategoryT, tim::type_list<category::host>>::value);
+
     OMNITRACE_CONDITIONAL_PRINT(tracing::debug_pop,
                                 "[%s][PID=%i][state=%s] omnitrace_pop_region(%s)\n",
                                 category_name, process::get_id(),
-                                std::to_string(get_state()).c_str(), name.data());
+                                std::to_string(get_state()).c_str(), name);
 
-    // only execute when active
-    if(get_state() == State::Active)
+    if constexpr(tim::is_one_of<CategoryT, tim::type_list<category::host>>::value)
+    {
+        ++tracing::pop_count();
+    }
+
+    if constexpr(_ct_use_timemory)
     {
-        if constexpr(tim::is_one_of<CategoryT, tim::type_list<category::host>>::value)
+        if(_gate & region_gate::Timemory)
         {
-            ++tracing::pop_count();
+            tracing::pop_timemory(CategoryT{}, _get_hash(), std::forward<Args>(args)...);
         }
+    }
 
-        if constexpr(_ct_use_timemory)
+    if constexpr(_ct_use_perfetto)
+    {
+        if(_ct_use_event_buffer && (_gate & region_gate::EventBuffer))
         {
-            if(get_use_timemory())
-            {
-                tracing::pop_timemory(CategoryT{}, name.data(),
-                                      std::forward<Args>(args)...);
-            }
+            event_buffer::end();
         }
-
-        if constexpr(_ct_use_perfetto)
+        else if(_gate & region_gate::Perfetto)
         {
-            if(get_use_perfetto())
-            {
-                tracing::pop_perfetto(CategoryT{}, name.data(),
-                                      std::forward<Args>(args)...);
-            }
+            tracing::pop_perfetto(CategoryT{}, name, std::forward<Args>(args)...);
         }
+    }
 
-        if constexpr(tim::is_one_of<CategoryT, tim::type_list<category::host>>::value)
-        {
-            using Device = critical_trace::Device;
-            using Phase  = critical_trace::Phase;
+    if constexpr(tim::is_one_of<CategoryT, tim::type_list<category::host>>::value)
+    {
+        using Device = critical_trace::Device;
+        using Phase  = critical_trace::Phase;
 
-            if(get_use_critical_trace())
+        if(_gate & region_gate::CriticalTrace)
+        {
+            if(get_cpu_cid_stack() && !get_cpu_cid_stack()->empty())
             {
-                if(get_cpu_cid_stack() && !get_cpu_cid_stack()->empty())
+                auto _cid = get_cpu_cid_stack()->back();
+                if(get_cpu_cid_parents()->find(_cid) != get_cpu_cid_parents()->end())
                 {
-                    auto _cid = get_cpu_cid_stack()->back();
-                    if(get_cpu_cid_parents()->find(_cid) != get_cpu_cid_parents()->end())
-                    {
-                        uint64_t _parent_cid          = 0;
-                        uint32_t _depth               = 0;
-                        auto     _ts                  = comp::wall_clock::record();
-                        std::tie(_parent_cid, _depth) = get_cpu_cid_parents()->at(_cid);
-                        add_critical_trace<Device::CPU, Phase::END>(
-                            threading::get_id(), _cid, 0, _parent_cid, _ts, _ts, 0, 0,
-                            critical_trace::add_hash_id(name.data()), _depth);
-                    }
+                    uint64_t _parent_cid          = 0;
+                    uint32_t _depth               = 0;
+                    auto     _ts                  = tracing::now();
+                    std::tie(_parent_cid, _depth) = get_cpu_cid_parents()->at(_cid);
+                    add_critical_trace<Device::CPU, Phase::END>(
+                        threading::get_id(), _cid, 0, _parent_cid, _ts, _ts, 0, 0,
+                        _get_hash(), _depth);
                 }
             }
         }
     }
-    else
-    {
-        static auto _debug = get_debug_env();
-        OMNITRACE_CONDITIONAL_BASIC_PRINT(
-            _debug, "[%s] omnitrace_pop_region(%s) ignored :: state = %s\n",
-            category_name, name.data(), std::to_string(get_state()).c_str());
-    }
 }
 
 template <typename CategoryT>
@@ -23,55 +23,685 @@
 #include "library/components/comm_data.hpp"
 #include "library/components/fwd.hpp"
 #include "library/config.hpp"
+#include "library/debug.hpp"
 #include "library/perfetto.hpp"
+#include "library/state.hpp"
+#include "library/string_table.hpp"
+#include "library/thread_info.hpp"
 #include "library/tracing.hpp"
 
 #include <timemory/backends/mpi.hpp>
+#include <timemory/backends/threading.hpp>
 #include <timemory/manager.hpp>
+#include <timemory/settings.hpp>
 #include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
 #include <timemory/utility/locking.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 namespace omnitrace
 {
 namespace component
 {
 namespace
 {
-template <typename Tp, typename... Args>
+#if defined(OMNITRACE_USE_MPI) || defined(OMNITRACE_USE_RCCL)
+// the layout determines how the key is translated into the hierarchy of labels
+// when the data is written at finalization
+enum class comm_layout : uint8_t
+{
+    none = 0,     // <func>
+    dst_tag,      // <func> / <func>_dst_<D> / <func>_dst_<D>_tag_<T>
+    root,         // <func> / <func>_root_<R>
+    peer,         // <func> / <func>_peer_<P>
+    root_dir,     // <func> / <func>_root_<R> / <func>_root_<R>_<send|recv>
+    dir,          // <func> / <func>_<send|recv>
+    dir_dst_tag,  // <func> / <func>_<dir> / <func>_<dir>_<D> / <func>_<dir>_<D>_tag_<T>
+};
+
+enum class comm_dir : uint8_t
+{
+    none = 0,
+    send,
+    recv,
+};
+
+struct comm_key
+{
+    const gotcha_data* func   = nullptr;
+    uint64_t           region = 0;  // hash of the active regions (see get_region)
+    uintptr_t          comm   = 0;
+    int32_t            peer   = 0;
+    int32_t            tag    = 0;
+    comm_layout        layout = comm_layout::none;
+    comm_dir           dir    = comm_dir::none;
+
+    bool operator==(const comm_key& _rhs) const
+    {
+        return func == _rhs.func && region == _rhs.region && comm == _rhs.comm &&
+               peer == _rhs.peer && tag == _rhs.tag && layout == _rhs.layout &&
+               dir == _rhs.dir;
+    }
+};
+
+size_t
+hash_combine(size_t _seed, size_t _val)
+{
+    return _seed ^ (_val + 0x9e3779b97f4a7c15UL + (_seed << 6) + (_seed >> 2));
+}
+
+struct comm_key_hash
+{
+    size_t operator()(const comm_key& _v) const
+    {
+        auto _ret = std::hash<const void*>{}(_v.func);
+        _ret      = hash_combine(_ret, std::hash<uint64_t>{}(_v.region));
+        _ret      = hash_combine(_ret, std::hash<uintptr_t>{}(_v.comm));
+        _ret      = hash_combine(_ret, std::hash<int32_t>{}(_v.peer));
+        _ret      = hash_combine(_ret, std::hash<int32_t>{}(_v.tag));
+        _ret      = hash_combine(_ret, (static_cast<size_t>(_v.layout) << 8) |
+                                           static_cast<size_t>(_v.dir));
+        return _ret;
+    }
+};
+
+struct comm_value
+{
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    int32_t  world = -1;  // rank of the peer in MPI_COMM_WORLD (MPI only)
+};
+
+// the communication data is aggregated per-thread into a table keyed by the
+// integral values of the call so that no strings are built and no locks are
+// acquired while the application is communicating
+struct thread_comm_data
+{
+    using entry_map_t  = std::unordered_map<comm_key, comm_value, comm_key_hash>;
+    using region_map_t = std::unordered_map<uint64_t, std::vector<uint64_t>>;
+
+    int64_t      tid     = threading::get_id();
+    entry_map_t  entries = {};
+    region_map_t regions = {};  // the stack of region hashes for each comm_key::region
+};
+
+struct comm_registry
+{
+    std::mutex                     mutex = {};
+    std::vector<thread_comm_data*> data  = {};
+};
+
+auto&
+get_registry()
+{
+    // intentional leak: the data of threads which have exited is reported at finalization
+    static auto* _v = new comm_registry{};
+    return *_v;
+}
+
+thread_comm_data&
+get_thread_comm_data()
+{
+    static thread_local auto* _v = []() {
+        auto* _data = new thread_comm_data{};
+        auto& _reg  = get_registry();
+        auto  _lk   = std::unique_lock<std::mutex>{ _reg.mutex };
+        _reg.data.emplace_back(_data);
+        return _data;
+    }();
+    return *_v;
+}
+
+template <typename Tp>
+uintptr_t
+get_comm_id(Tp _comm)
+{
+    // MPI_Comm is an integer in some implementations and a pointer in others
+    if constexpr(std::is_pointer<Tp>::value)
+        return reinterpret_cast<uintptr_t>(_comm);
+    else
+        return static_cast<uintptr_t>(_comm);
+}
+
+template <typename Tp>
+comm_key
+make_key(Tp _comm, comm_layout _layout, comm_dir _dir = comm_dir::none, int _peer = 0,
+         int _tag = 0)
+{
+    return comm_key{ nullptr, 0, get_comm_id(_comm), _peer, _tag, _layout, _dir };
+}
+
+// returns a hash of the instrumented regions which are active on this thread so that
+// the data can be nested within the call-graph of the regions when it is written.
+// The stack of region hashes is recorded the first time it is seen
+uint64_t
+get_region(thread_comm_data& _data)
+{
+    const auto& _bundles = tracing::get_instrumentation_bundles().bundles;
+
+    auto _ret = uint64_t{ 0 };
+    for(const auto* itr : _bundles)
+    {
+        if(itr) _ret = hash_combine(_ret, itr->get_hash());
+    }
+
+    if(_ret != 0 && _data.regions.count(_ret) == 0)
+    {
+        auto& _regions = _data.regions[_ret];
+        _regions.reserve(_bundles.size());
+        for(const auto* itr : _bundles)
+        {
+            if(itr) _regions.emplace_back(itr->get_hash());
+        }
+    }
+    return _ret;
+}
+
+comm_value*
+record(const gotcha_data& _data, comm_key _key, uint64_t _bytes)
+{
+    if(omnitrace::get_state() != omnitrace::State::Active) return nullptr;
+
+    auto& _thr = get_thread_comm_data();
+    _key.func  = &_data;
+    if(omnitrace::get_use_timemory()) _key.region = get_region(_thr);
+    auto& _v = _thr.entries[_key];
+    _v.count += 1;
+    _v.bytes += _bytes;
+    return &_v;
+}
+
+#    if defined(OMNITRACE_USE_MPI)
+bool
+has_peer(comm_layout _layout)
+{
+    return _layout != comm_layout::none && _layout != comm_layout::dir;
+}
+
+bool
+use_mpi_tables()
+{
+    return omnitrace::get_use_timemory() || config::get_mpip_comm_matrix();
+}
+
+// returns the rank in MPI_COMM_WORLD of the given rank in the communicator or -1
+// if it has none, e.g. MPI_ANY_SOURCE or MPI_PROC_NULL
+int32_t
+get_world_rank(MPI_Comm _comm, int _rank)
+{
+    if(_rank < 0 || _comm == MPI_COMM_NULL) return -1;
+    if(_comm == MPI_COMM_WORLD) return _rank;
+
+    // the ranks of an inter-communicator refer to the remote group
+    int       _inter = 0;
+    MPI_Group _group = MPI_GROUP_NULL;
+    PMPI_Comm_test_inter(_comm, &_inter);
+    auto _ret = (_inter != 0) ? PMPI_Comm_remote_group(_comm, &_group)
+                              : PMPI_Comm_group(_comm, &_group);
+    if(_ret != MPI_SUCCESS) return -1;
+
+    int       _world_rank  = MPI_UNDEFINED;
+    MPI_Group _world_group = MPI_GROUP_NULL;
+    if(PMPI_Comm_group(MPI_COMM_WORLD, &_world_group) == MPI_SUCCESS)
+    {
+        PMPI_Group_translate_ranks(_group, 1, &_rank, _world_group, &_world_rank);
+        PMPI_Group_free(&_world_group);
+    }
+    PMPI_Group_free(&_group);
+    return (_world_rank == MPI_UNDEFINED) ? -1 : _world_rank;
+}
+
+// the handle of a communicator may be reused by the MPI implementation after it is
+// freed so each communicator is identified by an incarnation which is cached as an
+// attribute of the communicator. The attribute is not copied when the communicator
+// is duplicated and it is released with the communicator
+uintptr_t
+get_comm_incarnation(MPI_Comm _comm)
+{
+    static std::atomic<uintptr_t> _count  = { 0 };
+    static int                    _keyval = []() {
+        int _v = MPI_KEYVAL_INVALID;
+        if(PMPI_Comm_create_keyval(MPI_COMM_NULL_COPY_FN, MPI_COMM_NULL_DELETE_FN, &_v,
+                                   nullptr) != MPI_SUCCESS)
+            return MPI_KEYVAL_INVALID;
+        return _v;
+    }();
+
+    if(_keyval == MPI_KEYVAL_INVALID || _comm == MPI_COMM_NULL)
+        return get_comm_id(_comm);
+
+    void* _attr = nullptr;
+    int   _flag = 0;
+    if(PMPI_Comm_get_attr(_comm, _keyval, &_attr, &_flag) == MPI_SUCCESS && _flag != 0)
+        return reinterpret_cast<uintptr_t>(_attr);
+
+    auto _v = ++_count;
+    PMPI_Comm_set_attr(_comm, _keyval, reinterpret_cast<void*>(_v));
+    return _v;
+}
+
 void
-write_perfetto_counter_track(uint64_t _val)
+record(const gotcha_data& _data, MPI_Comm _comm, comm_layout _layout, comm_dir _dir,
+       uint64_t _bytes, int _peer = 0, int _tag = 0)
 {
-    using counter_track = omnitrace::perfetto_counter_track<Tp>;
+    auto  _key = make_key(get_comm_incarnation(_comm), _layout, _dir, _peer, _tag);
+    auto* _v   = record(_data, _key, _bytes);
+    // the peer is translated once per entry while the communicator is known to be
+    // valid. The communicator may have been freed by the time the data is written
+    if(_v && _v->count == 1 && has_peer(_key.layout))
+        _v->world = get_world_rank(_comm, _key.peer);
+}
+#    endif
 
+// each thread accumulates into its own counter track so the hot path does not
+// need to synchronize with the other threads
+struct comm_counter_track
+{
+    perfetto::CounterTrack track;
+    uint64_t               value = 0;
+};
+
+template <typename Tp>
+comm_counter_track&
+get_comm_counter_track()
+{
+    static thread_local auto _v = []() {
+        auto _tid   = threading::get_id();
+        auto _label = std::string{ Tp::label };
+        if(_tid > 0)
+        {
+            const auto& _info = thread_info::get();
+            auto        _gen  = (_info) ? _info->generation : int64_t{ 0 };
+            _label            = (_gen > 0) ? JOIN("", _label, " [", _tid, '.', _gen, ']')
+                                           : JOIN("", _label, " [", _tid, ']');
+        }
+        return comm_counter_track{
+            perfetto::CounterTrack{ string_table::get(_label) }.set_unit_name("bytes"), 0
+        };
+    }();
+    return _v;
+}
+
+template <typename Tp>
+void
+write_perfetto_counter_track(uint64_t _val)
+{
     if(omnitrace::get_use_perfetto() &&
        omnitrace::get_state() == omnitrace::State::Active)
     {
-        auto _emplace = [](const size_t _idx) {
-            if(!counter_track::exists(_idx))
-            {
-                std::string _label = (_idx > 0)
-                                         ? JOIN(" ", Tp::label, JOIN("", '[', _idx, ']'))
-                                         : Tp::label;
-                counter_track::emplace(_idx, _label, "bytes");
-            }
-        };
+        auto& _track = get_comm_counter_track<Tp>();
+        _track.value += _val;
+        TRACE_COUNTER(Tp::value, _track.track, omnitrace::tracing::now<uint64_t>(),
+                      _track.value);
+    }
+}
 
-        const size_t          _idx = 0;
-        static std::once_flag _once{};
-        std::call_once(_once, _emplace, _idx);
+struct comm_node
+{
+    uint64_t                         count    = 0;
+    uint64_t                         bytes    = 0;
+    std::map<std::string, comm_node> children = {};
+};
+
+// returns the labels from the outermost to the innermost level and the level at
+// which the send and receive data are separated
+std::pair<std::vector<std::string>, size_t>
+get_path(const comm_key& _key)
+{
+    auto        _name = std::string_view{ _key.func->tool_id };
+    const char* _dir  = (_key.dir == comm_dir::recv) ? "recv" : "send";
+
+    switch(_key.layout)
+    {
+        case comm_layout::none: return { { std::string{ _name } }, 0 };
+        case comm_layout::dst_tag:
+            return { { std::string{ _name }, JOIN('_', _name, "dst", _key.peer),
+                       JOIN('_', _name, "dst", _key.peer, "tag", _key.tag) },
+                     0 };
+        case comm_layout::root:
+            return { { std::string{ _name }, JOIN('_', _name, "root", _key.peer) }, 0 };
+        case comm_layout::peer:
+            return { { std::string{ _name }, JOIN('_', _name, "peer", _key.peer) }, 0 };
+        case comm_layout::root_dir:
+            return { { std::string{ _name }, JOIN('_', _name, "root", _key.peer),
+                       JOIN('_', _name, "root", _key.peer, _dir) },
+                     2 };
+        case comm_layout::dir:
+            return { { std::string{ _name }, JOIN('_', _name, _dir) }, 1 };
+        case comm_layout::dir_dst_tag:
+            return { { std::string{ _name }, JOIN('_', _name, _dir),
+                       JOIN('_', _name, _dir, _key.peer),
+                       JOIN('_', _name, _dir, _key.peer, "tag", _key.tag) },
+                     1 };
+    }
+    return { { std::string{ _name } }, 0 };
+}
 
-        static std::mutex _mutex{};
-        static uint64_t   value = 0;
-        uint64_t          _now  = 0;
+// returns the labels of the regions which were active when the call was made. The
+// wrapper of the function itself is not included when it is the innermost region
+std::vector<std::string>
+get_region_path(const thread_comm_data& _data, const comm_key& _key)
+{
+    auto _ret = std::vector<std::string>{};
+    auto _itr = _data.regions.find(_key.region);
+    if(_itr == _data.regions.end()) return _ret;
+
+    _ret.reserve(_itr->second.size());
+    for(auto itr : _itr->second)
+    {
+        const auto* _name = string_table::find(itr);
+        _ret.emplace_back((_name) ? _name : "<unknown>");
+    }
+    if(!_ret.empty() && _ret.back() == _key.func->tool_id) _ret.pop_back();
+    return _ret;
+}
+
+void
+add_entry(std::map<std::string, comm_node>& _tree, std::vector<std::string> _path,
+          const comm_key& _key, const comm_value& _value)
+{
+    auto [_labels, _dir_level] = get_path(_key);
+    auto* _nodes               = &_tree;
+    _dir_level += _path.size();
+    _path.insert(_path.end(), _labels.begin(), _labels.end());
+    for(size_t i = 0; i < _path.size(); ++i)
+    {
+        auto& _node = (*_nodes)[_path.at(i)];
+        // calls which send and receive are recorded as two entries: only count
+        // one call above the level where the directions are separated
+        if(_key.dir != comm_dir::recv || i >= _dir_level) _node.count += _value.count;
+        _node.bytes += _value.bytes;
+        _nodes = &_node.children;
+    }
+}
+
+void
+write_node(int64_t _tid, const std::string& _name, const comm_node& _node)
+{
+    auto _bundle = comm_data::tracker_t{ tim::string_view_t{ _name } };
+    _bundle.push(_tid);
+    _bundle.start();
+    _bundle.store(std::plus<comm_data::data_type>{},
+                  static_cast<comm_data::data_type>(_node.bytes));
+    for(const auto& itr : _node.children)
+        write_node(_tid, itr.first, itr.second);
+    _bundle.stop();
+    auto* _tracker = _bundle.get<comm_data_tracker_t>();
+    if(_tracker) _tracker->set_laps(_node.count);
+    _bundle.pop();
+}
+#endif
+
+#if defined(OMNITRACE_USE_MPI)
+//--------------------------------------------------------------------------------------//
+//
+//                          COMMUNICATION MATRIX
+//
+//--------------------------------------------------------------------------------------//
+//
+//  The binary communication matrix file is laid out as:
+//
+//      header
+//      operation names (num_operations x name_size characters, null-padded)
+//      entries (num_entries x entry, sorted by src, dst, operation, direction)
+//
+//  Values are stored in the native byte order of the writer, which is recorded in
+//  the header. The src and dst of an entry are ranks in MPI_COMM_WORLD or -1 when
+//  the rank is unknown (e.g. MPI_ANY_SOURCE) or the operation has no peer.
+//
+namespace comm_matrix
+{
+constexpr char     magic[8]   = { 'O', 'M', 'N', 'I', 'C', 'M', 'T', 'X' };
+constexpr uint32_t version    = 1;
+constexpr uint32_t byte_order = 0x01020304;
+constexpr size_t   name_size  = 32;
+
+// the operations are identified by their index so that the entries of every rank
+// can be combined without exchanging any strings
+constexpr auto operations = std::array<std::string_view, 10>{
+    "MPI_Send",      "MPI_Recv",     "MPI_Isend",  "MPI_Irecv",   "MPI_Bcast",
+    "MPI_Allreduce", "MPI_Sendrecv", "MPI_Gather", "MPI_Scatter", "MPI_Alltoall"
+};
+
+constexpr auto directions = std::array<std::string_view, 3>{ "", "send", "recv" };
+
+struct header
+{
+    char     magic[8]       = {};
+    uint32_t version        = 0;
+    uint32_t byte_order     = 0;
+    uint32_t num_ranks      = 0;
+    uint32_t num_operations = 0;
+    uint64_t num_entries    = 0;
+};
+
+struct entry
+{
+    int32_t  src       = -1;
+    int32_t  dst       = -1;
+    uint16_t operation = 0;
+    uint16_t direction = 0;  // index into directions
+    uint32_t reserved  = 0;
+    uint64_t messages  = 0;
+    uint64_t bytes     = 0;
+
+    auto key() const { return std::tie(src, dst, operation, direction); }
+};
+
+static_assert(sizeof(entry) == 32, "comm matrix entries must be 32 bytes");
+
+bool
+is_point_to_point(comm_layout _layout)
+{
+    return _layout == comm_layout::dst_tag || _layout == comm_layout::dir_dst_tag;
+}
+
+// for the point-to-point operations, the received messages are attributed to the
+// sender so that src -> dst always describes the flow of the data. The collectives
+// are attributed to the rank which called them and the root, if any.
+std::vector<entry>
+get_local_entries(int32_t _rank)
+{
+    auto _data = std::map<std::tuple<int32_t, int32_t, uint16_t, uint16_t>, entry>{};
+
+    auto& _reg = get_registry();
+    auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+    for(const auto* itr : _reg.data)
+    {
+        for(const auto& eitr : itr->entries)
+        {
+            const auto& _key = eitr.first;
+            const auto& _val = eitr.second;
+            auto        _op  = std::find(operations.begin(), operations.end(),
+                                   std::string_view{ _key.func->tool_id });
+            if(_op == operations.end()) continue;
+
+            auto _v      = entry{};
+            _v.src       = _rank;
+            _v.dst       = _val.world;
+            _v.operation = static_cast<uint16_t>(std::distance(operations.begin(), _op));
+            _v.direction = static_cast<uint16_t>(_key.dir);
+            if(_key.dir == comm_dir::recv && is_point_to_point(_key.layout))
+                std::swap(_v.src, _v.dst);
+
+            auto& _entry = _data.emplace(_v.key(), _v).first->second;
+            _entry.messages += _val.count;
+            _entry.bytes += _val.bytes;
+        }
+    }
+
+    auto _ret = std::vector<entry>{};
+    _ret.reserve(_data.size());
+    for(const auto& itr : _data)
+        _ret.emplace_back(itr.second);
+    return _ret;
+}
+
+// the entries of each rank are disjoint so collecting them on rank 0 is sufficient
+// to combine them and the MPI implementation is free to use a tree for the gather.
+// The counts are in units of entries so that they do not overflow before the number
+// of entries does
+std::vector<entry>
+gather_entries(const std::vector<entry>& _local, int _rank, int _size)
+{
+    constexpr auto _max = static_cast<size_t>(std::numeric_limits<int>::max());
+
+    if(_local.size() > _max)
+    {
+        OMNITRACE_THROW("[comm-matrix] rank %i has too many entries to gather: %zu\n",
+                        _rank, _local.size());
+    }
+
+    auto _nentries = static_cast<int>(_local.size());
+    auto _counts   = std::vector<int>(static_cast<size_t>((_rank == 0) ? _size : 0), 0);
+    PMPI_Gather(&_nentries, 1, MPI_INT, _counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    auto _displs = std::vector<int>(_counts.size(), 0);
+    auto _total  = size_t{ 0 };
+    for(size_t i = 0; i < _counts.size(); ++i)
+    {
+        if(_total > _max)
         {
-            std::unique_lock<std::mutex> _lk{ _mutex };
-            _now = omnitrace::tracing::now<uint64_t>();
-            _val = (value += _val);
+            OMNITRACE_THROW("[comm-matrix] too many entries to gather: %zu\n", _total);
         }
+        _displs.at(i) = static_cast<int>(_total);
+        _total += _counts.at(i);
+    }
+
+    auto _type = MPI_Datatype{ MPI_DATATYPE_NULL };
+    PMPI_Type_contiguous(static_cast<int>(sizeof(entry)), MPI_BYTE, &_type);
+    PMPI_Type_commit(&_type);
 
-        TRACE_COUNTER(Tp::value, counter_track::at(_idx, 0), _now, _val);
+    auto _ret = std::vector<entry>(_total);
+    PMPI_Gatherv(_local.data(), _nentries, _type, _ret.data(), _counts.data(),
+                 _displs.data(), _type, 0, MPI_COMM_WORLD);
+
+    PMPI_Type_free(&_type);
+    return _ret;
+}
+
+bool
+write_binary(const std::string& _fname, const std::vector<entry>& _data, int _size)
+{
+    auto _header = header{};
+    std::memcpy(_header.magic, magic, sizeof(magic));
+    _header.version        = version;
+    _header.byte_order     = byte_order;
+    _header.num_ranks      = static_cast<uint32_t>(_size);
+    _header.num_operations = operations.size();
+    _header.num_entries    = _data.size();
+
+    std::ofstream _ofs{};
+    if(!tim::filepath::open(_ofs, _fname, std::ios::out | std::ios::binary))
+        return false;
+
+    _ofs.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+    for(auto itr : operations)
+    {
+        char _name[name_size] = {};
+        std::memcpy(_name, itr.data(), std::min(itr.length(), name_size - 1));
+        _ofs.write(_name, name_size);
     }
+    _ofs.write(reinterpret_cast<const char*>(_data.data()), _data.size() * sizeof(entry));
+
+    return _ofs.good();
 }
+
+bool
+write_csv(const std::string& _fname, const std::vector<entry>& _data)
+{
+    std::ofstream _ofs{};
+    if(!tim::filepath::open(_ofs, _fname)) return false;
+
+    _ofs << "src,dst,operation,direction,messages,bytes\n";
+    for(const auto& itr : _data)
+    {
+        _ofs << itr.src << ',' << itr.dst << ',' << operations.at(itr.operation) << ','
+             << directions.at(itr.direction) << ',' << itr.messages << ',' << itr.bytes
+             << '\n';
+    }
+
+    return _ofs.good();
+}
+
+void
+post_process()
+{
+    int  _rank    = tim::mpi::rank();
+    int  _size    = tim::mpi::size();
+    int  _init    = 0;
+    int  _fini    = 0;
+    auto _use_mpi = (PMPI_Initialized(&_init) == MPI_SUCCESS && _init != 0 &&
+                     PMPI_Finalized(&_fini) == MPI_SUCCESS && _fini == 0);
+
+    if(_use_mpi)
+    {
+        PMPI_Comm_rank(MPI_COMM_WORLD, &_rank);
+        PMPI_Comm_size(MPI_COMM_WORLD, &_size);
+    }
+
+    auto _data = get_local_entries(_rank);
+    if(_use_mpi)
+    {
+        _data = gather_entries(_data, _rank, _size);
+        if(_rank != 0) return;
+    }
+    else
+    {
+        // without MPI, every rank writes its own entries to a file with its rank
+        // as the suffix so that the files can be concatenated
+        OMNITRACE_VERBOSE(0,
+                          "[comm-matrix] MPI is not active. Only the entries of rank %i "
+                          "are written\n",
+                          _rank);
+    }
+
+    std::sort(_data.begin(), _data.end(), [](const entry& _lhs, const entry& _rhs) {
+        return _lhs.key() < _rhs.key();
+    });
+
+    OMNITRACE_VERBOSE(0, "[comm-matrix] %zu entries from %i ranks\n", _data.size(),
+                      _size);
+
+    auto _bin_fname = tim::settings::compose_output_filename("comm-matrix", ".bin");
+    if(write_binary(_bin_fname, _data, _size))
+    {
+        OMNITRACE_VERBOSE(0, "[comm-matrix] Outputting '%s'...\n", _bin_fname.c_str());
+    }
+    else
+    {
+        OMNITRACE_PRINT("[comm-matrix] Error writing '%s'\n", _bin_fname.c_str());
+    }
+
+    auto _csv_fname = tim::settings::compose_output_filename("comm-matrix", ".csv");
+    if(write_csv(_csv_fname, _data))
+    {
+        OMNITRACE_VERBOSE(0, "[comm-matrix] Outputting '%s'...\n", _csv_fname.c_str());
+    }
+    else
+    {
+        OMNITRACE_PRINT("[comm-matrix] Error writing '%s'\n", _csv_fname.c_str());
+    }
+}
+}  // namespace comm_matrix
+#endif
 }  // namespace
 
 void
@@ -105,104 +735,115 @@ comm_data::configure()
     comm_data_tracker_t::set_format_flags(_fmt_flags);
 }
 
+void
+comm_data::post_process()
+{
+#if defined(OMNITRACE_USE_MPI)
+    if(get_use_mpip() && get_mpip_comm_matrix()) comm_matrix::post_process();
+#endif
+
+#if defined(OMNITRACE_USE_MPI) || defined(OMNITRACE_USE_RCCL)
+    if(!omnitrace::get_use_timemory()) return;
+
+    configure();
+
+    // the entries are nested within the regions which were active at the time of the
+    // call. threads which shared an index are combined
+    auto _data = std::map<int64_t, std::map<std::string, comm_node>>{};
+    {
+        auto& _reg = get_registry();
+        auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+        for(const auto* itr : _reg.data)
+        {
+            for(const auto& eitr : itr->entries)
+                add_entry(_data[itr->tid], get_region_path(*itr, eitr.first), eitr.first,
+                          eitr.second);
+        }
+    }
+
+    for(const auto& titr : _data)
+    {
+        for(const auto& itr : titr.second)
+            write_node(titr.first, itr.first, itr.second);
+    }
+#endif
+}
+
 #if defined(OMNITRACE_USE_MPI)
 // MPI_Send
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int count,
-                 MPI_Datatype datatype, int dst, int tag, MPI_Comm)
+                 MPI_Datatype datatype, int dst, int tag, MPI_Comm comm)
 {
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(count * _size);
 
-    if(!omnitrace::get_use_timemory()) return;
-    auto      _name = std::string_view{ _data.tool_id };
-    tracker_t _a{ _name };
-    add(_a, count * _size);
-    tracker_t _b{ JOIN('_', _name, "dst", dst) };
-    add(_b, count * _size);
-    add(JOIN('_', _name, "dst", dst, "tag", tag), count * _size);
+    if(!use_mpi_tables()) return;
+    record(_data, comm, comm_layout::dst_tag, comm_dir::send, count * _size, dst, tag);
 }
 
 // MPI_Recv
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
-                 MPI_Datatype datatype, int dst, int tag, MPI_Comm, MPI_Status*)
+                 MPI_Datatype datatype, int dst, int tag, MPI_Comm comm, MPI_Status*)
 {
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_recv>(count * _size);
 
-    if(!omnitrace::get_use_timemory()) return;
-    auto      _name = std::string_view{ _data.tool_id };
-    tracker_t _a{ _name };
-    add(_a, count * _size);
-    tracker_t _b{ JOIN('_', _name, "dst", dst) };
-    add(_b, count * _size);
-    add(JOIN('_', _name, "dst", dst, "tag", tag), count * _size);
+    if(!use_mpi_tables()) return;
+    record(_data, comm, comm_layout::dst_tag, comm_dir::recv, count * _size, dst, tag);
 }
 
 // MPI_Isend
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int count,
-                 MPI_Datatype datatype, int dst, int tag, MPI_Comm, MPI_Request*)
+                 MPI_Datatype datatype, int dst, int tag, MPI_Comm comm, MPI_Request*)
 {
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(count * _size);
 
-    if(!omnitrace::get_use_timemory()) return;
-    auto      _name = std::string_view{ _data.tool_id };
-    tracker_t _a{ _name };
-    add(_a, count * _size);
-    tracker_t _b{ JOIN('_', _name, "dst", dst) };
-    add(_b, count * _size);
-    add(JOIN('_', _name, "dst", dst, "tag", tag), count * _size);
+    if(!use_mpi_tables()) return;
+    record(_data, comm, comm_layout::dst_tag, comm_dir::send, count * _size, dst, tag);
 }
 
 // MPI_Irecv
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
-                 MPI_Datatype datatype, int dst, int tag, MPI_Comm, MPI_Request*)
+                 MPI_Datatype datatype, int dst, int tag, MPI_Comm comm, MPI_Request*)
 {
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_recv>(count * _size);
 
-    if(!omnitrace::get_use_timemory()) return;
-    auto      _name = std::string_view{ _data.tool_id };
-    tracker_t _a{ _name };
-    add(_a, count * _size);
-    tracker_t _b{ JOIN('_', _name, "dst", dst) };
-    add(_b, count * _size);
-    add(JOIN('_', _name, "dst", dst, "tag", tag), count * _size);
+    if(!use_mpi_tables()) return;
+    record(_data, comm, comm_layout::dst_tag, comm_dir::recv, count * _size, dst, tag);
 }
 
 // MPI_Bcast
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, void*, int count,
-                 MPI_Datatype datatype, int root, MPI_Comm)
+                 MPI_Datatype datatype, int root, MPI_Comm comm)
 {
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
 
     write_perfetto_counter_track<mpi_send>(count * _size);
 
-    if(!omnitrace::get_use_timemory()) return;
-    auto      _name = std::string_view{ _data.tool_id };
-    tracker_t _t{ _name };
-    add(_t, count * _size);
-    add(JOIN('_', _name, "root", root), count * _size);
+    if(!use_mpi_tables()) return;
+    record(_data, comm, comm_layout::root, comm_dir::none, count * _size, root);
 }
 
 // MPI_Allreduce
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, void*, int count,
-                 MPI_Datatype datatype, MPI_Op, MPI_Comm)
+                 MPI_Datatype datatype, MPI_Op, MPI_Comm comm)
 {
     int _size = mpi_type_size(datatype);
     if(_size == 0) return;
@@ -210,15 +851,15 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, void*,
     write_perfetto_counter_track<mpi_recv>(count * _size);
     write_perfetto_counter_track<mpi_send>(count * _size);
 
-    if(!omnitrace::get_use_timemory()) return;
-    add(_data, count * _size);
+    if(!use_mpi_tables()) return;
+    record(_data, comm, comm_layout::none, comm_dir::none, count * _size);
 }
 
 // MPI_Sendrecv
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sendcount,
                  MPI_Datatype sendtype, int dst, int sendtag, void*, int recvcount,
-                 MPI_Datatype recvtype, int src, int recvtag, MPI_Comm, MPI_Status*)
+                 MPI_Datatype recvtype, int src, int recvtag, MPI_Comm comm, MPI_Status*)
 {
     int _send_size = mpi_type_size(sendtype);
     int _recv_size = mpi_type_size(recvtype);
@@ -227,26 +868,11 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sen
     write_perfetto_counter_track<mpi_send>(sendcount * _send_size);
     write_perfetto_counter_track<mpi_recv>(recvcount * _recv_size);
 
-    if(!omnitrace::get_use_timemory()) return;
-    auto      _name = std::string_view{ _data.tool_id };
-    tracker_t _t{ _name };
-    add(_t, sendcount * _send_size + recvcount * _recv_size);
-    {
-        tracker_t _b{ JOIN('_', _name, "send") };
-        add(_b, sendcount * _send_size);
-        tracker_t _c{ JOIN('_', _name, "send", dst) };
-        add(_b, sendcount * _send_size);
-        add(JOIN('_', _name, "send", "tag", sendtag), sendcount * _send_size);
-        add(JOIN('_', _name, "send", dst, "tag", sendtag), sendcount * _send_size);
-    }
-    {
-        tracker_t _b{ JOIN('_', _name, "recv") };
-        add(_b, recvcount * _recv_size);
-        tracker_t _c{ JOIN('_', _name, "recv", src) };
-        add(_b, recvcount * _recv_size);
-        add(JOIN('_', _name, "recv", "tag", recvtag), recvcount * _recv_size);
-        add(JOIN('_', _name, "recv", src, "tag", recvtag), recvcount * _recv_size);
-    }
+    if(!use_mpi_tables()) return;
+    record(_data, comm, comm_layout::dir_dst_tag, comm_dir::send, sendcount * _send_size,
+           dst, sendtag);
+    record(_data, comm, comm_layout::dir_dst_tag, comm_dir::recv, recvcount * _recv_size,
+           src, recvtag);
 }
 
 // MPI_Gather
@@ -254,7 +880,7 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sen
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sendcount,
                  MPI_Datatype sendtype, void*, int recvcount, MPI_Datatype recvtype,
-                 int root, MPI_Comm)
+                 int root, MPI_Comm comm)
 {
     int _send_size = mpi_type_size(sendtype);
     int _recv_size = mpi_type_size(recvtype);
@@ -263,21 +889,18 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sen
     write_perfetto_counter_track<mpi_send>(sendcount * _send_size);
     write_perfetto_counter_track<mpi_recv>(recvcount * _recv_size);
 
-    if(!omnitrace::get_use_timemory()) return;
-    auto      _name = std::string_view{ _data.tool_id };
-    tracker_t _t{ _name };
-    add(_t, sendcount * _send_size + recvcount * _recv_size);
-    tracker_t _r(JOIN('_', _name, "root", root));
-    add(_r, sendcount * _send_size + recvcount * _recv_size);
-    add(JOIN('_', _name, "root", root, "send"), sendcount * _send_size);
-    add(JOIN('_', _name, "root", root, "recv"), recvcount * _recv_size);
+    if(!use_mpi_tables()) return;
+    record(_data, comm, comm_layout::root_dir, comm_dir::send, sendcount * _send_size,
+           root);
+    record(_data, comm, comm_layout::root_dir, comm_dir::recv, recvcount * _recv_size,
+           root);
 }
 
 // MPI_Alltoall
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sendcount,
                  MPI_Datatype sendtype, void*, int recvcount, MPI_Datatype recvtype,
-                 MPI_Comm)
+                 MPI_Comm comm)
 {
     int _send_size = mpi_type_size(sendtype);
     int _recv_size = mpi_type_size(recvtype);
@@ -286,12 +909,9 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sen
     write_perfetto_counter_track<mpi_send>(sendcount * _send_size);
     write_perfetto_counter_track<mpi_recv>(recvcount * _recv_size);
 
-    if(!omnitrace::get_use_timemory()) return;
-    auto      _name = std::string_view{ _data.tool_id };
-    tracker_t _t{ _name };
-    add(_t, sendcount * _send_size + recvcount * _recv_size);
-    add(JOIN('_', _name, "send"), sendcount * _send_size);
-    add(JOIN('_', _name, "recv"), recvcount * _recv_size);
+    if(!use_mpi_tables()) return;
+    record(_data, comm, comm_layout::dir, comm_dir::send, sendcount * _send_size);
+    record(_data, comm, comm_layout::dir, comm_dir::recv, recvcount * _recv_size);
 }
 #endif
 
@@ -299,8 +919,8 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, int sen
 // ncclReduce
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
-                 size_t count, ncclDataType_t datatype, ncclRedOp_t, int root, ncclComm_t,
-                 hipStream_t)
+                 size_t count, ncclDataType_t datatype, ncclRedOp_t, int root,
+                 ncclComm_t comm, hipStream_t)
 {
     int _size = rccl_type_size(datatype);
     if(_size <= 0) return;
@@ -308,10 +928,8 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const v
     write_perfetto_counter_track<rccl_recv>(count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
-    auto      _name = std::string_view{ _data.tool_id };
-    tracker_t _t{ _name };
-    add(_t, count * _size);
-    add(JOIN('_', _name, "root", root), count * _size);
+    record(_data, make_key(comm, comm_layout::root, comm_dir::none, root),
+           count * _size);
 }
 
 // ncclSend
@@ -320,7 +938,7 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const v
 // ncclRecv
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, size_t count,
-                 ncclDataType_t datatype, int peer, ncclComm_t, hipStream_t)
+                 ncclDataType_t datatype, int peer, ncclComm_t comm, hipStream_t)
 {
     int _size = rccl_type_size(datatype);
     if(_size <= 0) return;
@@ -341,22 +959,17 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, size_t
         OMNITRACE_CI_THROW(true, "RCCL function not handled: %s", _data.tool_id.c_str());
     }
 
-    write_perfetto_counter_track<rccl_recv>(count * _size);
-
     if(!omnitrace::get_use_timemory()) return;
-    auto        _name  = std::string_view{ _data.tool_id };
-    std::string _label = "root";
-    if(_name.find("Send") != std::string::npos) _label = "peer";
-
-    tracker_t _t{ _name };
-    add(_t, count * _size);
-    add(JOIN('_', _name, _label, peer), count * _size);
+    auto _layout = (_data.tool_id.find("Send") != std::string::npos) ? comm_layout::peer
+                                                                     : comm_layout::root;
+    record(_data, make_key(comm, _layout, comm_dir::none, peer), count * _size);
 }
 
 // ncclBroadcast
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
-                 size_t count, ncclDataType_t datatype, int root, ncclComm_t, hipStream_t)
+                 size_t count, ncclDataType_t datatype, int root, ncclComm_t comm,
+                 hipStream_t)
 {
     int _size = rccl_type_size(datatype);
     if(_size <= 0) return;
@@ -364,17 +977,15 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const v
     write_perfetto_counter_track<rccl_send>(count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
-    auto      _name = std::string_view{ _data.tool_id };
-    tracker_t _t{ _name };
-    add(_t, count * _size);
-    add(JOIN('_', _data.tool_id, "root", root), count * _size);
+    record(_data, make_key(comm, comm_layout::root, comm_dir::none, root),
+           count * _size);
 }
 
 // ncclAllReduce
 // ncclReduceScatter
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
-                 size_t count, ncclDataType_t datatype, ncclRedOp_t, ncclComm_t,
+                 size_t count, ncclDataType_t datatype, ncclRedOp_t, ncclComm_t comm,
                  hipStream_t)
 {
     int _size = rccl_type_size(datatype);
@@ -397,13 +1008,13 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const v
     }
 
     if(!omnitrace::get_use_timemory()) return;
-    add(_data, count * _size);
+    record(_data, make_key(comm, comm_layout::none), count * _size);
 }
 
 // ncclAllGather
 void
 comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const void*,
-                 size_t count, ncclDataType_t datatype, ncclComm_t, hipStream_t)
+                 size_t count, ncclDataType_t datatype, ncclComm_t comm, hipStream_t)
 {
     int _size = rccl_type_size(datatype);
     if(_size <= 0) return;
@@ -411,7 +1022,7 @@ comm_data::audit(const gotcha_data& _data, audit::incoming, const void*, const v
     write_perfetto_counter_track<rccl_recv>(count * _size);
 
     if(!omnitrace::get_use_timemory()) return;
-    add(_data, count * _size);
+    record(_data, make_key(comm, comm_layout::none), count * _size);
 }
 #endif
 }  // namespace component
@@ -70,7 +70,7 @@ struct comm_data : base<comm_data, void>
     using value_type = void;
     using this_type  = comm_data;
     using base_type  = base<this_type, value_type>;
-    using tracker_t  = tim::auto_tuple<comm_data_tracker_t>;
+    using tracker_t  = tim::lightweight_tuple<comm_data_tracker_t>;
     using data_type  = float;
 
     struct mpi_recv
@@ -102,6 +102,7 @@ struct comm_data : base<comm_data, void>
     static void preinit();
     static void configure();
     static void global_finalize();
+    static void post_process();
     static void start() {}
     static void stop() {}
 
@@ -204,35 +205,6 @@ struct comm_data : base<comm_data, void>
 
 #endif
 
-private:
-    static auto& add(tracker_t& _t, data_type value)
-    {
-        if(omnitrace::get_state() != omnitrace::State::Active)
-        {
-            _t.invoke<operation::set_is_invalid>(true);
-            return _t;
-        }
-        _t.store(std::plus<data_type>{}, value);
-        return _t;
-    }
-
-    static auto&& add(const gotcha_data& _data, data_type value)
-    {
-        tracker_t _t{ std::string_view{ _data.tool_id.c_str() } };
-        return add(_t, value);
-    }
-
-    static auto&& add(std::string&& _name, data_type value)
-    {
-        tracker_t _t{ _name };
-        return add(_t, value);
-    }
-
-    static auto&& add(std::string_view _name, data_type value)
-    {
-        tracker_t _t{ _name };
-        return add(_t, value);
-    }
 };
 }  // namespace component
 }  // namespace omnitrace
@@ -24,12 +24,14 @@
 #include "library/components/category_region.hpp"
 #include "library/components/roctracer.hpp"
 #include "library/config.hpp"
+#include "library/critical_trace.hpp"
 #include "library/debug.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 #include "library/state.hpp"
 #include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
+#include "library/timestamp.hpp"
 #include "library/utility.hpp"
 
 #include <timemory/backends/threading.hpp>
@@ -38,8 +40,15 @@
 #include <timemory/sampling/allocator.hpp>
 #include <timemory/utility/types.hpp>
 
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <ostream>
 #include <pthread.h>
+#include <set>
 
 namespace omnitrace
 {
@@ -69,6 +78,110 @@ auto  bundles_dtor  = scope::destructor{ []() {
     bundles_mutex   = nullptr;
 } };
 
+// the parent thread does not wait on the child thread to complete its setup. In order
+// for the thread indices to be assigned in the order the threads were created, each
+// thread is given a sequence number by the parent and the child threads take turns
+// assigning their indices. A child only waits when a thread created before it has not
+// started yet. There is no timeout: every thread which was successfully created runs
+// the wrapper, which disables cancellation until its turn has been released. The
+// threads which had not released their turn when the process forked do not exist in
+// the child process so the sequence is reset in the child
+struct thread_sequence
+{
+    uint64_t reserve() { return m_next++; }
+
+    // wait until all the threads created before this thread have been assigned an
+    // index
+    void wait(uint64_t _v)
+    {
+        if(m_turn.load(std::memory_order_acquire) >= _v) return;
+        auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+        m_cv.wait(_lk, [this, _v]() { return m_turn.load() >= _v; });
+    }
+
+    // verifies that the index is greater than the index of every thread created
+    // before it. Only called while it is the turn of the thread
+    void check(uint64_t _v, int64_t _index)
+    {
+        OMNITRACE_VERBOSE(2, "[pthread_create] thread sequence %lu assigned TID %li\n",
+                          static_cast<unsigned long>(_v), _index);
+        if(_index <= m_last_index)
+        {
+            OMNITRACE_VERBOSE(0,
+                              "[pthread_create] thread indices were assigned out of "
+                              "creation order: thread sequence %lu assigned TID %li "
+                              "after TID %li\n",
+                              static_cast<unsigned long>(_v), _index, m_last_index);
+        }
+        m_last_index = _index;
+    }
+
+    // the thread with the given sequence number has been assigned an index
+    void release(uint64_t _v)
+    {
+        {
+            auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+            advance(_v);
+        }
+        m_cv.notify_all();
+    }
+
+    // the thread with the given sequence number was not created
+    void skip(uint64_t _v)
+    {
+        {
+            auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+            if(m_turn.load() == _v)
+                advance(_v);
+            else if(m_turn.load() < _v)
+                m_skipped.emplace(_v);
+        }
+        m_cv.notify_all();
+    }
+
+    // called in the child process after a fork. Only the forking thread exists in the
+    // child so the mutex may be held (and the set modified) by a thread which no
+    // longer exists. The previous values are leaked instead of destroyed
+    void reset()
+    {
+        new(&m_mutex) std::mutex{};
+        new(&m_cv) std::condition_variable{};
+        new(&m_skipped) std::set<uint64_t>{};
+        m_turn.store(m_next.load(), std::memory_order_release);
+    }
+
+private:
+    void advance(uint64_t _v)
+    {
+        auto _next = std::max<uint64_t>(m_turn.load(), _v + 1);
+        while(!m_skipped.empty() && *m_skipped.begin() <= _next)
+        {
+            if(*m_skipped.begin() == _next) ++_next;
+            m_skipped.erase(m_skipped.begin());
+        }
+        m_turn.store(_next, std::memory_order_release);
+    }
+
+    std::atomic<uint64_t>   m_next       = { 0 };
+    std::atomic<uint64_t>   m_turn       = { 0 };
+    int64_t                 m_last_index = 0;
+    std::set<uint64_t>      m_skipped    = {};
+    std::mutex              m_mutex      = {};
+    std::condition_variable m_cv         = {};
+};
+
+thread_sequence&
+get_thread_sequence()
+{
+    // intentional leak: child threads may still be starting during exit
+    static auto* _v = []() {
+        auto* _seq = new thread_sequence{};
+        pthread_atfork(nullptr, nullptr, []() { get_thread_sequence().reset(); });
+        return _seq;
+    }();
+    return *_v;
+}
+
 template <typename... Args>
 inline void
 start_bundle(bundle_t& _bundle, Args&&... _args)
@@ -132,27 +245,59 @@ stop_bundle(bundle_t& _bundle, int64_t _tid, Args&&... _args)
 //--------------------------------------------------------------------------------------//
 
 pthread_create_gotcha::wrapper::wrapper(routine_t _routine, void* _arg,
-                                        bool _enable_sampling, int64_t _parent,
-                                        promise_t* _p)
+                                        bool _enable_sampling, uint64_t _sequence,
+                                        cid_stack_t&&   _cid_stack,
+                                        const sigset_t* _sigmask)
 : m_enable_sampling{ _enable_sampling }
-, m_parent_tid{ _parent }
+, m_restore_sigmask{ _sigmask != nullptr }
+, m_sequence{ _sequence }
 , m_routine{ _routine }
 , m_arg{ _arg }
-, m_promise{ _p }
-{}
+, m_cid_stack{ std::move(_cid_stack) }
+{
+    if(_sigmask) m_sigmask = *_sigmask;
+}
+
+void
+pthread_create_gotcha::wrapper::restore_sigmask() const
+{
+    // the parent blocked the sampling signals while this thread was created. When
+    // this thread does not start a sampler, the signal mask of the parent is restored
+    // so that this thread and the threads it creates do not keep them blocked
+    if(m_restore_sigmask) pthread_sigmask(SIG_SETMASK, &m_sigmask, nullptr);
+}
 
 void*
 pthread_create_gotcha::wrapper::operator()() const
 {
     using thread_bundle_data_t = thread_data<thread_bundle_t>;
 
+    auto& _sequence = get_thread_sequence();
+
     if(is_shutdown && *is_shutdown)
     {
-        if(m_promise) m_promise->set_value();
+        _sequence.release(m_sequence);
+        restore_sigmask();
         // execute the original function
         return m_routine(m_arg);
     }
 
+    auto _coverage = (get_mode() == Mode::Coverage);
+    auto _active   = (get_state() == ::omnitrace::State::Active && bundles != nullptr &&
+                     bundles_mutex != nullptr);
+
+    // assign the thread indices in the order the threads were created. This must
+    // precede anything which queries the thread index. Cancellation is disabled so
+    // that this thread always releases its turn to the threads created after it
+    int _cancel_state = PTHREAD_CANCEL_ENABLE;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, &_cancel_state);
+    _sequence.wait(m_sequence);
+    const auto& _tid_info = thread_info::init(!_active || _coverage);
+    if(!_tid_info->is_offset && !threading::recycle_ids())
+        _sequence.check(m_sequence, _tid_info->index_data->internal_value);
+    _sequence.release(m_sequence);
+    pthread_setcancelstate(_cancel_state, nullptr);
+
     push_thread_state(ThreadState::Internal);
 
     int64_t _tid         = -1;
@@ -160,8 +305,7 @@ pthread_create_gotcha::wrapper::operator()() const
     auto    _is_sampling = false;
     auto    _bundle      = std::shared_ptr<bundle_t>{};
     auto    _signals     = std::set<int>{};
-    auto    _coverage    = (get_mode() == Mode::Coverage);
-    // const auto& _parent_info = thread_info::get(m_parent_tid, LookupTID);
+
     auto _dtor = [&]() {
         set_thread_state(ThreadState::Internal);
         if(_is_sampling)
@@ -175,31 +319,42 @@ pthread_create_gotcha::wrapper::operator()() const
             auto _active = (get_state() == ::omnitrace::State::Active &&
                             bundles != nullptr && bundles_mutex != nullptr);
             if(!_active) return;
-            thread_info::set_stop(comp::wall_clock::record());
+            thread_info::set_stop(timestamp::now());
             auto& _thr_bundle = thread_bundle_data_t::instance();
             if(_thr_bundle && _thr_bundle->get<comp::wall_clock>() &&
                _thr_bundle->get<comp::wall_clock>()->get_is_running())
                 _thr_bundle->stop();
             if(_bundle) stop_bundle(*_bundle, _tid);
             pthread_create_gotcha::shutdown(_tid);
+            // the index of this thread may be assigned to the next thread which is
+            // created so the data of this thread is flushed or moved out of its slot
+            if(threading::recycle_ids())
+            {
+                critical_trace::update(_tid);
+                if(_is_sampling) sampling::retire();
+            }
         }
     };
 
-    auto _active = (get_state() == ::omnitrace::State::Active && bundles != nullptr &&
-                    bundles_mutex != nullptr);
-
     if(_active && !_coverage)
     {
-        const auto& _tid_index = thread_info::init();
-        _tid                   = _tid_index->index_data->internal_value;
-        threading::set_thread_name(TIMEMORY_JOIN(" ", "Thread", _tid).c_str());
-        if(!thread_bundle_data_t::instances().at(_tid))
+        _tid = _tid_info->index_data->internal_value;
+        threading::set_thread_name(_tid_info->get_label().c_str());
+        auto& _thr_bundle = thread_bundle_data_t::instances().at(_tid);
+        if(!_thr_bundle)
         {
             thread_data<thread_bundle_t>::construct(
                 TIMEMORY_JOIN('/', "omnitrace/process", process::get_id(), "thread",
                               _tid),
                 quirk::config<quirk::auto_start>{});
-            thread_bundle_data_t::instances().at(_tid)->start();
+            _thr_bundle->start();
+        }
+        else if(_thr_bundle->get<comp::wall_clock>() &&
+                !_thr_bundle->get<comp::wall_clock>()->get_is_running())
+        {
+            // this index was recycled: the thread which was previously assigned this
+            // index stopped the bundle and the time of this thread is accumulated in it
+            _thr_bundle->start();
         }
         if(bundles && bundles_mutex)
         {
@@ -208,7 +363,11 @@ pthread_create_gotcha::wrapper::operator()() const
                           .first->second;
         }
         if(_bundle) start_bundle(*_bundle);
-        get_cpu_cid_stack(_tid, m_parent_tid);
+        // the call-ids of the parent were copied when the thread was created since
+        // the parent thread continues to modify them. When this index was recycled,
+        // this replaces the call-ids left behind by the previous thread
+        auto& _cid_stack = get_cpu_cid_stack(_tid, _tid);
+        if(_cid_stack) *_cid_stack = m_cid_stack;
         if(m_enable_sampling)
         {
             _is_sampling = true;
@@ -217,13 +376,8 @@ pthread_create_gotcha::wrapper::operator()() const
             sampling::unblock_signals();
         }
     }
-    else
-    {
-        thread_info::init(true);
-    }
 
-    // notify the wrapper that all internal work is completed
-    if(m_promise) m_promise->set_value();
+    if(!_is_sampling) restore_sigmask();
 
     // Internal -> Enabled
     pop_thread_state();
@@ -248,8 +402,8 @@ pthread_create_gotcha::wrapper::wrap(void* _arg)
 {
     if(_arg == nullptr) return nullptr;
 
-    // convert the argument
-    wrapper* _wrapper = static_cast<wrapper*>(_arg);
+    // convert the argument. The wrapper is allocated by the parent thread
+    auto _wrapper = std::unique_ptr<wrapper>{ static_cast<wrapper*>(_arg) };
 
     // execute the original function
     return (*_wrapper)();
@@ -347,23 +501,39 @@ pthread_create_gotcha::operator()(pthread_t* thread, const pthread_attr_t* attr,
                           process::get_id(), dmp::rank(), _tid);
     }
 
-    // ensure that cpu cid stack exists on the parent thread if active
-    if(_active && !_coverage) get_cpu_cid_stack();
-
-    set_thread_state(ThreadState::Disabled);
-    auto  _blocked = get_sampling_signals();
-    auto  _promise = std::promise<void>{};
-    auto  _fut     = _promise.get_future();
-    auto* _wrap    = new wrapper(start_routine, arg, _enable_sampling, _tid, &_promise);
-    set_thread_state(ThreadState::Internal);
+    // ensure that cpu cid stack exists on the parent thread if active and copy it
+    // for the child thread
+    auto _cid_stack = wrapper::cid_stack_t{};
+    if(_active && !_coverage)
+    {
+        tim::auto_lock_t _lk{ get_cpu_cid_stack_lock() };
+        _cid_stack = *get_cpu_cid_stack();
+    }
 
-    // block the signals in entire process
+    // block the signals on this thread while the child is created so that the child
+    // inherits a signal mask where they are blocked until its sampler is set up. The
+    // signal mask of this thread is restored once the child is created and the child
+    // restores it if it does not start a sampler
+    auto _blocked   = get_sampling_signals();
+    auto _prev_mask = sigset_t{};
+    auto _masked    = false;
     if(_enable_sampling && !_blocked.empty())
     {
         OMNITRACE_DEBUG("blocking signals...\n");
-        tim::sampling::block_signals(_blocked, tim::sampling::sigmask_scope::process);
+        auto _mask = sigset_t{};
+        sigemptyset(&_mask);
+        for(auto itr : _blocked)
+            sigaddset(&_mask, itr);
+        _masked = (pthread_sigmask(SIG_BLOCK, &_mask, &_prev_mask) == 0);
     }
 
+    set_thread_state(ThreadState::Disabled);
+    auto  _sequence = get_thread_sequence().reserve();
+    auto* _wrap     = new wrapper(start_routine, arg, _enable_sampling, _sequence,
+                                  std::move(_cid_stack),
+                                  (_masked) ? &_prev_mask : nullptr);
+    set_thread_state(ThreadState::Internal);
+
     if(_use_bundle)
     {
         _bundle = bundle_t{ "pthread_create" };
@@ -373,19 +543,21 @@ pthread_create_gotcha::operator()(pthread_t* thread, const pthread_attr_t* attr,
     // create the thread
     auto _ret = (*m_wrappee)(thread, attr, &wrapper::wrap, static_cast<void*>(_wrap));
 
-    // wait for thread to set promise
-    OMNITRACE_DEBUG("waiting for child to signal it is setup...\n");
-    _fut.wait();
-
-    if(_use_bundle) stop_bundle(*_bundle, threading::get_id(), audit::outgoing{}, _ret);
+    if(_masked)
+    {
+        OMNITRACE_DEBUG("restoring signal mask...\n");
+        pthread_sigmask(SIG_SETMASK, &_prev_mask, nullptr);
+    }
 
-    // unblock the signals in the entire process
-    if(_enable_sampling && !_blocked.empty())
+    if(_ret != 0)
     {
-        OMNITRACE_DEBUG("unblocking signals...\n");
-        tim::sampling::unblock_signals(_blocked, tim::sampling::sigmask_scope::process);
+        // the child thread will never take its turn
+        get_thread_sequence().skip(_sequence);
+        delete _wrap;
     }
 
+    if(_use_bundle) stop_bundle(*_bundle, threading::get_id(), audit::outgoing{}, _ret);
+
     OMNITRACE_DEBUG("returning success...\n");
     return _ret;
 }
@@ -27,8 +27,9 @@
 #include "library/thread_data.hpp"
 #include "library/timemory.hpp"
 
+#include <csignal>
 #include <cstdint>
-#include <future>
+#include <vector>
 
 namespace omnitrace
 {
@@ -39,21 +40,28 @@ struct pthread_create_gotcha : tim::component::base<pthread_create_gotcha, void>
     using routine_t = void* (*) (void*);
     using wrappee_t = int (*)(pthread_t*, const pthread_attr_t*, routine_t, void*);
 
+    // the parent thread does not wait for the child thread to complete its setup
+    // so the wrapper is owned (and deleted) by the child thread
     struct wrapper
     {
-        using promise_t = std::promise<void>;
+        using cid_stack_t = std::vector<uint64_t>;
 
-        wrapper(routine_t _routine, void* _arg, bool, int64_t, promise_t*);
+        wrapper(routine_t _routine, void* _arg, bool, uint64_t, cid_stack_t&&,
+                const sigset_t* _sigmask);
         void* operator()() const;
 
         static void* wrap(void* _arg);
 
     private:
-        bool       m_enable_sampling = false;
-        int64_t    m_parent_tid      = 0;
-        routine_t  m_routine         = nullptr;
-        void*      m_arg             = nullptr;
-        promise_t* m_promise         = nullptr;
+        void restore_sigmask() const;
+
+        bool        m_enable_sampling = false;
+        bool        m_restore_sigmask = false;
+        uint64_t    m_sequence        = 0;  // order in which the thread was created
+        routine_t   m_routine         = nullptr;
+        void*       m_arg             = nullptr;
+        cid_stack_t m_cid_stack       = {};  // call-ids of the parent at creation
+        sigset_t    m_sigmask         = {};  // signal mask of the parent at creation
     };
 
     TIMEMORY_DEFAULT_OBJECT(pthread_create_gotcha)
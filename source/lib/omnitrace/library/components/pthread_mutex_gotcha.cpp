@@ -25,15 +25,18 @@
 #include "library/config.hpp"
 #include "library/critical_trace.hpp"
 #include "library/debug.hpp"
+#include "library/lock_contention.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
 #include "library/thread_info.hpp"
+#include "library/timestamp.hpp"
 #include "library/utility.hpp"
 
 #include <timemory/backends/threading.hpp>
 #include <timemory/utility/signals.hpp>
 #include <timemory/utility/types.hpp>
 
+#include <cerrno>
 #include <cstdint>
 #include <pthread.h>
 #include <stdexcept>
@@ -45,6 +48,25 @@ namespace component
 using Device = critical_trace::Device;
 using Phase  = critical_trace::Phase;
 
+namespace
+{
+// set when the wrappers are generated so that they are consistent with the functions
+// which were wrapped
+bool&
+contention_only()
+{
+    static bool _v = false;
+    return _v;
+}
+
+bool&
+lock_profile()
+{
+    static bool _v = false;
+    return _v;
+}
+}  // namespace
+
 pthread_mutex_gotcha::hash_array_t&
 pthread_mutex_gotcha::get_hashes()
 {
@@ -71,6 +93,12 @@ pthread_mutex_gotcha::get_hashes()
             for(size_t i = 9; i < 12; ++i)
                 _skip.emplace(i);
         }
+        if(contention_only())
+        {
+            // unlock and trylock never block
+            for(size_t i : { 1, 2, 5, 6, 7, 10, 11 })
+                _skip.emplace(i);
+        }
         for(size_t i = 0; i < gotcha_capacity; ++i)
         {
             auto&& _id = _data.at(i).tool_id;
@@ -97,16 +125,28 @@ void
 pthread_mutex_gotcha::configure()
 {
     pthread_mutex_gotcha_t::get_initializer() = []() {
+        // in the contention-only mode, the unlock and trylock functions are not wrapped
+        // since they never block. This also permits the wrappers to call the trylock
+        // functions directly
+        contention_only() = lock_contention::contention_only();
+        lock_profile()    = lock_contention::enabled();
+        bool _all         = !contention_only();
+
         if(config::get_trace_thread_locks())
         {
             pthread_mutex_gotcha_t::configure(
                 comp::gotcha_config<0, int, pthread_mutex_t*>{ "pthread_mutex_lock" });
 
-            pthread_mutex_gotcha_t::configure(
-                comp::gotcha_config<1, int, pthread_mutex_t*>{ "pthread_mutex_unlock" });
+            if(_all)
+            {
+                pthread_mutex_gotcha_t::configure(
+                    comp::gotcha_config<1, int, pthread_mutex_t*>{
+                        "pthread_mutex_unlock" });
 
-            pthread_mutex_gotcha_t::configure(
-                comp::gotcha_config<2, int, pthread_mutex_t*>{ "pthread_mutex_trylock" });
+                pthread_mutex_gotcha_t::configure(
+                    comp::gotcha_config<2, int, pthread_mutex_t*>{
+                        "pthread_mutex_trylock" });
+            }
         }
 
         if(config::get_trace_thread_rwlocks())
@@ -119,17 +159,20 @@ pthread_mutex_gotcha::configure()
                 comp::gotcha_config<4, int, pthread_rwlock_t*>{
                     "pthread_rwlock_wrlock" });
 
-            pthread_mutex_gotcha_t::configure(
-                comp::gotcha_config<5, int, pthread_rwlock_t*>{
-                    "pthread_rwlock_tryrdlock" });
+            if(_all)
+            {
+                pthread_mutex_gotcha_t::configure(
+                    comp::gotcha_config<5, int, pthread_rwlock_t*>{
+                        "pthread_rwlock_tryrdlock" });
 
-            pthread_mutex_gotcha_t::configure(
-                comp::gotcha_config<6, int, pthread_rwlock_t*>{
-                    "pthread_rwlock_trywrlock" });
+                pthread_mutex_gotcha_t::configure(
+                    comp::gotcha_config<6, int, pthread_rwlock_t*>{
+                        "pthread_rwlock_trywrlock" });
 
-            pthread_mutex_gotcha_t::configure(
-                comp::gotcha_config<7, int, pthread_rwlock_t*>{
-                    "pthread_rwlock_unlock" });
+                pthread_mutex_gotcha_t::configure(
+                    comp::gotcha_config<7, int, pthread_rwlock_t*>{
+                        "pthread_rwlock_unlock" });
+            }
         }
 
         pthread_mutex_gotcha_t::configure(
@@ -140,13 +183,16 @@ pthread_mutex_gotcha::configure()
             pthread_mutex_gotcha_t::configure(
                 comp::gotcha_config<9, int, pthread_spinlock_t*>{ "pthread_spin_lock" });
 
-            pthread_mutex_gotcha_t::configure(
-                comp::gotcha_config<10, int, pthread_spinlock_t*>{
-                    "pthread_spin_trylock" });
+            if(_all)
+            {
+                pthread_mutex_gotcha_t::configure(
+                    comp::gotcha_config<10, int, pthread_spinlock_t*>{
+                        "pthread_spin_trylock" });
 
-            pthread_mutex_gotcha_t::configure(
-                comp::gotcha_config<11, int, pthread_spinlock_t*>{
-                    "pthread_spin_unlock" });
+                pthread_mutex_gotcha_t::configure(
+                    comp::gotcha_config<11, int, pthread_spinlock_t*>{
+                        "pthread_spin_unlock" });
+            }
         }
 
         pthread_mutex_gotcha_t::configure(
@@ -167,7 +213,7 @@ pthread_mutex_gotcha::pthread_mutex_gotcha(const gotcha_data_t& _data)
 template <typename... Args>
 auto
 pthread_mutex_gotcha::operator()(uintptr_t&& _id, int (*_callee)(Args...),
-                                 Args... _args) const
+                                 int (*_try)(Args...), Args... _args) const
 {
     using bundle_t = category_region<category::pthread>;
 
@@ -203,30 +249,117 @@ pthread_mutex_gotcha::operator()(uintptr_t&& _id, int (*_callee)(Args...),
     if(_id < std::numeric_limits<uintptr_t>::max() && get_use_critical_trace())
     {
         std::tie(_cid, _parent_cid, _depth) = create_cpu_cid_entry();
-        _ts                                 = comp::wall_clock::record();
+        _ts                                 = timestamp::now();
     }
 
+    // when the lock profile is collected, the lock is first acquired via the
+    // non-blocking function so that the contended acquisitions can be identified
     bundle_t::audit(std::string_view{ m_data->tool_id }, audit::incoming{}, _args...);
-    auto _ret = (*_callee)(_args...);
+    auto _beg       = (lock_profile()) ? timestamp::now() : 0;
+    auto _ret       = (_try) ? (*_try)(_args...) : EBUSY;
+    bool _contended = (_try && _ret == EBUSY);
+    if(!_try || _contended) _ret = (*_callee)(_args...);
+    auto _end = (lock_profile()) ? timestamp::now() : 0;
     bundle_t::audit(std::string_view{ m_data->tool_id }, audit::outgoing{}, _ret);
 
     if(_id < std::numeric_limits<uintptr_t>::max() && get_use_critical_trace())
     {
         add_critical_trace<Device::CPU, Phase::DELTA>(
-            threading::get_id(), _cid, 0, _parent_cid, _ts, comp::wall_clock::record(), 0,
+            threading::get_id(), _cid, 0, _parent_cid, _ts, timestamp::now(), 0,
             _id, get_hashes().at(m_data->index), _depth);
     }
 
+    if(lock_profile()) record(_id, _ret, _end - _beg, _contended);
+
     tim::consume_parameters(_id, _cid, _parent_cid, _depth, _ts);
     return _ret;
 }
 
+void
+pthread_mutex_gotcha::record(uintptr_t _lock, int _ret, uint64_t _wait,
+                             bool _contended) const
+{
+    using lock_kind = lock_contention::lock_kind;
+
+    auto _acquire = [&](lock_kind _kind) {
+        if(_ret == 0) lock_contention::acquire(_lock, _kind, _wait, _contended);
+    };
+
+    switch(m_data->index)
+    {
+        case 0:
+        case 2: _acquire(lock_kind::mutex); break;
+        case 3:
+        case 5: _acquire(lock_kind::rwlock_read); break;
+        case 4:
+        case 6: _acquire(lock_kind::rwlock_write); break;
+        case 9:
+        case 10: _acquire(lock_kind::spinlock); break;
+        case 8:
+        {
+            // only the last thread to arrive at the barrier did not wait
+            if(_ret == 0 || _ret == PTHREAD_BARRIER_SERIAL_THREAD)
+                lock_contention::acquire(_lock, lock_kind::barrier, _wait, _ret == 0);
+            break;
+        }
+        case 1:
+        case 7:
+        case 11:
+        {
+            if(_ret == 0) lock_contention::release(_lock);
+            break;
+        }
+        default: break;
+    }
+}
+
+template <typename LockT>
+int
+pthread_mutex_gotcha::contended(int (*_callee)(LockT*), int (*_try)(LockT*),
+                                LockT* _lock) const
+{
+    // the uncontended path is the non-blocking attempt to acquire the lock. Any result
+    // other than busy (e.g. acquired, or an error) is also the result of the blocking
+    // function
+    auto _ret = (*_try)(_lock);
+    if(_ret != EBUSY) return _ret;
+    if(is_disabled()) return (*_callee)(_lock);
+
+    using bundle_t = category_region<category::pthread>;
+
+    struct local_dtor
+    {
+        explicit local_dtor(bool& _v)
+        : _protect{ _v }
+        {}
+        ~local_dtor() { _protect = false; }
+        bool& _protect;
+    } _dtor{ m_protect = true };
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    bundle_t::start(std::string_view{ m_data->tool_id });
+    auto _beg = timestamp::now();
+    _ret      = (*_callee)(_lock);
+    auto _end = timestamp::now();
+    bundle_t::stop(std::string_view{ m_data->tool_id });
+
+    record(reinterpret_cast<uintptr_t>(_lock), _ret, _end - _beg, true);
+    return _ret;
+}
+
 int
 pthread_mutex_gotcha::operator()(int (*_callee)(pthread_mutex_t*),
                                  pthread_mutex_t* _mutex) const
 {
     if(m_protect) return (*_callee)(_mutex);
-    return (*this)(reinterpret_cast<uintptr_t>(_mutex), _callee, _mutex);
+
+    // index 0 is pthread_mutex_lock
+    int (*_try)(pthread_mutex_t*) =
+        (m_data->index == 0) ? &pthread_mutex_trylock : nullptr;
+    if(contention_only()) return contended(_callee, _try, _mutex);
+    if(!lock_profile()) _try = nullptr;
+    return (*this)(reinterpret_cast<uintptr_t>(_mutex), _callee, _try, _mutex);
 }
 
 int
@@ -234,7 +367,13 @@ pthread_mutex_gotcha::operator()(int (*_callee)(pthread_spinlock_t*),
                                  pthread_spinlock_t* _lock) const
 {
     if(m_protect) return (*_callee)(_lock);
-    return (*this)(reinterpret_cast<uintptr_t>(_lock), _callee, _lock);
+
+    // index 9 is pthread_spin_lock
+    int (*_try)(pthread_spinlock_t*) =
+        (m_data->index == 9) ? &pthread_spin_trylock : nullptr;
+    if(contention_only()) return contended(_callee, _try, _lock);
+    if(!lock_profile()) _try = nullptr;
+    return (*this)(reinterpret_cast<uintptr_t>(_lock), _callee, _try, _lock);
 }
 
 int
@@ -242,7 +381,17 @@ pthread_mutex_gotcha::operator()(int (*_callee)(pthread_rwlock_t*),
                                  pthread_rwlock_t* _lock) const
 {
     if(m_protect) return (*_callee)(_lock);
-    return (*this)(reinterpret_cast<uintptr_t>(_lock), _callee, _lock);
+
+    // index 3 is pthread_rwlock_rdlock and index 4 is pthread_rwlock_wrlock
+    int (*_try)(pthread_rwlock_t*) = nullptr;
+    if(m_data->index == 3)
+        _try = &pthread_rwlock_tryrdlock;
+    else if(m_data->index == 4)
+        _try = &pthread_rwlock_trywrlock;
+
+    if(contention_only()) return contended(_callee, _try, _lock);
+    if(!lock_profile()) _try = nullptr;
+    return (*this)(reinterpret_cast<uintptr_t>(_lock), _callee, _try, _lock);
 }
 
 int
@@ -250,7 +399,8 @@ pthread_mutex_gotcha::operator()(int (*_callee)(pthread_barrier_t*),
                                  pthread_barrier_t* _barrier) const
 {
     if(m_protect) return (*_callee)(_barrier);
-    return (*this)(reinterpret_cast<uintptr_t>(_barrier), _callee, _barrier);
+    return (*this)(reinterpret_cast<uintptr_t>(_barrier), _callee,
+                   decltype(_callee){ nullptr }, _barrier);
 }
 
 int
@@ -258,7 +408,8 @@ pthread_mutex_gotcha::operator()(int (*_callee)(pthread_t, void**), pthread_t _t
                                  void** _tinfo) const
 {
     if(m_protect) return (*_callee)(_thr, _tinfo);
-    return (*this)(static_cast<uintptr_t>(threading::get_id()), _callee, _thr, _tinfo);
+    return (*this)(static_cast<uintptr_t>(threading::get_id()), _callee,
+                   decltype(_callee){ nullptr }, _thr, _tinfo);
 }
 
 bool
@@ -31,6 +31,7 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace omnitrace
@@ -65,8 +66,16 @@ private:
     static bool          is_disabled();
     static hash_array_t& get_hashes();
 
+    // the second function, if non-null, is the non-blocking variant of the first
     template <typename... Args>
-    auto operator()(uintptr_t&&, int (*)(Args...), Args...) const;
+    auto operator()(uintptr_t&&, int (*)(Args...), int (*)(Args...), Args...) const;
+
+    // adds the result of the call to the lock profile
+    void record(uintptr_t, int, uint64_t, bool) const;
+
+    // only records the acquisitions which block
+    template <typename LockT>
+    int contended(int (*)(LockT*), int (*)(LockT*), LockT*) const;
 
     mutable bool         m_protect = false;
     const gotcha_data_t* m_data    = nullptr;
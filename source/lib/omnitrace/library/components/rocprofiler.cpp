@@ -60,8 +60,7 @@ rocprofiler_activity_count()
 unique_ptr_t<rocm_data_t>&
 rocm_data(int64_t _tid)
 {
-    using thread_data_t = thread_data<rocm_data_t, rocm_event>;
-    static auto& _v     = thread_data_t::instances(thread_data_t::construct_on_init{});
+    static auto& _v = rocm_thread_data::instances(rocm_thread_data::construct_on_init{});
     return _v.at(_tid);
 }
 
@@ -94,6 +94,7 @@ struct rocm_event
 
 using rocm_data_t       = std::vector<rocm_event>;
 using rocm_data_tracker = data_tracker<rocm_feature_value, rocm_event>;
+using rocm_thread_data  = omnitrace::thread_data<rocm_data_t, rocm_event>;
 
 omnitrace::unique_ptr_t<rocm_data_t>&
 rocm_data(int64_t _tid = threading::get_id());
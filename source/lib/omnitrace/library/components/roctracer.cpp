@@ -186,11 +186,9 @@ roctracer::shutdown()
 
     OMNITRACE_VERBOSE_F(1, "shutting down roctracer...\n");
 
-    OMNITRACE_VERBOSE_F(2, "executing hip_exec_activity_callbacks(0..%zu)\n",
-                        max_supported_threads);
+    OMNITRACE_VERBOSE_F(2, "executing hip_exec_activity_callbacks...\n");
     // make sure all async operations are executed
-    for(size_t i = 0; i < max_supported_threads; ++i)
-        hip_exec_activity_callbacks(i);
+    hip_exec_activity_callbacks();
 
     // callback for hsa
     OMNITRACE_VERBOSE_F(2, "executing %zu roctracer_shutdown_routines...\n",
@@ -26,6 +26,7 @@
 #include "library/gpu.hpp"
 #include "library/mproc.hpp"
 #include "library/perfetto.hpp"
+#include "library/region_gate.hpp"
 #include "library/runtime.hpp"
 
 #include <timemory/backends/dmp.hpp>
@@ -319,6 +320,13 @@ configure_settings(bool _init)
         "Enable support for ROCm Communication Collectives Library (RCCL) Performance",
         false, "rocm", "rccl", "backend");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_MPIP_COMM_MATRIX",
+        "Aggregate the messages and bytes exchanged between each pair of MPI ranks and "
+        "the per-rank volumes of the collectives. The communication matrix is collected "
+        "on rank 0 at finalization and written in a binary and a CSV format",
+        false, "mpi", "io", "data", "advanced");
+
     OMNITRACE_CONFIG_CL_SETTING(
         bool, "OMNITRACE_KOKKOS_KERNEL_LOGGER", "Enables kernel logging", false,
         "--omnitrace-kokkos-kernel-logger", "kokkos", "debugging", "advanced");
@@ -336,6 +344,44 @@ configure_settings(bool _init)
                              "function calls (not statistical)",
                              size_t{ 1 }, "instrumentation", "data_sampling", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_THROTTLE_COUNT",
+        "Instrumentation of a region is disabled on a thread once it has been called "
+        "this many times with a mean duration below OMNITRACE_THROTTLE_VALUE. Zero "
+        "disables throttling. Throttled regions are reported at finalization",
+        size_t{ 0 }, "instrumentation", "throttle", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(size_t, "OMNITRACE_THROTTLE_VALUE",
+                             "Mean duration (in nanoseconds) below which a region which "
+                             "exceeds OMNITRACE_THROTTLE_COUNT calls is throttled",
+                             size_t{ 10000 }, "instrumentation", "throttle", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TSC_TIMESTAMPS",
+        "Use the invariant time-stamp counter, calibrated against CLOCK_REALTIME, for "
+        "the timestamps of traced regions, the critical trace, and sampling instead of "
+        "clock_gettime. Ignored if the time-stamp counter is not suitable",
+        false, "timing", "tracing", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(uint64_t, "OMNITRACE_TSC_CALIBRATION_PERIOD_MS",
+                             "Period (in milliseconds) at which the time-stamp counter "
+                             "is re-calibrated against CLOCK_REALTIME",
+                             uint64_t{ 1000 }, "timing", "tracing", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_OVERHEAD_COMPENSATION",
+        "Subtract the calibrated cost of instrumenting the nested regions from the "
+        "wall-clock time of each timemory region. The correction is reported in the "
+        "metadata",
+        false, "timemory", "instrumentation", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_OVERHEAD_SAMPLE_INTERVAL",
+        "When OMNITRACE_OVERHEAD_COMPENSATION is enabled, the cost of one in every N "
+        "region entries/exits is measured during the run and replaces the startup "
+        "calibration. Zero disables the measurement during the run",
+        size_t{ 1000 }, "timemory", "instrumentation", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         double, "OMNITRACE_SAMPLING_FREQ",
         "Number of software interrupts per second when OMNITTRACE_USE_SAMPLING=ON", 10.0,
@@ -459,6 +505,21 @@ configure_settings(bool _init)
                              "cause deadlocks with MPI distributions.",
                              true, "backend", "parallelism", "gotcha", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TRACE_THREAD_LOCK_PROFILE",
+        "Aggregate the traced pthread lock calls by lock address and call-site and "
+        "report the number of acquisitions, the contended acquisitions, and the wait "
+        "and hold times at finalization",
+        false, "backend", "parallelism", "gotcha", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_TRACE_THREAD_LOCK_CONTENTION",
+        "When tracing pthread locks, only record the lock acquisitions which block, i.e. "
+        "a non-blocking attempt to acquire the lock failed. The unlock and trylock "
+        "functions are not traced and a report of the most contended locks is "
+        "generated at finalization",
+        false, "backend", "parallelism", "gotcha", "advanced");
+
     OMNITRACE_CONFIG_SETTING(
         bool, "OMNITRACE_SAMPLING_KEEP_INTERNAL",
         "Configure whether the statistical samples should include call-stack entries "
@@ -519,6 +580,14 @@ configure_settings(bool _init)
         "Include names in serialization of critical trace (mainly for debugging)",
         _omnitrace_debug, "debugging", "critical_trace", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_CRITICAL_TRACE_FORMAT",
+        "Output format of the critical trace call-chain. 'json' is human-readable, "
+        "'binary' is a compact columnar format which omnitrace-critical-trace "
+        "memory-maps. Options are: 'json', 'binary', or 'all'",
+        "json", "io", "critical_trace", "omnitrace-critical-trace", "advanced")
+        ->set_choices({ "json", "binary", "all" });
+
     OMNITRACE_CONFIG_SETTING(size_t, "OMNITRACE_PERFETTO_SHMEM_SIZE_HINT_KB",
                              "Hint for shared-memory buffer size in perfetto (in KB)",
                              size_t{ 4096 }, "perfetto", "data", "advanced");
@@ -538,7 +607,63 @@ configure_settings(bool _init)
         "Behavior when perfetto buffer is full. 'discard' will ignore new entries, "
         "'ring_buffer' will overwrite old entries",
         "discard", "perfetto", "data")
-        ->set_choices({ "fill", "discard" });
+        ->set_choices({ "discard", "ring_buffer" });
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERFETTO_STREAMING",
+        "Periodically write the perfetto trace to OMNITRACE_PERFETTO_FILE while the "
+        "application runs instead of holding the entire trace in memory until "
+        "finalization. The buffer only needs to be large enough to hold the data "
+        "collected within OMNITRACE_PERFETTO_STREAMING_PERIOD_MS",
+        false, "perfetto", "io", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        uint64_t, "OMNITRACE_PERFETTO_STREAMING_PERIOD_MS",
+        "Period (in milliseconds) at which the perfetto buffer is written to disk when "
+        "OMNITRACE_PERFETTO_STREAMING is enabled",
+        uint64_t{ 1000 }, "perfetto", "io", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERFETTO_EVENT_BUFFER",
+        "Record the entry and exit of instrumented functions into per-thread binary "
+        "buffers instead of encoding a perfetto track event for every call. The "
+        "buffers are converted to perfetto track events during finalization",
+        false, "perfetto", "instrumentation", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_PERFETTO_EVENT_BUFFER_SIZE_KB",
+        "Size limit of the event buffer of each thread (in KB). When a buffer reaches "
+        "this size, the thread converts its events to perfetto track events and reuses "
+        "the buffer",
+        size_t{ 65536 }, "perfetto", "instrumentation", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PERFETTO_FLIGHT_RECORDER",
+        "Also record the perfetto trace into a second ring buffer and, while tracing "
+        "continues, write a snapshot of it to a new numbered file whenever "
+        "OMNITRACE_PERFETTO_FLIGHT_RECORDER_SIGNAL is received, omnitrace_dump_trace() "
+        "is called, or a region in OMNITRACE_PERFETTO_FLIGHT_RECORDER_TRIGGER is "
+        "entered. Reading the buffer consumes it so each snapshot only contains the "
+        "events recorded after the previous snapshot. The trace written at finalization "
+        "is not affected",
+        false, "perfetto", "io", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        size_t, "OMNITRACE_PERFETTO_FLIGHT_RECORDER_BUFFER_SIZE_KB",
+        "Size of the ring buffer of the perfetto flight recorder (in KB). A snapshot "
+        "contains at most this much of the most recent events",
+        size_t{ 65536 }, "perfetto", "data", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        int, "OMNITRACE_PERFETTO_FLIGHT_RECORDER_SIGNAL",
+        "Signal which requests a flight-recorder snapshot. Set to zero to disable",
+        SIGUSR2, "perfetto", "io", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        std::string, "OMNITRACE_PERFETTO_FLIGHT_RECORDER_TRIGGER",
+        "Semicolon-delimited list of region names whose entry requests a "
+        "flight-recorder snapshot",
+        "", "perfetto", "io", "advanced");
 
     OMNITRACE_CONFIG_SETTING(std::string, "OMNITRACE_PERFETTO_CATEGORIES",
                              "Categories to collect within perfetto", "", "perfetto",
@@ -552,6 +677,20 @@ configure_settings(bool _init)
                            1),
         "parallelism", "advanced");
 
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_PARALLEL_FINALIZE",
+        "Run the event-buffer conversion and the reports of finalization on the "
+        "thread-pool while the other stages run on the main thread. The time spent in "
+        "each stage is reported when OMNITRACE_VERBOSE >= 1",
+        true, "parallelism", "advanced");
+
+    OMNITRACE_CONFIG_SETTING(
+        bool, "OMNITRACE_RECYCLE_TIDS",
+        "Assign the index of a thread which has exited to the next thread which is "
+        "created. The data of the exited thread is preserved and output separately. "
+        "Defaults to true when OMNITRACE_USE_SAMPLING is disabled and false otherwise",
+        true, "parallelism", "advanced");
+
     OMNITRACE_CONFIG_EXT_SETTING(int64_t, "OMNITRACE_CRITICAL_TRACE_COUNT",
                                  "Number of critical trace to export (0 == all)",
                                  int64_t{ 0 }, "data", "critical_trace",
@@ -888,9 +1027,9 @@ configure_mode_settings()
         }
     }
 
-    // recycle all subsequent thread ids
-    threading::recycle_ids() =
-        tim::get_env<bool>("OMNITRACE_RECYCLE_TIDS", !get_use_sampling());
+    // recycle all subsequent thread ids. Sampling only recycles them when requested
+    set_default_setting_value("OMNITRACE_RECYCLE_TIDS", !get_use_sampling());
+    threading::recycle_ids() = get_recycle_tids();
 
     if(!get_config()->get_enabled())
     {
@@ -910,6 +1049,9 @@ configure_mode_settings()
         set_setting_value("OMNITRACE_TIMEMORY_COMPONENTS", std::string{});
         set_setting_value("OMNITRACE_PAPI_EVENTS", std::string{});
     }
+
+    // the backends in use are cached by the region gate
+    region_gate::invalidate();
 }
 
 void
@@ -1550,6 +1692,13 @@ get_use_rcclp()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+bool
+get_mpip_comm_matrix()
+{
+    static auto _v = get_config()->find("OMNITRACE_MPIP_COMM_MATRIX");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
 bool
 get_critical_trace_debug()
 {
@@ -1564,6 +1713,13 @@ get_critical_trace_serialize_names()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+std::string
+get_critical_trace_format()
+{
+    static auto _v = get_config()->find("OMNITRACE_CRITICAL_TRACE_FORMAT");
+    return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
+}
+
 bool
 get_sampling_keep_internal()
 {
@@ -1645,6 +1801,67 @@ get_perfetto_fill_policy()
     return static_cast<tim::tsettings<std::string>&>(*_v->second).get();
 }
 
+bool
+get_perfetto_streaming()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_STREAMING");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+uint64_t
+get_perfetto_streaming_period()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_STREAMING_PERIOD_MS");
+    // perfetto does not permit write periods less than 100 ms
+    return std::max<uint64_t>(
+        static_cast<tim::tsettings<uint64_t>&>(*_v->second).get(), 100);
+}
+
+bool
+get_perfetto_event_buffer()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_EVENT_BUFFER");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_perfetto_event_buffer_size()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_EVENT_BUFFER_SIZE_KB");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+bool
+get_perfetto_flight_recorder()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_FLIGHT_RECORDER");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_perfetto_flight_recorder_buffer_size()
+{
+    static auto _v =
+        get_config()->find("OMNITRACE_PERFETTO_FLIGHT_RECORDER_BUFFER_SIZE_KB");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+int
+get_perfetto_flight_recorder_signal()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_FLIGHT_RECORDER_SIGNAL");
+    return static_cast<tim::tsettings<int>&>(*_v->second).get();
+}
+
+std::vector<std::string>
+get_perfetto_flight_recorder_triggers()
+{
+    static auto _v = get_config()->find("OMNITRACE_PERFETTO_FLIGHT_RECORDER_TRIGGER");
+    // region names may contain spaces, commas and colons, e.g. C++ function signatures
+    return tim::delimit(static_cast<tim::tsettings<std::string>&>(*_v->second).get(),
+                        ";");
+}
+
 std::set<std::string>
 get_perfetto_categories()
 {
@@ -1674,6 +1891,20 @@ get_thread_pool_size()
     return _v;
 }
 
+bool
+get_parallel_finalize()
+{
+    static auto _v = get_config()->find("OMNITRACE_PARALLEL_FINALIZE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_recycle_tids()
+{
+    static auto _v = get_config()->find("OMNITRACE_RECYCLE_TIDS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
 std::string
 get_trace_hsa_api_types()
 {
@@ -1724,6 +1955,49 @@ get_instrumentation_interval()
     return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
 }
 
+size_t
+get_throttle_count()
+{
+    static auto _v = get_config()->find("OMNITRACE_THROTTLE_COUNT");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+size_t
+get_throttle_value()
+{
+    static auto _v = get_config()->find("OMNITRACE_THROTTLE_VALUE");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
+bool
+get_tsc_timestamps()
+{
+    static auto _v = get_config()->find("OMNITRACE_TSC_TIMESTAMPS");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+uint64_t
+get_tsc_calibration_period()
+{
+    static auto _v = get_config()->find("OMNITRACE_TSC_CALIBRATION_PERIOD_MS");
+    return std::max<uint64_t>(
+        static_cast<tim::tsettings<uint64_t>&>(*_v->second).get(), 10);
+}
+
+bool
+get_overhead_compensation()
+{
+    static auto _v = get_config()->find("OMNITRACE_OVERHEAD_COMPENSATION");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+size_t
+get_overhead_sample_interval()
+{
+    static auto _v = get_config()->find("OMNITRACE_OVERHEAD_SAMPLE_INTERVAL");
+    return static_cast<tim::tsettings<size_t>&>(*_v->second).get();
+}
+
 double
 get_sampling_freq()
 {
@@ -1875,6 +2149,20 @@ get_trace_thread_spin_locks()
     return static_cast<tim::tsettings<bool>&>(*_v->second).get();
 }
 
+bool
+get_trace_thread_lock_profile()
+{
+    static auto _v = get_config()->find("OMNITRACE_TRACE_THREAD_LOCK_PROFILE");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
+bool
+get_trace_thread_lock_contention()
+{
+    static auto _v = get_config()->find("OMNITRACE_TRACE_THREAD_LOCK_CONTENTION");
+    return static_cast<tim::tsettings<bool>&>(*_v->second).get();
+}
+
 bool
 get_debug_tid()
 {
@@ -1926,6 +2214,7 @@ set_state(State _n)
                              "State is being assigned to a lesser value :: %s -> %s",
                              std::to_string(_o).c_str(), std::to_string(_n).c_str());
     get_state() = _n;
+    region_gate::invalidate();
     return _o;
 }
 }  // namespace omnitrace
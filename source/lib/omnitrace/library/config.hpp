@@ -34,6 +34,7 @@
 #include <string>
 #include <string_view>
 #include <unordered_set>
+#include <vector>
 
 namespace omnitrace
 {
@@ -219,6 +220,9 @@ get_sampling_rtoffset();
 bool
 get_use_rcclp();
 
+bool
+get_mpip_comm_matrix();
+
 bool
 get_trace_hsa_api();
 
@@ -231,6 +235,9 @@ get_critical_trace_debug();
 bool
 get_critical_trace_serialize_names();
 
+std::string
+get_critical_trace_format();
+
 size_t
 get_perfetto_shmem_size_hint();
 
@@ -243,6 +250,30 @@ get_perfetto_combined_traces();
 std::string
 get_perfetto_fill_policy();
 
+bool
+get_perfetto_streaming();
+
+uint64_t
+get_perfetto_streaming_period();
+
+bool
+get_perfetto_event_buffer();
+
+size_t
+get_perfetto_event_buffer_size();
+
+bool
+get_perfetto_flight_recorder();
+
+size_t
+get_perfetto_flight_recorder_buffer_size();
+
+int
+get_perfetto_flight_recorder_signal();
+
+std::vector<std::string>
+get_perfetto_flight_recorder_triggers();
+
 std::set<std::string>
 get_perfetto_categories();
 
@@ -252,6 +283,12 @@ get_critical_trace_update_freq();
 uint64_t
 get_thread_pool_size();
 
+bool
+get_parallel_finalize();
+
+bool
+get_recycle_tids();
+
 std::string
 get_trace_hsa_api_types();
 
@@ -268,6 +305,24 @@ get_critical_trace_count();
 size_t&
 get_instrumentation_interval();
 
+size_t
+get_throttle_count();
+
+size_t
+get_throttle_value();
+
+bool
+get_tsc_timestamps();
+
+uint64_t
+get_tsc_calibration_period();
+
+bool
+get_overhead_compensation();
+
+size_t
+get_overhead_sample_interval();
+
 double
 get_sampling_freq();
 
@@ -319,6 +374,12 @@ get_trace_thread_rwlocks();
 bool
 get_trace_thread_spin_locks();
 
+bool
+get_trace_thread_lock_profile();
+
+bool
+get_trace_thread_lock_contention();
+
 std::string
 get_rocm_events();
 }  // namespace config
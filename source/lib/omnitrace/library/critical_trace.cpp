@@ -27,6 +27,7 @@
 #include "library/perfetto.hpp"
 #include "library/ptl.hpp"
 #include "library/runtime.hpp"
+#include "library/string_table.hpp"
 #include "library/thread_data.hpp"
 
 #include <PTL/ThreadPool.hh>
@@ -40,13 +41,25 @@
 #include <timemory/utility/utility.hpp>
 
 #include <cctype>
+#include <cerrno>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <exception>
+#include <fstream>
+#include <functional>
 #include <iomanip>
+#include <set>
 #include <sstream>
 #include <stdexcept>
+#include <unordered_map>
 #include <utility>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 namespace omnitrace
 {
 namespace critical_trace
@@ -77,6 +90,14 @@ copy_hash_ids()
     for(const auto& itr : _hash_ids)
         tim::hash::add_hash_id(itr);
 }
+
+std::string
+get_hash_identifier(size_t _hash)
+{
+    // names registered on any thread are available through the string table
+    const auto* _name = string_table::find(_hash);
+    return (_name) ? std::string{ _name } : tim::get_hash_identifier(_hash);
+}
 }  // namespace
 }  // namespace critical_trace
 
@@ -334,7 +355,7 @@ entry::write(std::ostream& _os) const
             _os << "end ";
         _os << "[" << begin_ns << ":" << end_ns << "]";
     }
-    _os << ", hash: " << hash << " :: " << tim::demangle(tim::get_hash_identifier(hash));
+    _os << ", hash: " << hash << " :: " << tim::demangle(get_hash_identifier(hash));
 }
 
 bool
@@ -452,18 +473,14 @@ void
 call_chain::generate_perfetto<Device::CPU>(std::set<entry>& _used) const
 {
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-    static std::set<std::string> _static_strings{};
-    static std::mutex            _static_mutex{};
     for(const auto& itr : *this)
     {
         if(!_used.emplace(itr).second) continue;
         if(itr.device != Device::CPU) continue;
-        std::string _name = tim::demangle(tim::get_hash_identifier(itr.hash));
-        _static_mutex.lock();
-        auto sitr = _static_strings.emplace(_name);
-        _static_mutex.unlock();
+        const auto* _name =
+            string_table::get(tim::demangle(get_hash_identifier(itr.hash)));
         TRACE_EVENT_BEGIN("host-critical-trace",
-                          perfetto::StaticString{ sitr.first->c_str() },
+                          perfetto::StaticString{ _name },
                           static_cast<uint64_t>(itr.begin_ns), "begin_ns",
                           static_cast<uint64_t>(itr.begin_ns));
         TRACE_EVENT_END("host-critical-trace", static_cast<uint64_t>(itr.end_ns),
@@ -476,18 +493,14 @@ void
 call_chain::generate_perfetto<Device::GPU>(std::set<entry>& _used) const
 {
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-    static std::set<std::string> _static_strings{};
-    static std::mutex            _static_mutex{};
     for(const auto& itr : *this)
     {
         if(!_used.emplace(itr).second) continue;
         if(itr.device != Device::GPU) continue;
-        std::string _name = tim::demangle(tim::get_hash_identifier(itr.hash));
-        _static_mutex.lock();
-        auto sitr = _static_strings.emplace(_name);
-        _static_mutex.unlock();
+        const auto* _name =
+            string_table::get(tim::demangle(get_hash_identifier(itr.hash)));
         TRACE_EVENT_BEGIN("device-critical-trace",
-                          perfetto::StaticString{ sitr.first->c_str() },
+                          perfetto::StaticString{ _name },
                           static_cast<uint64_t>(itr.begin_ns), "begin_ns",
                           static_cast<uint64_t>(itr.begin_ns));
         TRACE_EVENT_END("device-critical-trace", static_cast<uint64_t>(itr.end_ns),
@@ -500,16 +513,12 @@ void
 call_chain::generate_perfetto<Device::ANY>(std::set<entry>& _used) const
 {
     OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-    static std::set<std::string> _static_strings{};
-    static std::mutex            _static_mutex{};
     for(const auto& itr : *this)
     {
         if(!_used.emplace(itr).second) continue;
-        std::string _name = tim::demangle(tim::get_hash_identifier(itr.hash));
-        _static_mutex.lock();
-        auto sitr = _static_strings.emplace(_name);
-        _static_mutex.unlock();
-        TRACE_EVENT_BEGIN("critical-trace", perfetto::StaticString{ sitr.first->c_str() },
+        const auto* _name =
+            string_table::get(tim::demangle(get_hash_identifier(itr.hash)));
+        TRACE_EVENT_BEGIN("critical-trace", perfetto::StaticString{ _name },
                           static_cast<uint64_t>(itr.begin_ns), "begin_ns",
                           static_cast<uint64_t>(itr.begin_ns));
         TRACE_EVENT_END("critical-trace", static_cast<uint64_t>(itr.end_ns), "end_ns",
@@ -563,7 +572,7 @@ add_hash_id(const std::string& _label)
     using critical_trace_hash_data =
         thread_data<critical_trace::hash_ids, critical_trace::id>;
 
-    auto _hash = tim::hash::add_hash_id(_label);
+    auto _hash = string_table::get_id(_label);
     if(get_use_critical_trace() || get_use_rocm_smi())
     {
         critical_trace_hash_data::construct();
@@ -665,29 +674,52 @@ save_call_chain_json(const std::string& _fname, const std::string& _label,
     }
 }
 
-template <typename Tp, template <typename...> class ContainerT, typename... Args,
-          typename FuncT = bool (*)(const Tp&, const Tp&)>
-inline Tp*
-find(
-    const Tp& _v, ContainerT<Tp, Args...>& _vec,
-    FuncT&& _func = [](const Tp& _lhs, const Tp& _rhs) { return (_lhs == _rhs); })
+// entries can only compare equal when their cpu correlation id, device, process id,
+// and thread id are equal so these are used as the key into buckets of candidate
+// entries. The buckets hold the positions of the entries in insertion order so that
+// a lookup returns the same entry as a linear search through the call-chain
+struct entry_index
 {
-    for(auto& itr : _vec)
+    using bucket_t = std::vector<size_t>;
+
+    explicit entry_index(size_t _n) { m_buckets.reserve(_n); }
+
+    static size_t get_key(const entry& _v)
     {
-        if(std::forward<FuncT>(_func)(_v, itr)) return &itr;
+        // entry is packed so copy the fields instead of binding references to them
+        size_t _cpu_cid = _v.cpu_cid;
+        short  _device  = static_cast<short>(_v.device);
+        auto   _pid     = _v.pid;
+        auto   _tid     = _v.tid;
+        return get_combined_hash(_cpu_cid, _device, _pid, _tid);
     }
-    return nullptr;
-};
 
-template <typename FuncT = bool (*)(const entry&, const entry&)>
-inline entry*
-find(
-    const entry& _v, call_chain& _vec,
-    FuncT&& _func = [](const entry& _lhs, const entry& _rhs) { return (_lhs == _rhs); })
-{
-    return find(_v, reinterpret_cast<std::vector<entry>&>(_vec),
-                std::forward<FuncT>(_func));
-}
+    void emplace(const entry& _v, size_t _pos)
+    {
+        m_buckets[get_key(_v)].emplace_back(_pos);
+    }
+
+    template <typename FuncT>
+    entry* find(const entry& _v, call_chain& _chain, FuncT&& _func) const
+    {
+        auto itr = m_buckets.find(get_key(_v));
+        if(itr == m_buckets.end()) return nullptr;
+        for(auto _pos : itr->second)
+        {
+            if(std::forward<FuncT>(_func)(_v, _chain.at(_pos))) return &_chain.at(_pos);
+        }
+        return nullptr;
+    }
+
+    entry* find(const entry& _v, call_chain& _chain) const
+    {
+        return find(_v, _chain, std::equal_to<entry>{});
+    }
+
+private:
+    std::unordered_map<size_t, bucket_t> m_buckets = {};
+};
+}  // namespace
 
 void
 squash_critical_path(call_chain& _targ)
@@ -702,24 +734,32 @@ squash_critical_path(call_chain& _targ)
 
     std::sort(_targ.begin(), _targ.end());
 
-    call_chain _squashed{};
+    call_chain  _squashed{};
+    entry_index _index{ _targ.size() };
+
+    auto _append = [&_squashed, &_index](const entry& _v) {
+        _index.emplace(_v, _squashed.size());
+        _squashed.emplace_back(_v);
+    };
+
+    _squashed.reserve(_targ.size());
     for(auto& itr : _targ)
     {
         if(itr.phase == Phase::DELTA)
         {
-            _squashed.emplace_back(itr);
+            _append(itr);
         }
         else if(itr.phase == Phase::BEGIN)
         {
-            if(!find(itr, _squashed, _strict_equal)) _squashed.emplace_back(itr);
+            if(!_index.find(itr, _squashed, _strict_equal)) _append(itr);
         }
         else
         {
             entry* _match = nullptr;
-            if((_match = find(itr, _squashed)) != nullptr)
+            if((_match = _index.find(itr, _squashed)) != nullptr)
                 *_match += itr;
             else
-                _squashed.emplace_back(itr);
+                _append(itr);
         }
     }
 
@@ -727,23 +767,27 @@ squash_critical_path(call_chain& _targ)
     std::sort(_targ.begin(), _targ.end());
 }
 
-void
-combine_critical_path(call_chain& _targ, call_chain _chain)
+call_chain
+combine_critical_path(call_chain _chain)
 {
     OMNITRACE_CT_DEBUG("[%s]\n", __FUNCTION__);
-    call_chain _delta{};
-    call_chain _begin{};
-    call_chain _end{};
+    call_chain  _delta{};
+    call_chain  _begin{};
+    call_chain  _end{};
+    entry_index _index{ _chain.size() };
     for(auto& itr : _chain)
     {
         if(itr.phase == Phase::DELTA)
             _delta.emplace_back(itr);
         else if(itr.phase == Phase::BEGIN)
+        {
+            _index.emplace(itr, _begin.size());
             _begin.emplace_back(itr);
+        }
         else if(itr.phase == Phase::END)
         {
             entry* _match = nullptr;
-            if((_match = find(itr, _begin)) != nullptr)
+            if((_match = _index.find(itr, _begin)) != nullptr)
                 *_match += itr;
             else
                 _end.emplace_back(itr);
@@ -759,15 +803,300 @@ combine_critical_path(call_chain& _targ, call_chain _chain)
     for(auto& itr : _end)
         _combined.emplace_back(itr);
     std::sort(_combined.begin(), _combined.end());
+    return _combined;
+}
 
-    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
-    std::unique_lock<std::mutex> _lk{ complete_call_mutex };
-    for(auto& itr : _combined)
-        _targ.emplace_back(itr);
+//--------------------------------------------------------------------------------------//
+//
+//                          BINARY CALL-CHAIN FORMAT
+//
+//--------------------------------------------------------------------------------------//
+//
+//  The binary call-chain file is laid out as:
+//
+//      header
+//      one column per entry field (num_entries values each, in for_each_column order)
+//      string index (num_strings x { hash, offset, length })
+//      string data (the names, not null-terminated)
+//
+//  Every section begins on an 8-byte boundary relative to the start of the file so
+//  the columns can be read in place from a memory-mapped file. Values are stored
+//  in the native byte order of the writer, which is recorded in the header.
+//
+namespace
+{
+namespace binary
+{
+constexpr char     magic[8]    = { 'O', 'M', 'N', 'I', 'C', 'C', 'H', 'N' };
+constexpr uint32_t version     = 1;
+constexpr uint32_t byte_order  = 0x01020304;
+constexpr size_t   num_columns = 14;
+
+struct header
+{
+    char     magic[8]             = {};
+    uint32_t version              = 0;
+    uint32_t byte_order           = 0;
+    uint64_t num_entries          = 0;
+    uint64_t num_strings          = 0;
+    uint64_t columns[num_columns] = {};
+    uint64_t string_index         = 0;
+    uint64_t string_data          = 0;
+    uint64_t size                 = 0;
+};
+
+struct string_record
+{
+    uint64_t hash   = 0;
+    uint64_t offset = 0;
+    uint64_t length = 0;
+};
 
-    // squash_critical_path(_targ);
+// entry is packed so the fields are accessed through their offsets instead of
+// pointers-to-members, which assume natural alignment
+template <typename Tp>
+struct column
+{
+    using value_type = Tp;
+
+    value_type get(const entry& _v) const
+    {
+        auto _val = value_type{};
+        std::memcpy(&_val, reinterpret_cast<const char*>(&_v) + offset, sizeof(_val));
+        return _val;
+    }
+
+    void set(entry& _v, value_type _val) const
+    {
+        std::memcpy(reinterpret_cast<char*>(&_v) + offset, &_val, sizeof(_val));
+    }
+
+    size_t offset = 0;
+};
+
+template <typename FuncT>
+void
+for_each_column(FuncT&& _func)
+{
+#define OMNITRACE_BINARY_COLUMN(FIELD)                                                   \
+    _func(column<decltype(entry::FIELD)>{ offsetof(entry, FIELD) })
+
+    OMNITRACE_BINARY_COLUMN(device);
+    OMNITRACE_BINARY_COLUMN(phase);
+    OMNITRACE_BINARY_COLUMN(priority);
+    OMNITRACE_BINARY_COLUMN(depth);
+    OMNITRACE_BINARY_COLUMN(devid);
+    OMNITRACE_BINARY_COLUMN(pid);
+    OMNITRACE_BINARY_COLUMN(tid);
+    OMNITRACE_BINARY_COLUMN(cpu_cid);
+    OMNITRACE_BINARY_COLUMN(gpu_cid);
+    OMNITRACE_BINARY_COLUMN(parent_cid);
+    OMNITRACE_BINARY_COLUMN(begin_ns);
+    OMNITRACE_BINARY_COLUMN(end_ns);
+    OMNITRACE_BINARY_COLUMN(queue_id);
+    OMNITRACE_BINARY_COLUMN(hash);
+
+#undef OMNITRACE_BINARY_COLUMN
+}
+
+constexpr uint64_t
+get_aligned(uint64_t _v)
+{
+    return (_v + 7) & ~uint64_t{ 7 };
 }
 
+void
+write_padding(std::ostream& _os, uint64_t _pos)
+{
+    constexpr char _zero[8] = {};
+    _os.write(_zero, get_aligned(_pos) - _pos);
+}
+}  // namespace binary
+}  // namespace
+
+bool
+save_call_chain_binary(const std::string& _fname, const call_chain& _chain)
+{
+    using string_entry_t = std::pair<uint64_t, std::string>;
+
+    auto _header        = binary::header{};
+    auto _strings       = std::vector<string_entry_t>{};
+    auto _string_hashes = std::set<uint64_t>{};
+    auto _string_size   = uint64_t{ 0 };
+
+    // every name is only stored once regardless of how many entries refer to it
+    for(const auto& itr : _chain)
+        _string_hashes.emplace(itr.hash);
+
+    _strings.reserve(_string_hashes.size());
+    for(auto itr : _string_hashes)
+    {
+        if(itr == 0) continue;
+        auto _name = get_hash_identifier(itr);
+        if(_name.empty()) continue;
+        _string_size += _name.length();
+        _strings.emplace_back(itr, std::move(_name));
+    }
+
+    std::memcpy(_header.magic, binary::magic, sizeof(binary::magic));
+    _header.version     = binary::version;
+    _header.byte_order  = binary::byte_order;
+    _header.num_entries = _chain.size();
+    _header.num_strings = _strings.size();
+
+    auto   _pos = binary::get_aligned(sizeof(binary::header));
+    size_t _idx = 0;
+    binary::for_each_column([&](auto _column) {
+        using value_type        = typename decltype(_column)::value_type;
+        _header.columns[_idx++] = _pos;
+        _pos = binary::get_aligned(_pos + _chain.size() * sizeof(value_type));
+    });
+    _header.string_index = _pos;
+    _header.string_data  = _pos + _strings.size() * sizeof(binary::string_record);
+    _header.size         = _header.string_data + _string_size;
+
+    std::ofstream _ofs{};
+    if(!tim::filepath::open(_ofs, _fname, std::ios::out | std::ios::binary))
+        return false;
+
+    _ofs.write(reinterpret_cast<const char*>(&_header), sizeof(_header));
+    binary::write_padding(_ofs, sizeof(_header));
+
+    binary::for_each_column([&](auto _column) {
+        using value_type = typename decltype(_column)::value_type;
+        auto _values     = std::vector<value_type>{};
+        _values.reserve(_chain.size());
+        for(const auto& itr : _chain)
+            _values.emplace_back(_column.get(itr));
+        auto _nbytes = _values.size() * sizeof(value_type);
+        _ofs.write(reinterpret_cast<const char*>(_values.data()), _nbytes);
+        binary::write_padding(_ofs, _nbytes);
+    });
+
+    auto _offset = uint64_t{ 0 };
+    for(const auto& itr : _strings)
+    {
+        auto _record = binary::string_record{ itr.first, _offset, itr.second.length() };
+        _ofs.write(reinterpret_cast<const char*>(&_record), sizeof(_record));
+        _offset += _record.length;
+    }
+
+    for(const auto& itr : _strings)
+        _ofs.write(itr.second.data(), itr.second.length());
+
+    return _ofs.good();
+}
+
+bool
+is_call_chain_binary(const std::string& _fname)
+{
+    char          _magic[sizeof(binary::magic)] = {};
+    std::ifstream _ifs{ _fname, std::ios::in | std::ios::binary };
+    if(!_ifs || !_ifs.read(_magic, sizeof(_magic))) return false;
+    return (std::memcmp(_magic, binary::magic, sizeof(_magic)) == 0);
+}
+
+bool
+load_call_chain_binary(const std::string& _fname, call_chain& _chain)
+{
+    auto _fd = ::open(_fname.c_str(), O_RDONLY);
+    if(_fd < 0)
+    {
+        OMNITRACE_PRINT_F("Error opening '%s': %s\n", _fname.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct stat _stat = {};
+    if(::fstat(_fd, &_stat) != 0 || _stat.st_size < 0 ||
+       static_cast<size_t>(_stat.st_size) < sizeof(binary::header))
+    {
+        OMNITRACE_PRINT_F("Error! '%s' is not a binary call-chain file\n",
+                          _fname.c_str());
+        ::close(_fd);
+        return false;
+    }
+
+    auto  _size = static_cast<uint64_t>(_stat.st_size);
+    void* _addr = ::mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, _fd, 0);
+    ::close(_fd);
+    if(_addr == MAP_FAILED)
+    {
+        OMNITRACE_PRINT_F("Error memory-mapping '%s': %s\n", _fname.c_str(),
+                          strerror(errno));
+        return false;
+    }
+
+    const auto* _data   = static_cast<const char*>(_addr);
+    const auto& _header = *reinterpret_cast<const binary::header*>(_data);
+
+    auto _valid = [&]() {
+        if(std::memcmp(_header.magic, binary::magic, sizeof(binary::magic)) != 0)
+            return false;
+        if(_header.version != binary::version || _header.byte_order != binary::byte_order)
+            return false;
+        if(_header.size != _size || _header.string_data > _size ||
+           _header.string_index > _header.string_data)
+            return false;
+        if((_header.string_data - _header.string_index) / sizeof(binary::string_record) <
+           _header.num_strings)
+            return false;
+        size_t _idx = 0;
+        bool   _ok  = true;
+        binary::for_each_column([&](auto _column) {
+            using value_type = typename decltype(_column)::value_type;
+            auto _beg        = _header.columns[_idx++];
+            if(_beg % alignof(value_type) != 0 ||
+               _header.num_entries > (_size - std::min(_beg, _size)) / sizeof(value_type))
+                _ok = false;
+        });
+        return _ok;
+    }();
+
+    if(!_valid)
+    {
+        OMNITRACE_PRINT_F("Error! '%s' is not a valid version %u binary call-chain file "
+                          "for this architecture\n",
+                          _fname.c_str(), binary::version);
+        ::munmap(_addr, _size);
+        return false;
+    }
+
+    // the columns are read in place from the mapping and written directly into the
+    // entries so the contents of the file are never buffered
+    ::madvise(_addr, _size, MADV_SEQUENTIAL);
+
+    auto _offset = _chain.size();
+    auto _nentry = _header.num_entries;
+    _chain.resize(_offset + _nentry);
+
+    auto*  _entries = _chain.data() + _offset;
+    size_t _idx     = 0;
+    binary::for_each_column([&](auto _column) {
+        using value_type = typename decltype(_column)::value_type;
+        const auto* _values =
+            reinterpret_cast<const value_type*>(_data + _header.columns[_idx++]);
+        for(uint64_t i = 0; i < _nentry; ++i)
+            _column.set(_entries[i], _values[i]);
+    });
+
+    const auto* _records =
+        reinterpret_cast<const binary::string_record*>(_data + _header.string_index);
+    const auto* _strings  = _data + _header.string_data;
+    auto        _nstrings = _size - _header.string_data;
+    auto        _hash_ids = tim::get_hash_ids();
+    for(uint64_t i = 0; i < _header.num_strings; ++i)
+    {
+        const auto& itr = _records[i];
+        if(itr.offset > _nstrings || itr.length > _nstrings - itr.offset) continue;
+        _hash_ids->emplace(itr.hash, std::string{ _strings + itr.offset, itr.length });
+    }
+
+    ::munmap(_addr, _size);
+    return true;
+}
+
+namespace
+{
 void
 update_critical_path(call_chain _chain, int64_t)
 {
@@ -778,7 +1107,12 @@ update_critical_path(call_chain _chain, int64_t)
         // auto _diff_tid = [_tid](const entry& _v) { return _v.tid != _tid; };
         //_chain.erase(std::remove_if(_chain.begin(), _chain.end(), _diff_tid),
         //             _chain.end());
-        combine_critical_path(complete_call_chain, std::move(_chain));
+        auto _combined = combine_critical_path(std::move(_chain));
+
+        OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+        std::unique_lock<std::mutex> _lk{ complete_call_mutex };
+        for(auto& itr : _combined)
+            complete_call_chain.emplace_back(itr);
     } catch(const std::exception& e)
     {
         std::cerr << "Thread exited with exception: " << e.what() << std::endl;
@@ -822,9 +1156,21 @@ compute_critical_trace()
         OMNITRACE_VERBOSE_F(1, "%s\n", JOIN("", _perf).c_str());
 
         _perf.reset().start();
-        save_call_chain_json(
-            tim::settings::compose_output_filename("call-chain", ".json"), "call_chain",
-            complete_call_chain, true, __FUNCTION__);
+        auto _format = get_critical_trace_format();
+        if(_format == "binary" || _format == "all")
+        {
+            auto _fname = tim::settings::compose_output_filename("call-chain", ".bin");
+            OMNITRACE_VERBOSE(0, "[%s] Outputting '%s'...\n", __FUNCTION__,
+                              _fname.c_str());
+            if(!save_call_chain_binary(_fname, complete_call_chain))
+                OMNITRACE_PRINT_F("Error writing '%s'\n", _fname.c_str());
+        }
+        if(_format == "json" || _format == "all")
+        {
+            save_call_chain_json(
+                tim::settings::compose_output_filename("call-chain", ".json"),
+                "call_chain", complete_call_chain, true, __FUNCTION__);
+        }
 
         _perf.stop().rekey("Save call-chain");
         OMNITRACE_VERBOSE_F(1, "%s\n", JOIN("", _perf).c_str());
@@ -856,7 +1202,7 @@ get_entries(int64_t _ts, const std::function<bool(const entry&)>& _eval)
             if(itr.phase != Phase::DELTA) continue;
             if(itr.begin_ns <= _ts && itr.end_ns >= _ts)
             {
-                if(_eval(itr)) _v.emplace_back(tim::get_hash_identifier(itr.hash), itr);
+                if(_eval(itr)) _v.emplace_back(get_hash_identifier(itr.hash), itr);
             }
         }
         *_targ = _v;
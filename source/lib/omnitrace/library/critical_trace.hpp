@@ -26,6 +26,7 @@
 #include "library/config.hpp"
 #include "library/defines.hpp"
 #include "library/runtime.hpp"
+#include "library/string_table.hpp"
 #include "library/thread_data.hpp"
 
 #include <timemory/backends/process.hpp>
@@ -156,7 +157,12 @@ entry::save(Archive& ar, unsigned int) const
 
     std::string _name{};
     auto        _hash = hash;
-    if(_hash > 0) _name = tim::get_hash_identifier(_hash);
+    if(_hash > 0)
+    {
+        // the regions are interned in the string table instead of timemory's hash map
+        const auto* _interned = string_table::find(_hash);
+        _name = (_interned) ? std::string{ _interned } : tim::get_hash_identifier(_hash);
+    }
 
     ar(cereal::make_nvp("name", _name),
        cereal::make_nvp("demangled_name", tim::demangle(_name)));
@@ -209,6 +215,7 @@ struct call_chain : private std::vector<entry>
     using base_type::cbegin;
     using base_type::cend;
     using base_type::clear;
+    using base_type::data;
     using base_type::emplace_back;
     using base_type::empty;
     using base_type::end;
@@ -219,6 +226,7 @@ struct call_chain : private std::vector<entry>
     using base_type::rbegin;
     using base_type::rend;
     using base_type::reserve;
+    using base_type::resize;
     using base_type::size;
 
     size_t  get_hash() const;
@@ -287,6 +295,31 @@ get_entries(
     int64_t                                  _ts,
     const std::function<bool(const entry&)>& _eval = [](const entry&) { return true; });
 
+/// sorts the call-chain and merges each Phase::BEGIN entry with its matching
+/// Phase::END entry into a Phase::DELTA entry
+void
+squash_critical_path(call_chain& _targ);
+
+/// merges the Phase::BEGIN and Phase::END entries of a call-chain which match
+/// and returns the sorted result
+call_chain
+combine_critical_path(call_chain _chain);
+
+/// writes the call-chain in the versioned binary columnar format with a
+/// deduplicated table of the names of the hashes
+bool
+save_call_chain_binary(const std::string& _fname, const call_chain& _chain);
+
+/// returns true if the file begins with the binary call-chain magic
+bool
+is_call_chain_binary(const std::string& _fname);
+
+/// memory-maps a file written by save_call_chain_binary, appends the entries to
+/// the call-chain directly from the mapped columns, and registers the names with
+/// timemory's hash ids
+bool
+load_call_chain_binary(const std::string& _fname, call_chain& _chain);
+
 struct id
 {};
 
@@ -0,0 +1,185 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/event_buffer.hpp"
+#include "library/categories.hpp"
+#include "library/config.hpp"
+#include "library/debug.hpp"
+#include "library/perfetto.hpp"
+#include "library/string_table.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/units.hpp>
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+namespace omnitrace
+{
+namespace event_buffer
+{
+namespace
+{
+struct buffer_registry
+{
+    std::mutex                  mutex   = {};
+    std::vector<thread_buffer*> buffers = {};
+};
+
+auto&
+get_registry()
+{
+    // intentional leak: the buffers of threads which have exited are converted at
+    // finalization and events may be recorded during static destruction
+    static auto* _v = new buffer_registry{};
+    return *_v;
+}
+
+size_t
+get_max_chunks()
+{
+    static auto _v = std::max<size_t>(
+        config::get_perfetto_event_buffer_size() * units::KB / sizeof(chunk), 1);
+    return _v;
+}
+
+// converts the records of the buffer into perfetto track events and marks the chunks
+// as empty. The caller must hold the mutex of the buffer
+size_t
+convert(thread_buffer* _buf)
+{
+    size_t _count = 0;
+    auto   _track = ::perfetto::ThreadTrack::ForThread(_buf->systid);
+    for(auto* _chunk = _buf->head; _chunk != nullptr;
+        _chunk       = _chunk->next.load(std::memory_order_acquire))
+    {
+        auto _n = _chunk->size.load(std::memory_order_acquire);
+        for(size_t i = 0; i < _n; ++i)
+        {
+            const auto& _rec = _chunk->data[i];
+            uint64_t    _ts  = _rec.timestamp;
+            if(_rec.phase == Begin)
+            {
+                const auto* _name = string_table::find(_rec.name);
+                TRACE_EVENT_BEGIN(trait::name<category::host>::value,
+                                  perfetto::StaticString((_name) ? _name : "<unknown>"),
+                                  _track, _ts, "begin_ns", _ts);
+            }
+            else
+            {
+                TRACE_EVENT_END(trait::name<category::host>::value, _track, _ts,
+                                "end_ns", _ts);
+            }
+        }
+        _chunk->size.store(0, std::memory_order_release);
+        _count += _n;
+    }
+    return _count;
+}
+}  // namespace
+
+thread_buffer*
+get_thread_buffer()
+{
+    auto* _chunk  = new chunk;
+    auto* _buf    = new thread_buffer{};
+    _buf->tid     = threading::get_id();
+    _buf->systid  = threading::get_sys_tid();
+    _buf->head    = _chunk;
+    _buf->tail    = _chunk;
+    _buf->nchunks = 1;
+
+    auto& _reg = get_registry();
+    auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+    _reg.buffers.emplace_back(_buf);
+    return _buf;
+}
+
+chunk*
+grow(thread_buffer* _buf)
+{
+    // the chunks after the tail were emptied by a previous conversion
+    auto* _next = _buf->tail->next.load(std::memory_order_acquire);
+    if(!_next && _buf->nchunks >= get_max_chunks())
+    {
+        // the records are converted on this thread so the buffer does not grow
+        // without bound. The emptied chunks are reused starting from the head
+        auto _lk = std::unique_lock<std::mutex>{ _buf->mutex };
+        _buf->converted += convert(_buf);
+        _buf->tail = _buf->head;
+        return _buf->tail;
+    }
+
+    if(!_next)
+    {
+        _next = new chunk;
+        ++_buf->nchunks;
+        // the conversion only follows the link after reading a full chunk
+        _buf->tail->next.store(_next, std::memory_order_release);
+    }
+    _buf->tail = _next;
+    return _next;
+}
+
+void
+clear()
+{
+    auto* _buf = get_this_thread_buffer();
+    auto  _lk  = std::unique_lock<std::mutex>{ _buf->mutex };
+    for(auto* _chunk = _buf->head; _chunk != nullptr;
+        _chunk       = _chunk->next.load(std::memory_order_acquire))
+        _chunk->size.store(0, std::memory_order_release);
+    _buf->tail = _buf->head;
+}
+
+void
+post_process()
+{
+    auto _buffers = std::vector<thread_buffer*>{};
+    {
+        auto& _reg = get_registry();
+        auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+        _buffers   = _reg.buffers;
+    }
+
+    size_t _total     = 0;
+    size_t _converted = 0;
+    for(auto* itr : _buffers)
+    {
+        auto _lk    = std::unique_lock<std::mutex>{ itr->mutex };
+        auto _count = convert(itr);
+        OMNITRACE_VERBOSE(2, "[event_buffer] thread %li recorded %zu events...\n",
+                          static_cast<long>(itr->tid), _count + itr->converted);
+        _total += _count + itr->converted;
+        _converted += itr->converted;
+    }
+
+    OMNITRACE_VERBOSE(1, "[event_buffer] Converted %zu events from %zu threads\n",
+                      _total, _buffers.size());
+    OMNITRACE_VERBOSE(1,
+                      "[event_buffer] %zu events were converted when a buffer reached "
+                      "the size limit\n",
+                      _converted);
+}
+}  // namespace event_buffer
+}  // namespace omnitrace
@@ -0,0 +1,138 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "library/defines.hpp"
+#include "library/timestamp.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace omnitrace
+{
+// a low-overhead alternative to emitting a perfetto track event for every host region
+// entry/exit: each thread appends fixed-size binary records to its own buffer (a
+// single-producer linked list of chunks which is not locked while appending) and the
+// records are converted to perfetto track events on the track of the thread which
+// recorded them during finalization. When a buffer reaches the size limit, the thread
+// converts its records and reuses the chunks
+namespace event_buffer
+{
+enum Phase : uint64_t
+{
+    Begin = 0,
+    End   = 1,
+};
+
+struct record
+{
+    uint64_t timestamp : 63;
+    uint64_t phase : 1;
+    uint64_t name;  // string_table id, i.e. valid after the library is unloaded
+};
+
+static_assert(sizeof(record) == 16, "event record should be 16 bytes");
+
+struct chunk
+{
+    static constexpr size_t capacity = 16384;
+
+    std::atomic<size_t> size = { 0 };
+    std::atomic<chunk*> next = { nullptr };
+    record              data[capacity];
+};
+
+struct thread_buffer
+{
+    int64_t    tid       = 0;        // internal thread id
+    int64_t    systid    = 0;        // system thread id (perfetto thread track)
+    chunk*     head      = nullptr;  // first chunk, read at finalization
+    chunk*     tail      = nullptr;  // chunk currently being written to
+    size_t     nchunks   = 0;        // number of chunks allocated
+    size_t     converted = 0;        // number of records converted when the limit was hit
+    std::mutex mutex     = {};       // serializes the conversions of this buffer
+};
+
+// returns the buffer of the calling thread, creating and registering it if necessary
+thread_buffer*
+get_thread_buffer();
+
+// returns the next chunk of the buffer of the calling thread: a chunk which was reused,
+// a new chunk, or, when the size limit is reached, the first chunk after converting
+// the records
+chunk*
+grow(thread_buffer*);
+
+// returns the buffer of the calling thread
+inline thread_buffer*
+get_this_thread_buffer()
+{
+    static thread_local auto* _v = get_thread_buffer();
+    return _v;
+}
+
+inline void
+emplace(uint64_t _name, Phase _phase)
+{
+    auto* _buf = get_this_thread_buffer();
+
+    auto* _chunk = _buf->tail;
+    auto  _n     = _chunk->size.load(std::memory_order_relaxed);
+    if(_n == chunk::capacity)
+    {
+        _chunk = grow(_buf);
+        _n     = 0;
+    }
+
+    auto& _rec     = _chunk->data[_n];
+    _rec.timestamp = timestamp::now();
+    _rec.phase     = _phase;
+    _rec.name      = _name;
+    // publishing the size makes the record visible to the conversion
+    _chunk->size.store(_n + 1, std::memory_order_release);
+}
+
+inline void
+begin(uint64_t _name)
+{
+    emplace(_name, Begin);
+}
+
+inline void
+end()
+{
+    // the end of a track event does not have a name
+    emplace(0, End);
+}
+
+// discards the records of the calling thread
+void
+clear();
+
+// converts the records of every thread into perfetto track events
+void
+post_process();
+}  // namespace event_buffer
+}  // namespace omnitrace
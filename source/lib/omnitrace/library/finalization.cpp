@@ -0,0 +1,273 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/finalization.hpp"
+#include "library/config.hpp"
+#include "library/debug.hpp"
+#include "library/ptl.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <utility>
+
+namespace omnitrace
+{
+namespace finalization
+{
+namespace
+{
+using clock_type = std::chrono::steady_clock;
+
+double
+get_elapsed(clock_type::time_point _beg)
+{
+    return std::chrono::duration<double>{ clock_type::now() - _beg }.count();
+}
+
+const char*
+get_policy_name(stage_policy _v)
+{
+    switch(_v)
+    {
+        case stage_policy::concurrent: return "concurrent";
+        case stage_policy::serialized: return "serialized";
+        case stage_policy::calling_thread: return "calling thread";
+    }
+    return "unknown";
+}
+}  // namespace
+
+stage_graph&
+stage_graph::add(std::string _name, std::vector<std::string> _depends,
+                 std::function<void()> _functor, stage_policy _policy)
+{
+    OMNITRACE_CI_THROW(exists(_name), "Duplicate finalization stage: %s\n",
+                       _name.c_str());
+
+    auto _deps = std::vector<size_t>{};
+    for(const auto& itr : _depends)
+    {
+        if(std::find(m_disabled.begin(), m_disabled.end(), itr) != m_disabled.end())
+            continue;
+
+        auto _stage = std::find_if(m_stages.begin(), m_stages.end(),
+                                   [&itr](const stage& _v) { return _v.name == itr; });
+        if(_stage == m_stages.end())
+        {
+            OMNITRACE_THROW("Finalization stage '%s' depends on unknown stage '%s'\n",
+                            _name.c_str(), itr.c_str());
+        }
+        _deps.emplace_back(std::distance(m_stages.begin(), _stage));
+    }
+
+    m_stages.emplace_back(
+        stage{ std::move(_name), std::move(_depends), std::move(_functor), _policy });
+    m_depends.emplace_back(std::move(_deps));
+    return *this;
+}
+
+stage_graph&
+stage_graph::disable(std::string _name)
+{
+    OMNITRACE_CI_THROW(exists(_name), "Duplicate finalization stage: %s\n",
+                       _name.c_str());
+
+    m_disabled.emplace_back(std::move(_name));
+    return *this;
+}
+
+bool
+stage_graph::exists(const std::string& _name) const
+{
+    return std::any_of(m_stages.begin(), m_stages.end(),
+                       [&_name](const stage& _v) { return _v.name == _name; }) ||
+           std::find(m_disabled.begin(), m_disabled.end(), _name) != m_disabled.end();
+}
+
+void
+stage_graph::execute(bool _parallel)
+{
+    const auto _beg     = clock_type::now();
+    const auto _nstages = m_stages.size();
+    if(_nstages == 0) return;
+
+    auto _mutex     = std::mutex{};
+    auto _exception = std::exception_ptr{};
+
+    // a stage is skipped when one of its dependencies did not complete
+    auto _run = [&](size_t _idx) {
+        auto& _stage = m_stages.at(_idx);
+        for(auto itr : m_depends.at(_idx))
+        {
+            if(!m_stages.at(itr).completed)
+            {
+                OMNITRACE_VERBOSE(0,
+                                  "[finalize] stage '%s' skipped because '%s' failed\n",
+                                  _stage.name.c_str(), m_stages.at(itr).name.c_str());
+                return;
+            }
+        }
+
+        auto _t0 = clock_type::now();
+        try
+        {
+            _stage.functor();
+            _stage.completed = true;
+        } catch(std::exception& _e)
+        {
+            OMNITRACE_VERBOSE(0, "[finalize] stage '%s' failed: %s\n",
+                              _stage.name.c_str(), _e.what());
+            auto _lk = std::unique_lock<std::mutex>{ _mutex };
+            if(!_exception) _exception = std::current_exception();
+        } catch(...)
+        {
+            OMNITRACE_VERBOSE(0, "[finalize] stage '%s' failed\n", _stage.name.c_str());
+            auto _lk = std::unique_lock<std::mutex>{ _mutex };
+            if(!_exception) _exception = std::current_exception();
+        }
+        _stage.elapsed = get_elapsed(_t0);
+    };
+
+    if(!_parallel)
+    {
+        // the insertion order is a valid topological order
+        for(size_t i = 0; i < _nstages; ++i)
+            _run(i);
+    }
+    else
+    {
+        auto _serial_mutex = std::mutex{};
+        auto _cv           = std::condition_variable{};
+        auto _queue        = std::deque<size_t>{};
+        auto _finished     = size_t{ 0 };
+        auto _remaining    = std::vector<size_t>(_nstages, 0);
+        auto _dependents   = std::vector<std::vector<size_t>>(_nstages);
+        auto _ready        = std::vector<size_t>{};
+
+        for(size_t i = 0; i < _nstages; ++i)
+        {
+            _remaining.at(i) = m_depends.at(i).size();
+            for(auto itr : m_depends.at(i))
+                _dependents.at(itr).emplace_back(i);
+            if(_remaining.at(i) == 0) _ready.emplace_back(i);
+        }
+
+        auto _tg       = PTL::TaskGroup<void>{ &tasking::get_thread_pool() };
+        auto _execute  = std::function<void(size_t)>{};
+        auto _dispatch = [&](const std::vector<size_t>& _idxs) {
+            // submitting to the task-group is done without holding the lock because
+            // the thread-pool may execute the task immediately
+            for(auto itr : _idxs)
+            {
+                if(m_stages.at(itr).policy == stage_policy::calling_thread)
+                {
+                    auto _lk = std::unique_lock<std::mutex>{ _mutex };
+                    _queue.emplace_back(itr);
+                    _cv.notify_all();
+                }
+                else
+                {
+                    _tg.run([&_execute, itr]() { _execute(itr); });
+                }
+            }
+        };
+
+        _execute = [&](size_t _idx) {
+            if(m_stages.at(_idx).policy == stage_policy::serialized)
+            {
+                auto _lk = std::unique_lock<std::mutex>{ _serial_mutex };
+                _run(_idx);
+            }
+            else
+            {
+                _run(_idx);
+            }
+
+            auto _next = std::vector<size_t>{};
+            {
+                auto _lk = std::unique_lock<std::mutex>{ _mutex };
+                ++_finished;
+                for(auto itr : _dependents.at(_idx))
+                {
+                    if(--_remaining.at(itr) == 0) _next.emplace_back(itr);
+                }
+                _cv.notify_all();
+            }
+            _dispatch(_next);
+        };
+
+        _dispatch(_ready);
+
+        while(true)
+        {
+            size_t _idx = 0;
+            {
+                auto _lk = std::unique_lock<std::mutex>{ _mutex };
+                _cv.wait(_lk, [&]() { return !_queue.empty() || _finished == _nstages; });
+                if(_queue.empty()) break;
+                _idx = _queue.front();
+                _queue.pop_front();
+            }
+            _execute(_idx);
+        }
+
+        _tg.join();
+    }
+
+    report(get_elapsed(_beg));
+
+    if(_exception) std::rethrow_exception(_exception);
+}
+
+void
+stage_graph::report(double _elapsed) const
+{
+    size_t _width = 0;
+    double _total = 0.0;
+    for(const auto& itr : m_stages)
+    {
+        _width = std::max(_width, itr.name.length());
+        _total += itr.elapsed;
+    }
+
+    for(const auto& itr : m_stages)
+    {
+        OMNITRACE_VERBOSE(1, "[finalize] %-*s : %8.3f sec (%s)%s\n",
+                          static_cast<int>(_width), itr.name.c_str(), itr.elapsed,
+                          get_policy_name(itr.policy),
+                          (itr.completed) ? "" : " [incomplete]");
+    }
+
+    if(m_stages.size() < 2) return;
+
+    OMNITRACE_VERBOSE(1,
+                      "[finalize] %zu stages completed in %.3f sec (%.3f sec in total)\n",
+                      m_stages.size(), _elapsed, _total);
+}
+}  // namespace finalization
+}  // namespace omnitrace
@@ -0,0 +1,91 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "library/defines.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace omnitrace
+{
+// the post-processing performed at finalization expressed as a dependency graph of
+// stages. Stages whose dependencies have completed run concurrently on the thread-pool
+// and the time spent in each stage is reported
+namespace finalization
+{
+enum class stage_policy : uint8_t
+{
+    concurrent = 0,  // runs on the thread-pool alongside any other stage
+    serialized,      // runs on the thread-pool but never alongside other serialized
+                     // stages, e.g. stages which register output with tim::manager
+    calling_thread,  // runs on the thread which executes the graph, e.g. stages which
+                     // record into the timemory storage of that thread or which
+                     // submit their own tasks to the thread-pool and join them
+};
+
+struct stage
+{
+    std::string              name      = {};
+    std::vector<std::string> depends   = {};
+    std::function<void()>    functor   = {};
+    stage_policy             policy    = stage_policy::concurrent;
+    double                   elapsed   = 0.0;    // [sec]
+    bool                     completed = false;  // false if the stage (or one of its
+                                                 // dependencies) threw an exception
+};
+
+class stage_graph
+{
+public:
+    // dependencies must name stages which were added or disabled beforehand so the
+    // insertion order is always a valid serial order. Naming any other stage throws
+    stage_graph& add(std::string, std::vector<std::string>, std::function<void()>,
+                     stage_policy = stage_policy::concurrent);
+
+    // declares a stage which is not enabled: the dependencies on it are satisfied
+    stage_graph& disable(std::string);
+
+    // runs every stage. When _parallel is false, the stages are run on the calling
+    // thread in the order they were added. The first exception thrown by a stage is
+    // rethrown once every stage which does not depend on it has completed
+    void execute(bool _parallel);
+
+    size_t                    size() const { return m_stages.size(); }
+    const std::vector<stage>& get() const { return m_stages; }
+
+private:
+    void report(double) const;
+
+    bool exists(const std::string&) const;
+
+    std::vector<stage>               m_stages   = {};
+    std::vector<std::vector<size_t>> m_depends  = {};
+    std::vector<std::string>         m_disabled = {};
+};
+}  // namespace finalization
+}  // namespace omnitrace
@@ -0,0 +1,315 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/flight_recorder.hpp"
+#include "library/config.hpp"
+#include "library/debug.hpp"
+#include "library/perfetto.hpp"
+#include "library/region_gate.hpp"
+#include "library/runtime.hpp"
+#include "library/state.hpp"
+#include "library/string_table.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/units.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <semaphore.h>
+
+namespace omnitrace
+{
+namespace flight_recorder
+{
+namespace
+{
+struct recorder
+{
+    sem_t                        semaphore = {};
+    std::atomic<bool>            running   = { false };
+    std::atomic<bool>            pending   = { false };
+    std::atomic<size_t>          count     = { 0 };
+    int                          signum    = 0;
+    struct sigaction             previous  = {};
+    std::vector<uint64_t>        triggers  = {};
+    std::unique_ptr<std::thread> thread    = {};
+    // the snapshots are read from a separate session because reading a session
+    // consumes its buffer
+    std::unique_ptr<perfetto::TracingSession> session = {};
+};
+
+auto&
+get_recorder()
+{
+    // intentional leak: the signal handler and the trigger regions may be invoked
+    // during static destruction
+    static auto* _v = new recorder{};
+    return *_v;
+}
+
+// e.g. perfetto-trace-<pid>.proto -> perfetto-trace-<pid>-snapshot-<N>.proto
+std::string
+get_snapshot_filename(size_t _idx)
+{
+    auto _fname   = get_perfetto_output_filename();
+    auto _pos_dir = _fname.find_last_of('/');
+    auto _pos_ext = _fname.find_last_of('.');
+    if(_pos_ext == std::string::npos ||
+       (_pos_dir != std::string::npos && _pos_ext < _pos_dir))
+        _pos_ext = _fname.length();
+    return JOIN("", _fname.substr(0, _pos_ext), "-snapshot-", _idx,
+                _fname.substr(_pos_ext));
+}
+
+void
+write_snapshot()
+{
+    auto& tracing_session = get_recorder().session;
+    if(!tracing_session) return;
+
+    // commit the chunks which are still being written into by the instrumented threads.
+    // The threads are not paused: events recorded after this point are either part of
+    // this snapshot or the next one
+    tracing_session->FlushBlocking();
+    auto _data = tracing_session->ReadTraceBlocking();
+    if(_data.empty())
+    {
+        OMNITRACE_VERBOSE(1, "[flight-recorder] trace data is empty. Snapshot will not "
+                             "be written...\n");
+        return;
+    }
+
+    auto& _rec   = get_recorder();
+    auto  _fname = get_snapshot_filename(_rec.count.load());
+    auto  ofs    = std::ofstream{};
+    if(!tim::filepath::open(ofs, _fname, std::ios::out | std::ios::binary))
+    {
+        OMNITRACE_VERBOSE(0, "[flight-recorder] Error opening '%s'...\n", _fname.c_str());
+        return;
+    }
+    ofs.write(_data.data(), _data.size());
+    ofs.close();
+
+    OMNITRACE_VERBOSE(0, "[flight-recorder] Wrote snapshot %zu (%.2f KB) to '%s'\n",
+                      _rec.count.load(), static_cast<double>(_data.size()) / units::KB,
+                      _fname.c_str());
+    ++_rec.count;
+}
+
+void
+poll(recorder* _rec)
+{
+    threading::offset_this_id(true);
+    threading::set_thread_name("omni.recorder");
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    while(true)
+    {
+        if(sem_wait(&_rec->semaphore) != 0)
+        {
+            if(errno == EINTR) continue;
+            OMNITRACE_VERBOSE(0, "[flight-recorder] sem_wait failed: %s\n",
+                              strerror(errno));
+            break;
+        }
+        // the request is cleared before the buffer is read so that a request made
+        // while the snapshot is written produces another snapshot
+        if(_rec->pending.exchange(false)) write_snapshot();
+        if(!_rec->running.load()) break;
+    }
+}
+
+void
+handle_signal(int)
+{
+    auto _errno = errno;
+    request();
+    errno = _errno;
+}
+}  // namespace
+
+bool
+enabled()
+{
+    return get_use_perfetto() && get_perfetto_flight_recorder() &&
+           !get_perfetto_streaming() && get_backend() == "inprocess";
+}
+
+bool
+has_triggers()
+{
+    return get_recorder().running.load(std::memory_order_acquire) &&
+           !get_recorder().triggers.empty();
+}
+
+void
+setup(const perfetto::TraceConfig& _main_cfg)
+{
+    if(get_perfetto_flight_recorder() && !enabled())
+    {
+        OMNITRACE_VERBOSE_F(0, "The perfetto flight recorder requires the in-process "
+                               "backend without streaming. Flight recorder is "
+                               "disabled...\n");
+        return;
+    }
+
+    auto& _rec = get_recorder();
+    if(!enabled() || _rec.thread) return;
+
+    if(get_perfetto_event_buffer())
+    {
+        OMNITRACE_VERBOSE_F(0, "Warning! the event buffers are converted to perfetto "
+                               "when they are full or during finalization so most of the "
+                               "instrumented functions will not be present in the "
+                               "flight-recorder snapshots\n");
+    }
+
+    if(sem_init(&_rec.semaphore, 0, 0) != 0)
+    {
+        OMNITRACE_VERBOSE_F(0, "sem_init failed: %s. Flight recorder is disabled...\n",
+                            strerror(errno));
+        return;
+    }
+
+    // the snapshot session records the same data sources into a separately sized buffer
+    // which wraps around. Perfetto has no non-destructive read of a session so each
+    // snapshot drains it
+    auto _cfg = _main_cfg;
+    _cfg.clear_buffers();
+    auto* _buffer_cfg = _cfg.add_buffers();
+    _buffer_cfg->set_size_kb(get_perfetto_flight_recorder_buffer_size());
+    _buffer_cfg->set_fill_policy(
+        perfetto::protos::gen::TraceConfig_BufferConfig_FillPolicy_RING_BUFFER);
+    // periodically re-emit the interned strings and track descriptors so that the
+    // window in each snapshot can be decoded on its own
+    _cfg.mutable_incremental_state_config()->set_clear_period_ms(1000);
+
+    _rec.session = perfetto::Tracing::NewTrace();
+    _rec.session->Setup(_cfg);
+    _rec.session->StartBlocking();
+
+    for(const auto& itr : get_perfetto_flight_recorder_triggers())
+    {
+        OMNITRACE_VERBOSE_F(1, "Flight-recorder snapshot trigger: '%s'\n", itr.c_str());
+        _rec.triggers.emplace_back(string_table::get_id(itr));
+    }
+
+    _rec.running.store(true);
+    // the entry into a region is only checked against the triggers when the gate says so
+    region_gate::invalidate();
+
+    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+    _rec.thread = std::make_unique<std::thread>(&poll, &_rec);
+
+    auto _signum = get_perfetto_flight_recorder_signal();
+    if(_signum > 0 && get_use_sampling() && get_sampling_signals().count(_signum) > 0)
+    {
+        OMNITRACE_VERBOSE_F(0,
+                            "Flight-recorder signal %i is used for sampling. Snapshots "
+                            "cannot be requested via a signal...\n",
+                            _signum);
+    }
+    else if(_signum > 0)
+    {
+        struct sigaction _action = {};
+        sigemptyset(&_action.sa_mask);
+        _action.sa_flags   = SA_RESTART;
+        _action.sa_handler = &handle_signal;
+        if(sigaction(_signum, &_action, &_rec.previous) == 0)
+        {
+            _rec.signum = _signum;
+            OMNITRACE_VERBOSE_F(1, "Flight-recorder snapshots are written on signal %i\n",
+                                _signum);
+        }
+        else
+        {
+            OMNITRACE_VERBOSE_F(0, "Error installing the flight-recorder handler for "
+                                   "signal %i: %s\n",
+                                _signum, strerror(errno));
+        }
+    }
+}
+
+void
+shutdown()
+{
+    auto& _rec = get_recorder();
+    if(!_rec.thread) return;
+
+    if(_rec.signum > 0)
+    {
+        sigaction(_rec.signum, &_rec.previous, nullptr);
+        _rec.signum = 0;
+    }
+
+    // a pending request is written before the thread exits. The semaphore is not
+    // destroyed since a late request may still post to it
+    _rec.running.store(false);
+    sem_post(&_rec.semaphore);
+    _rec.thread->join();
+    _rec.thread.reset();
+
+    if(_rec.session)
+    {
+        _rec.session->StopBlocking();
+        _rec.session.reset();
+    }
+
+    OMNITRACE_VERBOSE_F(1, "Flight recorder wrote %zu snapshot(s)\n", _rec.count.load());
+}
+
+bool
+request()
+{
+    auto& _rec = get_recorder();
+    if(!_rec.running.load(std::memory_order_acquire)) return false;
+    if(!_rec.pending.exchange(true)) sem_post(&_rec.semaphore);
+    return true;
+}
+
+void
+trigger(uint64_t _hash)
+{
+    const auto& _triggers = get_recorder().triggers;
+    if(std::find(_triggers.begin(), _triggers.end(), _hash) != _triggers.end())
+        request();
+}
+
+size_t
+get_count()
+{
+    return get_recorder().count.load();
+}
+}  // namespace flight_recorder
+}  // namespace omnitrace
@@ -0,0 +1,76 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "library/defines.hpp"
+#include "library/perfetto.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+// flight-recorder mode of the perfetto backend. The events are also recorded into the
+// in-memory ring buffer of a second tracing session and, whenever a snapshot is
+// requested via the configured signal, the omnitrace_dump_trace API, or the entry into
+// one of the trigger regions, a background thread reads that buffer into a new
+// numbered file while the instrumented threads continue to record into it. Reading the
+// buffer consumes the data so each snapshot only contains the events recorded since
+// the previous one. The main tracing session is never read so the trace written at
+// finalization is complete
+namespace flight_recorder
+{
+// returns true if the flight recorder is configured and the tracing session is
+// in-process
+bool
+enabled();
+
+// returns true if entering a region may request a snapshot
+bool
+has_triggers();
+
+// starts the snapshot tracing session with the data sources of the given config,
+// installs the signal handler, and starts the background thread
+void
+setup(const perfetto::TraceConfig&);
+
+// writes the pending snapshot (if any), joins the background thread, and stops the
+// snapshot tracing session
+void
+shutdown();
+
+// requests a snapshot. Requests made while another one is pending are coalesced.
+// Returns false if the flight recorder is not running. Async-signal-safe
+bool
+request();
+
+// requests a snapshot if the hash is one of the trigger regions
+void
+trigger(uint64_t _hash);
+
+// number of snapshots written so far
+size_t
+get_count();
+}  // namespace flight_recorder
+}  // namespace omnitrace
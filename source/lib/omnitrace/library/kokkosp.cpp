@@ -30,6 +30,7 @@
 #include "library/defines.hpp"
 #include "library/perfetto.hpp"
 #include "library/runtime.hpp"
+#include "library/string_table.hpp"
 
 #include <timemory/api/kokkosp.hpp>
 #include <timemory/backends/process.hpp>
@@ -446,9 +447,9 @@ extern "C"
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
         if(omnitrace::config::get_use_perfetto())
         {
-            auto _name = tim::get_hash_identifier_fast(
-                tim::add_hash_id(TIMEMORY_JOIN(" ", "[kokkos][dual_view_sync]", label)));
-            TRACE_EVENT_INSTANT("user", ::perfetto::StaticString{ _name.data() },
+            const auto* _name = omnitrace::string_table::get(
+                TIMEMORY_JOIN(" ", "[kokkos][dual_view_sync]", label));
+            TRACE_EVENT_INSTANT("user", ::perfetto::StaticString{ _name },
                                 "target", (is_device) ? "device" : "host");
         }
     }
@@ -458,9 +459,9 @@ extern "C"
         OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
         if(omnitrace::config::get_use_perfetto())
         {
-            auto _name = tim::get_hash_identifier_fast(tim::add_hash_id(
-                TIMEMORY_JOIN(" ", "[kokkos][dual_view_modify]", label)));
-            TRACE_EVENT_INSTANT("user", ::perfetto::StaticString{ _name.data() },
+            const auto* _name = omnitrace::string_table::get(
+                TIMEMORY_JOIN(" ", "[kokkos][dual_view_modify]", label));
+            TRACE_EVENT_INSTANT("user", ::perfetto::StaticString{ _name },
                                 "target", (is_device) ? "device" : "host");
         }
     }
@@ -0,0 +1,574 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/lock_contention.hpp"
+#include "library/common.hpp"
+#include "library/config.hpp"
+#include "library/debug.hpp"
+#include "library/timestamp.hpp"
+
+#include <timemory/backends/threading.hpp>
+#include <timemory/settings.hpp>
+#include <timemory/tpls/cereal/cereal.hpp>
+#include <timemory/utility/demangle.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <link.h>
+
+#define OMNITRACE_SERIALIZE(MEMBER_VARIABLE)                                             \
+    ar(::tim::cereal::make_nvp(#MEMBER_VARIABLE, MEMBER_VARIABLE))
+
+namespace omnitrace
+{
+namespace lock_contention
+{
+namespace
+{
+// log-linear histogram of durations in nanoseconds with four buckets per power of two,
+// i.e. the percentiles are accurate to within ~12%
+struct histogram
+{
+    static constexpr size_t sub_buckets = 4;
+    static constexpr size_t size        = 64 * sub_buckets;
+
+    static size_t   get_index(uint64_t _v);
+    static uint64_t get_value(size_t _idx);
+
+    void     add(uint64_t _v) { ++counts[get_index(_v)]; }
+    uint64_t percentile(double _q, uint64_t _max) const;
+
+    histogram& operator+=(const histogram& _rhs)
+    {
+        for(size_t i = 0; i < size; ++i)
+            counts[i] += _rhs.counts[i];
+        return *this;
+    }
+
+    std::array<uint32_t, size> counts = {};
+};
+
+size_t
+histogram::get_index(uint64_t _v)
+{
+    if(_v < sub_buckets) return _v;
+    auto _msb = static_cast<size_t>(63 - __builtin_clzll(_v));
+    auto _sub = static_cast<size_t>(_v >> (_msb - 2)) & (sub_buckets - 1);
+    return ((_msb - 1) * sub_buckets) + _sub;
+}
+
+uint64_t
+histogram::get_value(size_t _idx)
+{
+    // midpoint of the bucket
+    if(_idx < sub_buckets) return _idx;
+    auto _msb   = (_idx / sub_buckets) + 1;
+    auto _width = uint64_t{ 1 } << (_msb - 2);
+    return ((sub_buckets + (_idx % sub_buckets)) * _width) + (_width / 2);
+}
+
+uint64_t
+histogram::percentile(double _q, uint64_t _max) const
+{
+    uint64_t _total = 0;
+    for(auto itr : counts)
+        _total += itr;
+    if(_total == 0) return 0;
+
+    auto     _target = std::max<uint64_t>(_q * _total, 1);
+    uint64_t _sum    = 0;
+    for(size_t i = 0; i < size; ++i)
+    {
+        _sum += counts[i];
+        if(_sum >= _target) return std::min(get_value(i), _max);
+    }
+    return _max;
+}
+
+struct duration_data
+{
+    size_t    count = 0;
+    uint64_t  total = 0;
+    uint64_t  max   = 0;
+    histogram hist  = {};
+
+    void add(uint64_t _v)
+    {
+        count += 1;
+        total += _v;
+        max = std::max(max, _v);
+        hist.add(_v);
+    }
+
+    duration_data& operator+=(const duration_data& _rhs)
+    {
+        count += _rhs.count;
+        total += _rhs.total;
+        max = std::max(max, _rhs.max);
+        hist += _rhs.hist;
+        return *this;
+    }
+};
+
+struct site_data
+{
+    lock_kind     kind      = lock_kind::mutex;
+    size_t        count     = 0;  // number of acquisitions
+    size_t        contended = 0;  // number of acquisitions which blocked
+    duration_data wait      = {};
+    duration_data hold      = {};
+};
+
+// lock address + return address of the call which acquired the lock
+using site_key_t = std::pair<uintptr_t, uintptr_t>;
+
+struct site_key_hash
+{
+    size_t operator()(const site_key_t& _v) const
+    {
+        return std::hash<uintptr_t>{}(_v.first) ^ (std::hash<uintptr_t>{}(_v.second) << 1);
+    }
+};
+
+struct held_lock
+{
+    uintptr_t  lock  = 0;
+    uint64_t   start = 0;
+    site_data* data  = nullptr;
+};
+
+// element references of an unordered_map remain valid after a rehash so the held
+// locks can refer to the site data directly
+struct thread_locks
+{
+    int64_t                                                  tid   = 0;
+    std::unordered_map<site_key_t, site_data, site_key_hash> sites = {};
+    std::vector<held_lock>                                   held  = {};
+};
+
+struct locks_registry
+{
+    std::mutex                 mutex = {};
+    std::vector<thread_locks*> data  = {};
+};
+
+auto&
+get_registry()
+{
+    // intentional leak: the data of threads which have exited is reported at finalization
+    static auto* _v = new locks_registry{};
+    return *_v;
+}
+
+thread_locks&
+get_thread_locks()
+{
+    static thread_local auto* _v = []() {
+        auto* _data = new thread_locks{};
+        _data->tid  = threading::get_id();
+        _data->held.reserve(16);
+        auto& _reg = get_registry();
+        auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+        _reg.data.emplace_back(_data);
+        return _data;
+    }();
+    return *_v;
+}
+
+// the lock wrappers are in this library so the call-site is the first frame of the
+// call-stack which is outside of the address range of this library
+struct address_range
+{
+    uintptr_t first = std::numeric_limits<uintptr_t>::max();
+    uintptr_t last  = 0;
+    uintptr_t addr  = 0;
+
+    bool contains(uintptr_t _v) const { return (_v >= first && _v < last); }
+};
+
+const address_range&
+get_library_range()
+{
+    static auto _v = []() {
+        auto _range = address_range{};
+        _range.addr = reinterpret_cast<uintptr_t>(&get_library_range);
+        dl_iterate_phdr(
+            [](dl_phdr_info* _info, size_t, void* _data) -> int {
+                auto* _range = static_cast<address_range*>(_data);
+                auto  _tmp   = address_range{};
+                for(int i = 0; i < _info->dlpi_phnum; ++i)
+                {
+                    const auto& _phdr = _info->dlpi_phdr[i];
+                    if(_phdr.p_type != PT_LOAD) continue;
+                    auto _beg = _info->dlpi_addr + _phdr.p_vaddr;
+                    _tmp.first = std::min<uintptr_t>(_tmp.first, _beg);
+                    _tmp.last  = std::max<uintptr_t>(_tmp.last, _beg + _phdr.p_memsz);
+                }
+                if(!_tmp.contains(_range->addr)) return 0;
+                _range->first = _tmp.first;
+                _range->last  = _tmp.last;
+                return 1;
+            },
+            &_range);
+        return _range;
+    }();
+    return _v;
+}
+
+uintptr_t
+get_call_site()
+{
+    constexpr int _max_depth = 16;
+
+    const auto& _range = get_library_range();
+    void*       _stack[_max_depth];
+    auto        _depth = ::backtrace(_stack, _max_depth);
+    for(int i = 0; i < _depth; ++i)
+    {
+        auto _addr = reinterpret_cast<uintptr_t>(_stack[i]);
+        if(!_range.contains(_addr)) return _addr;
+    }
+    return 0;
+}
+
+std::string
+get_symbol_name(uintptr_t _addr, bool _module)
+{
+    auto _info = Dl_info{};
+    if(_addr == 0 || dladdr(reinterpret_cast<void*>(_addr), &_info) == 0)
+        return std::string{};
+
+    auto _hex = [](uintptr_t _v) { return TIMEMORY_JOIN("", "0x", std::hex, _v); };
+    if(_info.dli_sname && _info.dli_saddr)
+    {
+        auto _offset = _addr - reinterpret_cast<uintptr_t>(_info.dli_saddr);
+        auto _name   = tim::demangle(_info.dli_sname);
+        return (_offset == 0) ? _name : JOIN('+', _name, _hex(_offset));
+    }
+    if(_module && _info.dli_fname && _info.dli_fbase)
+    {
+        auto _offset = _addr - reinterpret_cast<uintptr_t>(_info.dli_fbase);
+        auto _fname  = std::string_view{ _info.dli_fname };
+        auto _pos    = _fname.find_last_of('/');
+        if(_pos != std::string_view::npos) _fname = _fname.substr(_pos + 1);
+        return JOIN('+', _fname, _hex(_offset));
+    }
+    return std::string{};
+}
+
+const char*
+get_kind_name(lock_kind _v)
+{
+    switch(_v)
+    {
+        case lock_kind::mutex: return "mutex";
+        case lock_kind::rwlock_read: return "rwlock_read";
+        case lock_kind::rwlock_write: return "rwlock_write";
+        case lock_kind::spinlock: return "spinlock";
+        case lock_kind::barrier: return "barrier";
+    }
+    return "unknown";
+}
+
+struct duration_summary
+{
+    uint64_t total = 0;
+    uint64_t max   = 0;
+    uint64_t p50   = 0;
+    uint64_t p90   = 0;
+    uint64_t p99   = 0;
+
+    duration_summary() = default;
+    explicit duration_summary(const duration_data& _v)
+    : total{ _v.total }
+    , max{ _v.max }
+    , p50{ _v.hist.percentile(0.50, _v.max) }
+    , p90{ _v.hist.percentile(0.90, _v.max) }
+    , p99{ _v.hist.percentile(0.99, _v.max) }
+    {}
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        OMNITRACE_SERIALIZE(total);
+        OMNITRACE_SERIALIZE(max);
+        OMNITRACE_SERIALIZE(p50);
+        OMNITRACE_SERIALIZE(p90);
+        OMNITRACE_SERIALIZE(p99);
+    }
+};
+
+struct site_summary
+{
+    std::string       type      = {};
+    std::string       lock      = {};
+    std::string       name      = {};
+    std::string       call_site = {};
+    size_t            count     = 0;
+    size_t            contended = 0;
+    duration_summary  wait      = {};
+    duration_summary  hold      = {};
+    std::set<int64_t> threads   = {};
+
+    template <typename ArchiveT>
+    void serialize(ArchiveT& ar, const unsigned)
+    {
+        OMNITRACE_SERIALIZE(type);
+        OMNITRACE_SERIALIZE(lock);
+        OMNITRACE_SERIALIZE(name);
+        OMNITRACE_SERIALIZE(call_site);
+        OMNITRACE_SERIALIZE(count);
+        OMNITRACE_SERIALIZE(contended);
+        OMNITRACE_SERIALIZE(wait);
+        OMNITRACE_SERIALIZE(hold);
+        OMNITRACE_SERIALIZE(threads);
+    }
+};
+}  // namespace
+
+bool
+enabled()
+{
+    return (get_trace_thread_lock_profile() || contention_only());
+}
+
+bool
+contention_only()
+{
+    return get_trace_thread_lock_contention();
+}
+
+void
+acquire(uintptr_t _lock, lock_kind _kind, uint64_t _wait, bool _contended)
+{
+    // in the contention-only mode, the unlock functions are not wrapped
+    static bool _track_hold = !contention_only();
+
+    auto& _thr  = get_thread_locks();
+    auto& _data = _thr.sites[site_key_t{ _lock, get_call_site() }];
+    _data.kind  = _kind;
+    _data.count += 1;
+    if(_contended) _data.contended += 1;
+    _data.wait.add(_wait);
+
+    if(_track_hold && _kind != lock_kind::barrier)
+    {
+        // locks which were released without a wrapper (e.g. by pthread_cond_wait
+        // before being destroyed) would otherwise accumulate
+        if(_thr.held.size() >= 64) _thr.held.erase(_thr.held.begin());
+        _thr.held.emplace_back(held_lock{ _lock, timestamp::now(), &_data });
+    }
+}
+
+void
+release(uintptr_t _lock)
+{
+    auto& _held = get_thread_locks().held;
+    // locks are typically released in the reverse order of acquisition
+    for(auto itr = _held.rbegin(); itr != _held.rend(); ++itr)
+    {
+        if(itr->lock != _lock) continue;
+        itr->data->hold.add(timestamp::now() - itr->start);
+        _held.erase(std::next(itr).base());
+        return;
+    }
+}
+
+void
+post_process()
+{
+    struct merged_data
+    {
+        site_data         data    = {};
+        std::set<int64_t> threads = {};
+    };
+
+    auto _merged = std::map<site_key_t, merged_data>{};
+    {
+        auto& _reg = get_registry();
+        auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+        for(const auto* titr : _reg.data)
+        {
+            for(const auto& sitr : titr->sites)
+            {
+                auto& _v     = _merged[sitr.first];
+                _v.data.kind = sitr.second.kind;
+                _v.data.count += sitr.second.count;
+                _v.data.contended += sitr.second.contended;
+                _v.data.wait += sitr.second.wait;
+                _v.data.hold += sitr.second.hold;
+                _v.threads.emplace(titr->tid);
+            }
+        }
+    }
+
+    auto _locks     = std::set<uintptr_t>{};
+    auto _count     = size_t{ 0 };
+    auto _contended = size_t{ 0 };
+    auto _summaries = std::vector<site_summary>{};
+    _summaries.reserve(_merged.size());
+    for(const auto& itr : _merged)
+    {
+        const auto& _v = itr.second.data;
+        auto        _s = site_summary{};
+        _s.type        = get_kind_name(_v.kind);
+        _s.lock        = TIMEMORY_JOIN("", "0x", std::hex, itr.first.first);
+        _s.name        = get_symbol_name(itr.first.first, false);
+        // the return address is the instruction after the call
+        _s.call_site = get_symbol_name(itr.first.second - 1, true);
+        _s.count     = _v.count;
+        _s.contended = _v.contended;
+        _s.wait      = duration_summary{ _v.wait };
+        _s.hold      = duration_summary{ _v.hold };
+        _s.threads   = itr.second.threads;
+        _summaries.emplace_back(std::move(_s));
+
+        _locks.emplace(itr.first.first);
+        _count += _v.count;
+        _contended += _v.contended;
+    }
+
+    std::sort(_summaries.begin(), _summaries.end(),
+              [](const site_summary& _lhs, const site_summary& _rhs) {
+                  return (_lhs.wait.total > _rhs.wait.total);
+              });
+
+    OMNITRACE_VERBOSE(0,
+                      "[lock-contention] %zu contended lock acquisitions on %zu locks\n",
+                      _contended, _locks.size());
+    if(_summaries.empty()) return;
+
+    OMNITRACE_VERBOSE(1, "[lock-contention] %zu lock acquisitions at %zu call-sites\n",
+                      _count, _summaries.size());
+
+    constexpr size_t _max_report = 10;
+    for(size_t i = 0; i < std::min(_summaries.size(), _max_report); ++i)
+    {
+        const auto& _v = _summaries.at(i);
+        if(_v.contended == 0) break;
+        OMNITRACE_VERBOSE(
+            0,
+            "[lock-contention] #%zu :: %s %s waited %.3f msec in total (max = %.3f msec) "
+            "over %zu of %zu acquisitions on %zu threads :: %s %s\n",
+            i, _v.type.c_str(), _v.lock.c_str(), _v.wait.total * 1.0e-6,
+            _v.wait.max * 1.0e-6, _v.contended, _v.count, _v.threads.size(),
+            _v.name.c_str(), _v.call_site.c_str());
+    }
+
+    auto _get_setting = [](const std::string& _v) {
+        auto&& _b = config::get_setting_value<bool>(_v);
+        return (_b.first) ? _b.second : true;
+    };
+
+    if(_get_setting("OMNITRACE_TEXT_OUTPUT"))
+    {
+        std::stringstream _oss{};
+        _oss << "# pthread lock acquisitions by lock and call-site. durations are in nsec"
+             << (contention_only() ? " and only contended acquisitions were recorded\n"
+                                   : "\n");
+        _oss << "#" << std::setw(13) << "type" << std::setw(20) << "lock" << std::setw(12)
+             << "count" << std::setw(12) << "contended" << std::setw(16) << "wait total"
+             << std::setw(12) << "wait max" << std::setw(12) << "wait p50"
+             << std::setw(12) << "wait p99" << std::setw(16) << "hold total"
+             << std::setw(12) << "hold max" << std::setw(12) << "hold p50"
+             << std::setw(12) << "hold p99" << std::setw(10) << "threads"
+             << "  lock name @ call-site\n";
+        for(const auto& itr : _summaries)
+        {
+            _oss << std::setw(14) << itr.type << std::setw(20) << itr.lock
+                 << std::setw(12) << itr.count << std::setw(12) << itr.contended
+                 << std::setw(16) << itr.wait.total << std::setw(12) << itr.wait.max
+                 << std::setw(12) << itr.wait.p50 << std::setw(12) << itr.wait.p99
+                 << std::setw(16) << itr.hold.total << std::setw(12) << itr.hold.max
+                 << std::setw(12) << itr.hold.p50 << std::setw(12) << itr.hold.p99
+                 << std::setw(10) << itr.threads.size() << "  " << itr.name << " @ "
+                 << itr.call_site << "\n";
+        }
+
+        auto _fname = tim::settings::compose_output_filename("lock-contention", ".txt");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            OMNITRACE_VERBOSE(0, "[lock-contention] Outputting '%s'...\n",
+                              _fname.c_str());
+            ofs << _oss.str();
+        }
+        else
+        {
+            OMNITRACE_PRINT("[lock-contention] Error opening '%s'\n", _fname.c_str());
+        }
+    }
+
+    if(_get_setting("OMNITRACE_JSON_OUTPUT"))
+    {
+        std::stringstream _oss{};
+        {
+            namespace cereal = tim::cereal;
+            auto ar =
+                tim::policy::output_archive<cereal::PrettyJSONOutputArchive>::get(_oss);
+
+            ar->setNextName("omnitrace");
+            ar->startNode();
+            ar->setNextName("lock_contention");
+            ar->startNode();
+            (*ar)(cereal::make_nvp("contention_only", contention_only()));
+            (*ar)(cereal::make_nvp("acquisitions", _count));
+            (*ar)(cereal::make_nvp("contended", _contended));
+            (*ar)(cereal::make_nvp("locks", _locks.size()));
+            (*ar)(cereal::make_nvp("call_sites", _summaries));
+            ar->finishNode();
+            ar->finishNode();
+        }
+
+        auto _fname = tim::settings::compose_output_filename("lock-contention", ".json");
+        std::ofstream ofs{};
+        if(tim::filepath::open(ofs, _fname))
+        {
+            OMNITRACE_VERBOSE(0, "[lock-contention] Outputting '%s'...\n",
+                              _fname.c_str());
+            ofs << _oss.str() << "\n";
+        }
+        else
+        {
+            OMNITRACE_PRINT("[lock-contention] Error opening '%s'\n", _fname.c_str());
+        }
+    }
+}
+}  // namespace lock_contention
+}  // namespace omnitrace
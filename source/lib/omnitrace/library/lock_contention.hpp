@@ -0,0 +1,73 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "library/defines.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+// aggregated profile of the traced pthread locks keyed by the lock address and the
+// call-site which acquired the lock. The profile is collected when either
+// OMNITRACE_TRACE_THREAD_LOCK_PROFILE or OMNITRACE_TRACE_THREAD_LOCK_CONTENTION is
+// enabled. In the latter mode, the lock wrappers only record the acquisitions where a
+// non-blocking attempt to acquire the lock failed and the hold times are not available
+// because the unlock functions are not wrapped
+namespace lock_contention
+{
+enum class lock_kind : uint8_t
+{
+    mutex = 0,
+    rwlock_read,
+    rwlock_write,
+    spinlock,
+    barrier,
+};
+
+// returns true if the lock profile is collected
+bool
+enabled();
+
+// returns true if only the contended lock acquisitions are recorded
+bool
+contention_only();
+
+// records an acquisition of the lock at the given address which waited for the given
+// number of nanoseconds. When the acquisition is contended, a non-blocking attempt
+// to acquire the lock failed
+void
+acquire(uintptr_t _lock, lock_kind _kind, uint64_t _wait, bool _contended);
+
+// records the release of a lock acquired on this thread
+void
+release(uintptr_t _lock);
+
+// reports the most contended locks and writes the profile of all the locks to the
+// output folder
+void
+post_process();
+}  // namespace lock_contention
+}  // namespace omnitrace
@@ -0,0 +1,321 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/overhead.hpp"
+#include "library/config.hpp"
+#include "library/critical_trace.hpp"
+#include "library/debug.hpp"
+#include "library/event_buffer.hpp"
+#include "library/runtime.hpp"
+#include "library/string_table.hpp"
+#include "library/timemory.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/components/timing/backends.hpp>
+#include <timemory/manager.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace omnitrace
+{
+namespace overhead
+{
+namespace
+{
+struct overhead_registry
+{
+    std::mutex                    mutex = {};
+    std::vector<thread_overhead*> data  = {};
+};
+
+auto&
+get_registry()
+{
+    // intentional leak: the data of threads which have exited is reported at finalization
+    static auto* _v = new overhead_registry{};
+    return *_v;
+}
+
+// cost of a push/pop pair measured at startup [nsec]
+auto&
+get_calibration()
+{
+    static auto _v = std::atomic<uint64_t>{ 0 };
+    return _v;
+}
+
+uint64_t
+get_mean(const sample_data& _v)
+{
+    return (_v.count > 0) ? (_v.total / _v.count) : 0;
+}
+
+// the measurements during the run replace the startup calibration once there are
+// enough of them
+uint64_t
+get_pair_cost(const thread_overhead& _data)
+{
+    constexpr uint64_t min_samples = 10;
+    if(_data.entry.count >= min_samples && _data.exit.count >= min_samples)
+        return get_mean(_data.entry) + get_mean(_data.exit);
+    return get_calibration().load(std::memory_order_relaxed);
+}
+}  // namespace
+
+bool
+enabled()
+{
+    return (get_use_timemory() && get_overhead_compensation());
+}
+
+void
+calibrate(const perfetto::TraceConfig& _main_cfg)
+{
+    constexpr size_t nbatch = 10;
+    constexpr size_t niter  = 100;
+
+    using Device  = critical_trace::Device;
+    using Phase   = critical_trace::Phase;
+    using quirk_t = quirk::config<quirk::explicit_push, quirk::explicit_pop>;
+
+    // a pair follows the same path as an instrumented function (see category_region)
+    // through each of the backends which are used and none of the data recorded by the
+    // calibration is part of the output. The bundles are never inserted into the
+    // call-graph, the event buffer records and the critical-trace entries are discarded,
+    // and the track events are recorded into a separate session which is never read.
+    // The latter requires the in-process backend so the cost of the track events is not
+    // included when a system backend is used
+    auto _use_event_buffer   = (get_use_perfetto() && get_perfetto_event_buffer());
+    auto _use_perfetto       = (get_use_perfetto() && !_use_event_buffer &&
+                                get_backend() == "inprocess");
+    auto _use_critical_trace = get_use_critical_trace();
+
+    constexpr auto _name = "omnitrace_overhead_calibration";
+
+    auto _bundles = instrumentation_bundles{};
+    auto _hash    = string_table::get_id(_name);
+    auto _tid     = threading::get_id();
+    auto _cost    = std::numeric_limits<uint64_t>::max();
+    auto _cids    = std::vector<uint64_t>{};
+    if(_use_critical_trace) _cids.reserve((nbatch + 1) * niter);
+
+    auto _session = std::unique_ptr<perfetto::TracingSession>{};
+    if(_use_perfetto)
+    {
+        auto _cfg = _main_cfg;
+        _cfg.clear_buffers();
+        _cfg.set_write_into_file(false);
+        auto* _buffer_cfg = _cfg.add_buffers();
+        _buffer_cfg->set_size_kb(1024);
+        _buffer_cfg->set_fill_policy(
+            perfetto::protos::gen::TraceConfig_BufferConfig_FillPolicy_RING_BUFFER);
+
+        _session = perfetto::Tracing::NewTrace(perfetto::kInProcessBackend);
+        _session->Setup(_cfg);
+        _session->StartBlocking();
+    }
+
+    auto _pair = [&]() {
+        {
+            auto _gate = region_gate::load();
+            (void) _gate;
+            auto _internal = region_gate::scoped_internal{};
+            if(_use_event_buffer)
+                event_buffer::begin(_hash);
+            else if(_use_perfetto)
+                tracing::push_perfetto(category::host{}, _name);
+            _bundles.emplace(_hash, quirk_t{})->start();
+            if(_use_critical_trace)
+            {
+                uint64_t _cid                       = 0;
+                uint64_t _parent_cid                = 0;
+                uint32_t _depth                     = 0;
+                std::tie(_cid, _parent_cid, _depth) = create_cpu_cid_entry();
+                add_critical_trace<Device::CPU, Phase::BEGIN>(
+                    _tid, _cid, 0, _parent_cid, tracing::now(), 0, 0, 0, _hash, _depth);
+                _cids.emplace_back(_cid);
+            }
+        }
+        {
+            auto _gate = region_gate::load();
+            (void) _gate;
+            auto   _internal = region_gate::scoped_internal{};
+            auto** _slot     = _bundles.find(_hash);
+            (*_slot)->stop();
+            _bundles.release(_slot);
+            if(_use_event_buffer)
+                event_buffer::end();
+            else if(_use_perfetto)
+                tracing::pop_perfetto(category::host{}, _name);
+            if(_use_critical_trace)
+            {
+                auto _cid = get_cpu_cid_stack()->back();
+                auto _itr = get_cpu_cid_parents()->find(_cid);
+                if(_itr != get_cpu_cid_parents()->end())
+                {
+                    uint64_t _parent_cid          = 0;
+                    uint32_t _depth               = 0;
+                    auto     _ts                  = tracing::now();
+                    std::tie(_parent_cid, _depth) = _itr->second;
+                    // the call-stack is popped below instead of here so that the
+                    // calibration never flushes entries to the critical trace
+                    add_critical_trace<Device::CPU, Phase::END, false>(
+                        _tid, _cid, 0, _parent_cid, _ts, _ts, 0, 0, _hash, _depth);
+                }
+                tim::auto_lock_t _lk{ get_cpu_cid_stack_lock(_tid) };
+                get_cpu_cid_stack(_tid)->pop_back();
+            }
+        }
+    };
+
+    // the first batch warms up the caches and the allocator. The minimum of the
+    // remaining batches is the least affected by interrupts and preemption
+    for(size_t i = 0; i < nbatch + 1; ++i)
+    {
+        auto _beg = timestamp::now();
+        for(size_t j = 0; j < niter; ++j)
+            _pair();
+        auto _end = timestamp::now();
+        if(i > 0) _cost = std::min<uint64_t>(_cost, (_end - _beg) / niter);
+    }
+
+    if(_session)
+    {
+        _session->StopBlocking();
+        _session.reset();
+    }
+
+    if(_use_event_buffer) event_buffer::clear();
+
+    // discard the critical-trace entries of the calibration. No other thread records
+    // regions before the tooling is active
+    if(_use_critical_trace)
+    {
+        auto& _chain = critical_trace::get(_tid);
+        _chain->erase(std::remove_if(_chain->begin(), _chain->end(),
+                                     [_hash](const critical_trace::entry& _v) {
+                                         return _v.hash == _hash;
+                                     }),
+                      _chain->end());
+        for(auto itr : _cids)
+            get_cpu_cid_parents(_tid)->erase(itr);
+    }
+
+    get_calibration().store(_cost);
+    OMNITRACE_VERBOSE(1, "[overhead] calibrated cost of a push/pop pair: %lu nsec\n",
+                      static_cast<unsigned long>(_cost));
+}
+
+thread_overhead*
+get_thread_overhead()
+{
+    auto* _data     = new thread_overhead{};
+    _data->interval = get_overhead_sample_interval();
+
+    auto& _reg = get_registry();
+    auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+    _reg.data.emplace_back(_data);
+    return _data;
+}
+
+void
+compensate(instrumentation_bundle_t& _bundle, uint64_t _nested)
+{
+    static auto _enabled = enabled();
+    if(!_enabled || _nested == 0) return;
+
+    auto* _wc = _bundle.get<comp::wall_clock>();
+    if(!_wc || !_wc->get_is_running()) return;
+
+    static thread_local auto* _data = get_thread_overhead();
+    auto _cost = static_cast<int64_t>(_nested * get_pair_cost(*_data));
+    if(_cost <= 0) return;
+
+    // the value of a running wall-clock is the time it was started so moving the
+    // start forward reduces the elapsed time computed when it is stopped. The
+    // correction is never larger than the time which has elapsed
+    auto _start   = _wc->get_value();
+    auto _elapsed = tim::get_clock_real_now<int64_t, std::nano>() - _start;
+    _cost         = std::min<int64_t>(_cost, std::max<int64_t>(_elapsed, 0));
+    _wc->set_value(_start + _cost);
+
+    _data->regions += 1;
+    _data->corrected += _cost;
+}
+
+void
+post_process()
+{
+    auto _total   = thread_overhead{};
+    auto _threads = size_t{ 0 };
+    {
+        auto& _reg = get_registry();
+        auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+        for(const auto* itr : _reg.data)
+        {
+            _total.entry.count += itr->entry.count;
+            _total.entry.total += itr->entry.total;
+            _total.exit.count += itr->exit.count;
+            _total.exit.total += itr->exit.total;
+            _total.regions += itr->regions;
+            _total.corrected += itr->corrected;
+            _threads += 1;
+        }
+    }
+
+    auto _calibrated = get_calibration().load();
+    auto _entry_cost = get_mean(_total.entry);
+    auto _exit_cost  = get_mean(_total.exit);
+
+    OMNITRACE_VERBOSE(0,
+                      "[overhead] subtracted %.3f msec of instrumentation overhead from "
+                      "%lu regions on %zu threads\n",
+                      static_cast<double>(_total.corrected) / units::msec,
+                      static_cast<unsigned long>(_total.regions), _threads);
+    OMNITRACE_VERBOSE(1,
+                      "[overhead] cost of a push/pop pair: %lu nsec (calibrated), %lu + "
+                      "%lu nsec (mean of %lu entries + %lu exits measured)\n",
+                      static_cast<unsigned long>(_calibrated),
+                      static_cast<unsigned long>(_entry_cost),
+                      static_cast<unsigned long>(_exit_cost),
+                      static_cast<unsigned long>(_total.entry.count),
+                      static_cast<unsigned long>(_total.exit.count));
+
+    tim::manager::instance()->add_metadata([=](auto& ar) {
+        ar(tim::cereal::make_nvp("overhead_calibrated_pair_cost_ns", _calibrated),
+           tim::cereal::make_nvp("overhead_measured_entry_cost_ns", _entry_cost),
+           tim::cereal::make_nvp("overhead_measured_exit_cost_ns", _exit_cost),
+           tim::cereal::make_nvp("overhead_measured_entries", _total.entry.count),
+           tim::cereal::make_nvp("overhead_measured_exits", _total.exit.count),
+           tim::cereal::make_nvp("overhead_corrected_regions", _total.regions),
+           tim::cereal::make_nvp("overhead_corrected_ns", _total.corrected));
+    });
+}
+}  // namespace overhead
+}  // namespace omnitrace
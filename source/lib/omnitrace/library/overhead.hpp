@@ -0,0 +1,120 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "library/defines.hpp"
+#include "library/perfetto.hpp"
+#include "library/region_gate.hpp"
+#include "library/thread_data.hpp"
+#include "library/timestamp.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+// compensation of the cost of the instrumentation in the timemory wall-clock times.
+// The inclusive time of a region contains the cost of pushing and popping every region
+// nested within it so, when a region is popped, the number of regions nested within it
+// multiplied by the cost of a push/pop pair is subtracted from its elapsed time. The
+// cost of a pair is calibrated at startup and, optionally, re-measured during the run
+// by timing a sample of the region entries and exits on each thread
+namespace overhead
+{
+struct sample_data
+{
+    uint64_t calls = 0;  // entries or exits since the last measurement
+    uint64_t count = 0;  // number of measurements
+    uint64_t total = 0;  // sum of the measurements [nsec]
+};
+
+struct thread_overhead
+{
+    size_t      interval  = 0;   // measure one in every N entries and N exits
+    sample_data entry     = {};  // cost of region entries
+    sample_data exit      = {};  // cost of region exits
+    uint64_t    regions   = 0;   // number of regions whose time was corrected
+    uint64_t    corrected = 0;   // total time subtracted [nsec]
+};
+
+// returns true if the overhead compensation is enabled
+bool
+enabled();
+
+// measures the cost of a push/pop pair on the calling thread. Must be called before
+// the perfetto session is started. The configuration of the session is used for the
+// (discarded) track events of the calibration
+void
+calibrate(const perfetto::TraceConfig&);
+
+// returns the data of the calling thread, creating and registering it if necessary
+thread_overhead*
+get_thread_overhead();
+
+// subtracts the cost of the given number of nested regions from the elapsed
+// wall-clock time of the (running) bundle
+void
+compensate(instrumentation_bundle_t&, uint64_t _nested);
+
+// reports the correction applied and adds it to the metadata
+void
+post_process();
+
+// times the enclosing scope if the entry/exit is part of the sample
+struct scoped_sample
+{
+    scoped_sample(region_gate::mask_t _gate, sample_data thread_overhead::*_field)
+    {
+        if(!(_gate & region_gate::Overhead)) return;
+
+        // the entries and exits are counted separately so that both are sampled
+        // regardless of the interval
+        static thread_local auto* _data = get_thread_overhead();
+        auto&                     _v    = _data->*_field;
+        if(_data->interval == 0 || ++_v.calls < _data->interval) return;
+
+        _v.calls = 0;
+        m_data   = &_v;
+        m_start  = timestamp::now();
+    }
+
+    ~scoped_sample()
+    {
+        if(!m_data) return;
+        m_data->total += (timestamp::now() - m_start);
+        m_data->count += 1;
+    }
+
+    scoped_sample(const scoped_sample&) = delete;
+    scoped_sample(scoped_sample&&)      = delete;
+
+    scoped_sample& operator=(const scoped_sample&) = delete;
+    scoped_sample& operator=(scoped_sample&&) = delete;
+
+private:
+    sample_data* m_data  = nullptr;
+    uint64_t     m_start = 0;
+};
+}  // namespace overhead
+}  // namespace omnitrace
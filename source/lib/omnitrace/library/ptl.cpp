@@ -85,14 +85,6 @@ get_thread_pool_state()
     static auto _v = State::PreInit;
     return _v;
 }
-
-PTL::ThreadPool&
-get_thread_pool()
-{
-    static auto _v =
-        (get_thread_pool_state() = State::Active, PTL::ThreadPool{ _thread_pool_cfg() });
-    return _v;
-}
 }  // namespace
 
 namespace roctracer
@@ -105,6 +97,17 @@ get_thread_pool_state()
     static auto _v = State::PreInit;
     return _v;
 }
+
+auto&
+get_task_groups()
+{
+    struct local
+    {};
+    using thread_data_t = thread_data<PTL::TaskGroup<void>, local>;
+    static auto& _v =
+        thread_data_t::instances(construct_on_init{}, &tasking::get_thread_pool());
+    return _v;
+}
 }  // namespace
 }  // namespace roctracer
 
@@ -118,6 +121,17 @@ get_thread_pool_state()
     static auto _v = State::PreInit;
     return _v;
 }
+
+auto&
+get_task_groups()
+{
+    struct local
+    {};
+    using thread_data_t = thread_data<PTL::TaskGroup<void>, local>;
+    static auto& _v =
+        thread_data_t::instances(construct_on_init{}, &tasking::get_thread_pool());
+    return _v;
+}
 }  // namespace
 }  // namespace critical_trace
 
@@ -131,15 +145,15 @@ join()
     if(roctracer::get_thread_pool_state() == State::Active)
     {
         OMNITRACE_DEBUG_F("waiting for all roctracer tasks to complete...\n");
-        for(size_t i = 0; i < max_supported_threads; ++i)
-            roctracer::get_task_group(i).join();
+        for(auto& itr : roctracer::get_task_groups())
+            itr->join();
     }
 
     if(critical_trace::get_thread_pool_state() == State::Active)
     {
         OMNITRACE_DEBUG_F("waiting for all critical tasks to complete...\n");
-        for(size_t i = 0; i < max_supported_threads; ++i)
-            critical_trace::get_task_group(i).join();
+        for(auto& itr : critical_trace::get_task_groups())
+            itr->join();
     }
 }
 
@@ -149,11 +163,11 @@ shutdown()
     if(roctracer::get_thread_pool_state() == State::Active)
     {
         OMNITRACE_DEBUG_F("Waiting on completion of roctracer tasks...\n");
-        for(size_t i = 0; i < max_supported_threads; ++i)
+        for(auto& itr : roctracer::get_task_groups())
         {
-            roctracer::get_task_group(i).join();
-            roctracer::get_task_group(i).clear();
-            roctracer::get_task_group(i).set_pool(nullptr);
+            itr->join();
+            itr->clear();
+            itr->set_pool(nullptr);
         }
         roctracer::get_thread_pool_state() = State::Finalized;
     }
@@ -161,11 +175,11 @@ shutdown()
     if(critical_trace::get_thread_pool_state() == State::Active)
     {
         OMNITRACE_DEBUG_F("Waiting on completion of critical trace tasks...\n");
-        for(size_t i = 0; i < max_supported_threads; ++i)
+        for(auto& itr : critical_trace::get_task_groups())
         {
-            critical_trace::get_task_group(i).join();
-            critical_trace::get_task_group(i).clear();
-            critical_trace::get_task_group(i).set_pool(nullptr);
+            itr->join();
+            itr->clear();
+            itr->set_pool(nullptr);
         }
         critical_trace::get_thread_pool_state() = State::Finalized;
     }
@@ -178,6 +192,14 @@ shutdown()
     }
 }
 
+PTL::ThreadPool&
+get_thread_pool()
+{
+    static auto _v =
+        (get_thread_pool_state() = State::Active, PTL::ThreadPool{ _thread_pool_cfg() });
+    return _v;
+}
+
 size_t
 initialize_threadpool(size_t _v)
 {
@@ -187,23 +209,13 @@ initialize_threadpool(size_t _v)
 PTL::TaskGroup<void>&
 roctracer::get_task_group(int64_t _tid)
 {
-    struct local
-    {};
-    using thread_data_t = thread_data<PTL::TaskGroup<void>, local>;
-    static auto& _v =
-        thread_data_t::instances(construct_on_init{}, &tasking::get_thread_pool());
-    return *_v.at(_tid);
+    return *roctracer::get_task_groups().at(_tid);
 }
 
 PTL::TaskGroup<void>&
 critical_trace::get_task_group(int64_t _tid)
 {
-    struct local
-    {};
-    using thread_data_t = thread_data<PTL::TaskGroup<void>, local>;
-    static auto& _v =
-        thread_data_t::instances(construct_on_init{}, &tasking::get_thread_pool());
-    return *_v.at(_tid);
+    return *critical_trace::get_task_groups().at(_tid);
 }
 }  // namespace tasking
 }  // namespace omnitrace
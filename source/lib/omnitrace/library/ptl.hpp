@@ -44,6 +44,9 @@ shutdown();
 
 size_t initialize_threadpool(size_t);
 
+PTL::ThreadPool&
+get_thread_pool();
+
 //--------------------------------------------------------------------------------------//
 //
 //      roctracer
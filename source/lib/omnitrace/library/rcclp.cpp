@@ -67,7 +67,9 @@ setup()
     auto _use_data = tim::get_env("OMNITRACE_RCCLP_COMM_DATA", get_use_timemory());
     if(!get_use_timemory())
     {
-        trait::runtime_enabled<component::comm_data>::set(false);
+        // the MPI communication matrix is collected by comm_data without timemory
+        trait::runtime_enabled<component::comm_data>::set(get_use_mpip() &&
+                                                          get_mpip_comm_matrix());
         trait::runtime_enabled<component::comm_data_tracker_t>::set(false);
     }
     else
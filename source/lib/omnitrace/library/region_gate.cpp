@@ -0,0 +1,163 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/region_gate.hpp"
+#include "api.hpp"
+#include "library/config.hpp"
+#include "library/flight_recorder.hpp"
+#include "library/overhead.hpp"
+#include "library/runtime.hpp"
+#include "library/throttle.hpp"
+#include "library/tracing.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+
+namespace omnitrace
+{
+namespace region_gate
+{
+namespace
+{
+// the thread-local masks of every live thread so that they can be invalidated
+struct registry
+{
+    std::mutex                               mutex = {};
+    std::atomic<uint64_t>                    epoch = { 0 };
+    std::unordered_set<std::atomic<mask_t>*> masks = {};
+};
+
+auto&
+get_registry()
+{
+    // intentional leak: regions may be pushed/popped during static destruction
+    static auto* _v = new registry{};
+    return *_v;
+}
+
+bool&
+thread_initialized()
+{
+    static thread_local bool _v = false;
+    return _v;
+}
+
+struct thread_registration
+{
+    thread_registration()
+    {
+        auto& _reg = get_registry();
+        auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+        _reg.masks.emplace(&get_thread_mask());
+    }
+
+    ~thread_registration()
+    {
+        auto& _reg = get_registry();
+        auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+        _reg.masks.erase(&get_thread_mask());
+    }
+};
+
+mask_t
+compute()
+{
+    auto _state = get_state();
+    if(get_thread_state() == ThreadState::Disabled || _state >= State::Finalized)
+        return Skip;
+
+    if(_state != State::Active) return 0;
+
+    mask_t _v = Stop;
+    if(thread_initialized()) _v |= Start;
+    if(get_use_perfetto()) _v |= Perfetto;
+    if(get_use_perfetto() && get_perfetto_event_buffer()) _v |= EventBuffer;
+    if(get_use_timemory()) _v |= Timemory;
+    if(get_use_critical_trace()) _v |= CriticalTrace;
+    if(throttle::enabled()) _v |= Throttle;
+    if(overhead::enabled()) _v |= Overhead;
+    if(flight_recorder::has_triggers()) _v |= FlightRecorder;
+    return _v;
+}
+}  // namespace
+
+mask_t
+update()
+{
+    static thread_local auto _registration = thread_registration{};
+    (void) _registration;
+
+    auto& _reg   = get_registry();
+    auto  _epoch = _reg.epoch.load();
+    auto  _v     = compute();
+    get_thread_mask().store(_v);
+    // an invalidation which raced with the computation above may have been overwritten
+    // so leave the mask stale for the next call. The value computed here is still used
+    // for this call since it is no older than a check of the individual values would be
+    if(_reg.epoch.load() != _epoch) get_thread_mask().store(Stale);
+    return _v;
+}
+
+void
+invalidate()
+{
+    auto& _reg = get_registry();
+    auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+    ++_reg.epoch;
+    for(auto* itr : _reg.masks)
+        itr->store(Stale);
+}
+
+void
+set_thread_initialized()
+{
+    thread_initialized() = true;
+    invalidate_thread();
+}
+
+mask_t
+initialize_thread()
+{
+    // unconditionally return if thread is disabled or finalized
+    if(get_thread_state() == ThreadState::Disabled) return Skip;
+    if(get_state() >= State::Finalized) return Skip;
+
+    OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal);
+
+    // the expectation here is that if the state is not active then the call
+    // to omnitrace_init_tooling_hidden will activate all the appropriate
+    // tooling one time and as it exits set it to active and return true.
+    if(get_state() != State::Active && !omnitrace_init_tooling_hidden()) return get();
+
+    tracing::thread_init();
+
+    // thread initialization may have disabled the thread
+    if(get_thread_state() == ThreadState::Disabled) return Skip;
+
+    tracing::thread_init_sampling();
+
+    set_thread_initialized();
+    return get();
+}
+}  // namespace region_gate
+}  // namespace omnitrace
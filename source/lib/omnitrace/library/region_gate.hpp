@@ -0,0 +1,134 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "library/defines.hpp"
+#include "library/runtime.hpp"
+#include "library/state.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace omnitrace
+{
+// caches every runtime decision made at the top of a region start/stop (the global
+// state, the state of the thread, whether the thread has been initialized, which
+// backends are in use and whether throttling is configured) in a single thread-local
+// bitmask. The mask is only recomputed after it has been marked stale, i.e. when the
+// global state, the configuration, or whether the thread is disabled changes, so the
+// common paths are one load + branch
+namespace region_gate
+{
+using mask_t = uint32_t;
+
+enum : mask_t
+{
+    Stale          = (1 << 0),   // must be recomputed before use
+    Skip           = (1 << 1),   // thread is disabled or omnitrace is finalized
+    Start          = (1 << 2),   // active and this thread has been initialized
+    Stop           = (1 << 3),   // active
+    Perfetto       = (1 << 4),   // perfetto backend is used
+    Timemory       = (1 << 5),   // timemory backend is used
+    CriticalTrace  = (1 << 6),   // critical trace is used
+    Throttle       = (1 << 7),   // instrumentation throttling is configured
+    EventBuffer    = (1 << 8),   // perfetto events are recorded into event buffers
+    Overhead       = (1 << 9),   // instrumentation overhead is compensated
+    FlightRecorder = (1 << 10),  // region entries may request a perfetto snapshot
+};
+
+// constant-initialized so that accessing it does not require a guard
+inline std::atomic<mask_t>&
+get_thread_mask()
+{
+    static thread_local std::atomic<mask_t> _v{ Stale };
+    return _v;
+}
+
+// recomputes the mask of the calling thread
+mask_t
+update();
+
+// current mask of the calling thread without resolving staleness
+inline mask_t
+load()
+{
+    return get_thread_mask().load(std::memory_order_relaxed);
+}
+
+// current mask of the calling thread
+inline mask_t
+get()
+{
+    auto _v = load();
+    return (_v & Stale) ? update() : _v;
+}
+
+// marks the mask of the calling thread as stale
+inline void
+invalidate_thread()
+{
+    get_thread_mask().store(Stale);
+}
+
+// marks the mask of every thread as stale
+void
+invalidate();
+
+// records that the calling thread has been fully initialized for tracing
+void
+set_thread_initialized();
+
+// slow path of a region start: activates the tooling if necessary and performs the
+// one-time initialization of the calling thread. Returns the updated mask
+mask_t
+initialize_thread();
+
+// lightweight alternative to OMNITRACE_SCOPED_THREAD_STATE(ThreadState::Internal) for
+// the fast path: the gate already guarantees the thread is not disabled and swapping
+// between enabled and internal never changes the gate so no history is required
+struct scoped_internal
+{
+    scoped_internal()
+    : m_state{ get_thread_state() }
+    , m_prev{ m_state }
+    {
+        m_state = ThreadState::Internal;
+    }
+
+    ~scoped_internal()
+    {
+        if(m_state < ThreadState::Completed) m_state = m_prev;
+    }
+
+    scoped_internal(const scoped_internal&) = delete;
+    scoped_internal(scoped_internal&&)      = delete;
+
+    scoped_internal& operator=(const scoped_internal&) = delete;
+    scoped_internal& operator=(scoped_internal&&) = delete;
+
+private:
+    ThreadState& m_state;
+    ThreadState  m_prev;
+};
+}  // namespace region_gate
+}  // namespace omnitrace
@@ -0,0 +1,111 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/region_table.hpp"
+#include "library/debug.hpp"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace omnitrace
+{
+namespace region_table
+{
+namespace
+{
+constexpr size_t chunk_size = 4096;
+constexpr size_t max_chunks = 4096;
+
+// regions are stored in fixed-size chunks which are never moved or freed so readers
+// only need an acquire load of the count and of the chunk pointer. The name map is
+// keyed by the interned string table pointer and is only accessed during registration
+struct table
+{
+    using chunk_array_t = std::array<std::atomic<region_info*>, max_chunks>;
+
+    std::mutex                               mutex  = {};
+    std::atomic<size_t>                      count  = { 0 };
+    std::unordered_map<const char*, id_type> ids    = {};
+    chunk_array_t                            chunks = {};
+};
+
+auto&
+get_table()
+{
+    // intentional leak: regions may be pushed/popped during static destruction
+    static auto* _v = new table{};
+    return *_v;
+}
+}  // namespace
+
+id_type
+register_region(std::string_view _name)
+{
+    auto& _table = get_table();
+    // the string table pointer is unique for each distinct string
+    const auto* _str = string_table::get(_name);
+
+    std::unique_lock<std::mutex> _lk{ _table.mutex };
+    auto                         itr = _table.ids.find(_str);
+    if(itr != _table.ids.end()) return itr->second;
+
+    id_type _id    = _table.count.load(std::memory_order_relaxed) + 1;
+    size_t  _chunk = _id / chunk_size;
+    if(_chunk >= max_chunks)
+    {
+        OMNITRACE_VERBOSE_F(0, "region table is full. Region '%s' was not registered\n",
+                            _str);
+        return 0;
+    }
+
+    auto* _data = _table.chunks[_chunk].load(std::memory_order_relaxed);
+    if(!_data)
+    {
+        _data = new region_info[chunk_size];
+        _table.chunks[_chunk].store(_data, std::memory_order_release);
+    }
+
+    _data[_id % chunk_size] = region_info{ string_table::get_id(_name), _str };
+    _table.ids.emplace(_str, _id);
+    // publishing the count makes the new entry visible to find
+    _table.count.store(_id, std::memory_order_release);
+    return _id;
+}
+
+const region_info*
+find(id_type _id)
+{
+    auto& _table = get_table();
+    if(_id == 0 || _id > _table.count.load(std::memory_order_acquire)) return nullptr;
+    const auto* _data = _table.chunks[_id / chunk_size].load(std::memory_order_acquire);
+    return (_data) ? &_data[_id % chunk_size] : nullptr;
+}
+
+size_t
+size()
+{
+    return get_table().count.load(std::memory_order_acquire);
+}
+}  // namespace region_table
+}  // namespace omnitrace
@@ -0,0 +1,59 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "library/defines.hpp"
+#include "library/string_table.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace omnitrace
+{
+// a process-wide table which maps region names to small, dense integer identifiers.
+// A region is registered once and subsequently started/stopped by its identifier so
+// that the name does not have to be hashed on every call. Identifiers start at one;
+// zero is never a valid region. Lookups are lock-free.
+namespace region_table
+{
+using id_type = size_t;
+
+struct region_info
+{
+    string_table::id_type hash = 0;        // string table (timemory hash) identifier
+    const char*           name = nullptr;  // stable, null-terminated region name
+};
+
+// returns the identifier of the region, registering it if necessary. Returns zero if
+// the table is full
+id_type register_region(std::string_view);
+
+// returns the region for the identifier or nullptr if the identifier is not registered
+const region_info* find(id_type);
+
+// number of registered regions
+size_t
+size();
+}  // namespace region_table
+}  // namespace omnitrace
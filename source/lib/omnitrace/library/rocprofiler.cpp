@@ -494,7 +494,7 @@ post_process_perfetto()
     auto _device_fields = std::map<uint32_t, std::vector<std::string_view>>{};
     auto _device_range  = std::map<uint32_t, std::set<rocm_metric_type>>{};
 
-    for(size_t i = 0; i < OMNITRACE_MAX_THREADS; ++i)
+    for(size_t i = 0; i < component::rocm_thread_data::size(); ++i)
     {
         auto& _v = component::rocm_data(i);
         if(_v)
@@ -603,7 +603,7 @@ post_process_timemory()
     auto _device_fields = std::map<uint32_t, std::vector<std::string_view>>{};
     auto _device_range  = std::map<uint32_t, std::set<rocm_metric_type>>{};
 
-    for(size_t i = 0; i < OMNITRACE_MAX_THREADS; ++i)
+    for(size_t i = 0; i < component::rocm_thread_data::size(); ++i)
     {
         auto& _v = component::rocm_data(i);
         if(_v)
@@ -93,11 +93,13 @@ get_roctracer_kernels()
     return _v;
 }
 
+using roctracer_hip_data_t =
+    thread_data<std::unordered_map<uint64_t, roctracer_bundle_t>, category::roctracer>;
+
 auto&
 get_roctracer_hip_data(int64_t _tid = threading::get_id())
 {
-    using data_t        = std::unordered_map<uint64_t, roctracer_bundle_t>;
-    using thread_data_t = thread_data<data_t, category::roctracer>;
+    using thread_data_t = roctracer_hip_data_t;
     static auto& _v     = thread_data_t::instances(thread_data_t::construct_on_init{});
     return _v.at(_tid);
 }
@@ -141,12 +143,14 @@ get_roctracer_cid_data(int64_t _tid = threading::get_id())
     return *_v.at(_tid);
 }
 
+using hip_activity_callbacks_t =
+    thread_data<std::vector<std::function<void()>>, category::roctracer>;
+
 auto&
 get_hip_activity_callbacks(int64_t _tid = threading::get_id())
 {
-    using thread_data_t =
-        thread_data<std::vector<std::function<void()>>, category::roctracer>;
-    static auto& _v = thread_data_t::instances(thread_data_t::construct_on_init{});
+    using thread_data_t = hip_activity_callbacks_t;
+    static auto& _v     = thread_data_t::instances(thread_data_t::construct_on_init{});
     return _v.at(_tid);
 }
 
@@ -411,6 +415,13 @@ hip_exec_activity_callbacks(int64_t _tid)
     _async_ops->clear();
 }
 
+void
+hip_exec_activity_callbacks()
+{
+    for(size_t i = 0; i < hip_activity_callbacks_t::size(); ++i)
+        hip_exec_activity_callbacks(i);
+}
+
 namespace
 {
 thread_local std::unordered_map<size_t, size_t> gpu_cids = {};
@@ -754,7 +765,7 @@ hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void*
             };
             if(!_stop(_tid))
             {
-                for(size_t i = 0; i < max_supported_threads; ++i)
+                for(size_t i = 0; i < roctracer_hip_data_t::size(); ++i)
                 {
                     if(_stop(i)) break;
                 }
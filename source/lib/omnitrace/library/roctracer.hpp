@@ -62,6 +62,10 @@ hsa_activity_callback(uint32_t op, activity_record_t* record, void* arg);
 void
 hip_exec_activity_callbacks(int64_t _tid);
 
+// executes the activity callbacks of every thread
+void
+hip_exec_activity_callbacks();
+
 // HIP API callback function
 void
 hip_api_callback(uint32_t domain, uint32_t cid, const void* callback_data, void* arg);
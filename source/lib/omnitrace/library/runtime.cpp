@@ -25,6 +25,8 @@
 #include "library/config.hpp"
 #include "library/debug.hpp"
 #include "library/defines.hpp"
+#include "library/region_gate.hpp"
+#include "library/thread_array.hpp"
 #include "library/thread_data.hpp"
 #include "library/utility.hpp"
 
@@ -54,12 +56,24 @@ namespace omnitrace
 {
 namespace
 {
+// per-thread stacks of previous values
+template <typename Tp>
+auto&
+get_history_instances()
+{
+    static auto _v    = thread_array<std::vector<Tp>>{};
+    static auto _once = []() {
+        _v.set_initializer([](std::vector<Tp>& _hist) { _hist.reserve(32); });
+        return true;
+    }();
+    (void) _once;
+    return _v;
+}
+
 auto&
 get_sampling_on_child_threads_history(int64_t _idx = utility::get_thread_index())
 {
-    static auto _v = utility::get_filled_array<OMNITRACE_MAX_THREADS>(
-        []() { return utility::get_reserved_vector<bool>(32); });
-    return _v.at(_idx);
+    return get_history_instances<bool>().at(_idx);
 }
 
 bool&
@@ -239,10 +253,7 @@ namespace
 auto&
 get_thread_state_history(int64_t _idx = utility::get_thread_index())
 {
-    static auto _v = utility::get_filled_array<OMNITRACE_MAX_THREADS>(
-        []() { return utility::get_reserved_vector<ThreadState>(32); });
-
-    return _v.at(_idx);
+    return get_history_instances<ThreadState>().at(_idx);
 }
 }  // namespace
 
@@ -258,6 +269,9 @@ set_thread_state(ThreadState _n)
 {
     auto _o            = get_thread_state();
     get_thread_state() = _n;
+    // the region gate only depends on whether or not the thread is disabled
+    if((_o == ThreadState::Disabled) != (_n == ThreadState::Disabled))
+        region_gate::invalidate_thread();
     return _o;
 }
 
@@ -315,7 +329,10 @@ pop_enable_sampling_on_child_threads()
 void
 set_sampling_on_all_future_threads(bool _v)
 {
-    for(size_t i = 0; i < max_supported_threads; ++i)
-        get_sampling_on_child_threads_history(i).emplace_back(_v);
+    // appended to the history of every thread, including the threads created later
+    get_history_instances<bool>().set_initializer([_v](std::vector<bool>& _hist) {
+        _hist.reserve(32);
+        _hist.emplace_back(_v);
+    });
 }
 }  // namespace omnitrace
@@ -30,6 +30,7 @@
 #include "library/debug.hpp"
 #include "library/ptl.hpp"
 #include "library/runtime.hpp"
+#include "library/string_table.hpp"
 #include "library/thread_data.hpp"
 #include "library/thread_info.hpp"
 #include "library/tracing.hpp"
@@ -58,6 +59,7 @@
 #include <timemory/utility/types.hpp>
 #include <timemory/variadic.hpp>
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <condition_variable>
@@ -68,7 +70,11 @@
 #include <regex>
 #include <sstream>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 #include <pthread.h>
 #include <signal.h>
@@ -162,6 +168,27 @@ get_sampler_running(int64_t _tid)
     return _v.at(_tid);
 }
 
+// the samples of a thread which exited while thread indices are recycled. These are
+// moved out of the per-thread slot so that the next thread which is assigned the same
+// index starts a new sampler
+struct retired_data
+{
+    using samples_t = std::decay_t<decltype(std::declval<sampler_t&>().get_data())>;
+
+    int64_t   tid     = -1;
+    int64_t   lookup  = -1;
+    bundle_t  init    = {};
+    samples_t samples = {};
+};
+
+auto&
+get_retired_data()
+{
+    // intentional leak: threads may exit while the process is exiting
+    static auto* _v = new std::pair<std::mutex, std::vector<retired_data>>{};
+    return *_v;
+}
+
 auto&
 get_duration_cv()
 {
@@ -359,7 +386,7 @@ configure(bool _setup, int64_t _tid = threading::get_id())
         {
             // this propagates to all threads
             _sampler->ignore(*_signal_types);
-            for(int64_t i = 1; i < OMNITRACE_MAX_THREADS; ++i)
+            for(size_t i = 1; i < sampler_instances::size(); ++i)
             {
                 if(sampling::get_sampler(i))
                 {
@@ -387,12 +414,24 @@ configure(bool _setup, int64_t _tid = threading::get_id())
     return (_signal_types) ? *_signal_types : std::set<int>{};
 }
 
+// the samples of a thread and the filtered + patched call-stack of each sample
+struct post_process_data
+{
+    using frames_t = std::vector<std::string>;
+
+    int64_t                tid    = -1;
+    int64_t                lookup = -1;
+    const bundle_t*        init   = nullptr;
+    std::vector<bundle_t*> data   = {};
+    std::vector<frames_t>  frames = {};
+};
+
 void
-post_process_perfetto(int64_t _tid, const bundle_t* _init,
-                      const std::vector<bundle_t*>& _data);
+post_process_frames(post_process_data& _data);
+std::thread
+post_process_perfetto(const post_process_data& _data);
 void
-post_process_timemory(int64_t _tid, const bundle_t* _init,
-                      const std::vector<bundle_t*>& _data);
+post_process_timemory(const std::vector<const post_process_data*>& _data);
 }  // namespace
 
 unique_ptr_t<std::set<int>>&
@@ -450,18 +489,105 @@ unblock_signals(std::set<int> _signals)
     thread_sigmask(SIG_UNBLOCK, &_v, nullptr);
 }
 
+void
+retire()
+{
+    auto  _tid     = threading::get_id();
+    auto& _sampler = get_sampler(_tid);
+
+    // the samplers of the main thread are never retired
+    if(_tid == 0 || !_sampler) return;
+
+    configure(false, _tid);
+    if(trait::runtime_enabled<backtrace_metrics>::get()) backtrace_metrics::retire(_tid);
+
+    OMNITRACE_DEBUG("Retiring sampler for thread %li...\n", _tid);
+
+    auto _data   = retired_data{};
+    _data.tid    = _tid;
+    _data.lookup = utility::get_thread_index();
+    _data.init   = std::move(*get_sampler_init(_tid));
+
+    _sampler->stop();
+    _data.samples = std::move(_sampler->get_data());
+
+    // destroy these on this thread: the per-thread data of the next thread which is
+    // assigned this index is generated when that thread starts
+    _sampler.reset();
+    get_sampler_init(_tid).reset();
+    get_signal_types(_tid).reset();
+
+    auto& _retired = get_retired_data();
+    auto  _lk      = std::unique_lock<std::mutex>{ _retired.first };
+    _retired.second.emplace_back(std::move(_data));
+}
+
 void
 post_process()
 {
     omnitrace::component::backtrace::stop();
     OMNITRACE_VERBOSE(2 || get_debug_sampling(), "Stopping backtrace metrics...\n");
 
-    for(size_t i = 0; i < max_supported_threads; ++i)
+    for(size_t i = 0; i < sampler_instances::size(); ++i)
         backtrace_metrics::configure(false, i);
 
     size_t _total_data    = 0;
     size_t _total_threads = 0;
-    for(size_t i = 0; i < max_supported_threads; ++i)
+    auto   _thread_data   = std::vector<post_process_data>{};
+
+    auto _add_thread_data = [&](int64_t _tid, int64_t _lookup, const bundle_t* _init,
+                                auto& _raw_data) {
+        const auto& _thread_info = thread_info::get(_lookup, LookupTID);
+
+        OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                          "Sampler data for thread %li has %zu initial entries...\n",
+                          _tid, _raw_data.size());
+
+        // single sample that is useless (backtrace to unblocking signals)
+        if(_raw_data.size() == 1 && _raw_data.front().size() <= 1) _raw_data.clear();
+
+        if(!_thread_info)
+        {
+            OMNITRACE_PRINT("Post-processing sampling entries for thread %li skipped "
+                            "(no thread info)\n",
+                            _tid);
+            return;
+        }
+
+        auto _pp_data   = post_process_data{};
+        _pp_data.tid    = _tid;
+        _pp_data.lookup = _lookup;
+        _pp_data.init   = _init;
+        for(auto& itr : _raw_data)
+        {
+            _pp_data.data.reserve(_pp_data.data.size() + itr.size());
+            auto* _bt = itr.template get<backtrace>();
+            auto* _ts = itr.template get<backtrace_timestamp>();
+            if(!_bt || !_ts) continue;
+            if(_bt->empty()) continue;
+            if(!_thread_info->is_valid_time(_ts->get_timestamp())) continue;
+            _pp_data.data.emplace_back(&itr);
+        }
+
+        if(_pp_data.data.empty())
+        {
+            OMNITRACE_VERBOSE(
+                3 || get_debug_sampling(),
+                "Sampler data for thread %li has %zu valid entries... (skipped)\n", _tid,
+                _raw_data.size());
+            return;
+        }
+
+        OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                          "Sampler data for thread %li has %zu valid entries...\n", _tid,
+                          _raw_data.size());
+
+        _total_data += _raw_data.size();
+        _total_threads += 1;
+        _thread_data.emplace_back(std::move(_pp_data));
+    };
+
+    for(size_t i = 0; i < sampler_instances::size(); ++i)
     {
         auto& _sampler = get_sampler(i);
 
@@ -486,7 +612,9 @@ post_process()
             continue;
         }
 
+        // the most recent thread which was assigned this index
         const auto& _thread_info = thread_info::get(i, InternalTID);
+        if(!_thread_info || !_thread_info->index_data) continue;
 
         OMNITRACE_VERBOSE(3 || get_debug_sampling(),
                           "Getting sampler data for thread %lu...\n", i);
@@ -494,52 +622,82 @@ post_process()
         _sampler->stop();
         auto& _raw_data = _sampler->get_data();
 
-        OMNITRACE_VERBOSE(2 || get_debug_sampling(),
-                          "Sampler data for thread %lu has %zu initial entries...\n", i,
-                          _raw_data.size());
-
         OMNITRACE_CI_THROW(
             _sampler->get_sample_count() != _raw_data.size(),
             "Error! sampler recorded %zu samples but %zu samples were returned\n",
             _sampler->get_sample_count(), _raw_data.size());
-        // single sample that is useless (backtrace to unblocking signals)
-        if(_raw_data.size() == 1 && _raw_data.front().size() <= 1) _raw_data.clear();
 
-        std::vector<sampling::bundle_t*> _data{};
-        for(auto& itr : _raw_data)
-        {
-            _data.reserve(_data.size() + itr.size());
-            auto* _bt = itr.get<backtrace>();
-            auto* _ts = itr.get<backtrace_timestamp>();
-            if(!_bt || !_ts) continue;
-            if(_bt->empty()) continue;
-            if(!_thread_info->is_valid_time(_ts->get_timestamp())) continue;
-            _data.emplace_back(&itr);
-        }
+        _add_thread_data(i, _thread_info->index_data->lookup_value, _init, _raw_data);
+    }
 
-        if(_data.empty())
-        {
-            OMNITRACE_VERBOSE(
-                3 || get_debug_sampling(),
-                "Sampler data for thread %lu has %zu valid entries... (skipped)\n", i,
-                _raw_data.size());
-            continue;
-        }
+    // the samples of the threads which exited while thread indices were recycled
+    auto _retired = std::vector<retired_data>{};
+    {
+        auto _lk = std::unique_lock<std::mutex>{ get_retired_data().first };
+        std::swap(_retired, get_retired_data().second);
+    }
+
+    for(auto& itr : _retired)
+        _add_thread_data(itr.tid, itr.lookup, &itr.init, itr.samples);
+
+    // order the threads which shared an index by when they were created
+    std::stable_sort(_thread_data.begin(), _thread_data.end(),
+                     [](const auto& _lhs, const auto& _rhs) {
+                         return std::tie(_lhs.tid, _lhs.lookup) <
+                                std::tie(_rhs.tid, _rhs.lookup);
+                     });
 
+    // symbolizing, filtering, and patching the call-stacks is the expensive part of
+    // post-processing and each thread is independent so this is done concurrently
+    {
         OMNITRACE_VERBOSE(2 || get_debug_sampling(),
-                          "Sampler data for thread %lu has %zu valid entries...\n", i,
-                          _raw_data.size());
+                          "Post-processing call-stacks for %zu threads...\n",
+                          _thread_data.size());
+        OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+        PTL::TaskGroup<void> _tg{ &tasking::get_thread_pool() };
+        for(auto& itr : _thread_data)
+            _tg.run([&itr]() { post_process_frames(itr); });
+        _tg.join();
+    }
 
-        _total_data += _raw_data.size();
-        _total_threads += 1;
+    // the perfetto data of each thread is generated on a separate thread (so that it
+    // gets its own track) and up to one of these threads per CPU run concurrently. The
+    // timemory data is inserted into the call-graph of this thread so it is generated
+    // serially in the order of the thread index, which keeps the output identical to
+    // processing each thread in turn. Each thread which shared an index gets its own
+    // perfetto track while the timemory data of these threads is combined
+    {
+        OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
+        auto _nconcurrent = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        auto _threads     = std::vector<std::thread>{};
+        auto _join        = [&_threads]() {
+            for(auto& itr : _threads)
+                if(itr.joinable()) itr.join();
+            _threads.clear();
+        };
 
-        if(get_use_perfetto()) post_process_perfetto(i, _init, _data);
-        if(get_use_timemory()) post_process_timemory(i, _init, _data);
+        for(size_t i = 0; i < _thread_data.size();)
+        {
+            auto _group = std::vector<const post_process_data*>{};
+            for(; i < _thread_data.size(); ++i)
+            {
+                if(!_group.empty() && _thread_data.at(i).tid != _group.front()->tid)
+                    break;
+                _group.emplace_back(&_thread_data.at(i));
+                if(get_use_perfetto())
+                {
+                    if(_threads.size() >= _nconcurrent) _join();
+                    _threads.emplace_back(post_process_perfetto(_thread_data.at(i)));
+                }
+            }
+            if(get_use_timemory()) post_process_timemory(_group);
+        }
+        _join();
     }
 
     OMNITRACE_VERBOSE(3 || get_debug_sampling(), "Destroying samplers...\n");
 
-    for(size_t i = 0; i < max_supported_threads; ++i)
+    for(size_t i = 0; i < sampler_instances::size(); ++i)
     {
         get_sampler(i).reset();
     }
@@ -552,9 +710,41 @@ post_process()
 namespace
 {
 void
-post_process_perfetto(int64_t _tid, const bundle_t* _init,
-                      const std::vector<bundle_t*>& _data)
+post_process_frames(post_process_data& _pp_data)
+{
+    const auto& _data = _pp_data.data;
+    auto        _bts  = std::vector<const backtrace*>{};
+    _bts.reserve(_data.size());
+    for(const auto& itr : _data)
+        _bts.emplace_back(itr->get<backtrace>());
+
+    // symbolize the unique instruction pointers once up front
+    auto _nsym = backtrace::resolve(_bts);
+    OMNITRACE_VERBOSE(2 || get_debug_sampling(),
+                      "[%li] Resolved %zu new symbols...\n", _pp_data.tid, _nsym);
+
+    _pp_data.frames.clear();
+    _pp_data.frames.reserve(_bts.size());
+    for(const auto* itr : _bts)
+    {
+        if(itr)
+            _pp_data.frames.emplace_back(backtrace::filter_and_patch(*itr));
+        else
+            _pp_data.frames.emplace_back();
+    }
+}
+
+std::thread
+post_process_perfetto(const post_process_data& _pp_data)
 {
+    const auto  _tid         = _pp_data.tid;
+    const auto* _init        = _pp_data.init;
+    const auto& _data        = _pp_data.data;
+    const auto& _thread_info = thread_info::get(_pp_data.lookup, LookupTID);
+
+    OMNITRACE_CI_THROW(!_thread_info, "No valid thread info for tid=%li\n", _tid);
+    if(!_thread_info) return std::thread{};
+
     if(trait::runtime_enabled<backtrace_metrics>::get())
     {
         OMNITRACE_VERBOSE(3 || get_debug_sampling(),
@@ -569,20 +759,16 @@ post_process_perfetto(int64_t _tid, const bundle_t* _init,
             _bt_metrics->post_process_perfetto(_tid, _bt_time->get_timestamp());
         }
 
-        backtrace_metrics::fini_perfetto(_tid);
+        backtrace_metrics::fini_perfetto(_tid, _thread_info->get_stop());
     }
 
-    auto _process_perfetto = [_tid,
-                              _init](const std::vector<sampling::bundle_t*>& _data) {
+    // the post-processing data and the thread info outlive the thread
+    auto _process_perfetto = [_tid, _init, &_pp_data, &_thread_info](
+                                 const std::vector<sampling::bundle_t*>& _data) {
         thread_info::init(true);
         OMNITRACE_VERBOSE(3 || get_debug_sampling(),
                           "[%li] Post-processing backtraces for perfetto...\n", _tid);
 
-        const auto& _thread_info = thread_info::get(_tid, InternalTID);
-        OMNITRACE_CI_THROW(!_thread_info, "No valid thread info for tid=%li\n", _tid);
-
-        if(!_thread_info) return;
-
         uint64_t _beg_ns  = _thread_info->get_start();
         uint64_t _end_ns  = _thread_info->get_stop();
         uint64_t _last_ts = std::max<uint64_t>(
@@ -591,18 +777,17 @@ post_process_perfetto(int64_t _tid, const bundle_t* _init,
         tracing::push_perfetto_ts(category::sampling{}, "samples [omnitrace]", _beg_ns,
                                   "begin_ns", _beg_ns);
 
-        for(const auto& itr : _data)
+        for(size_t i = 0; i < _data.size(); ++i)
         {
-            const auto* _bt_ts = itr->get<backtrace_timestamp>();
-            const auto* _bt_cs = itr->get<backtrace>();
+            const auto* _bt_ts = _data.at(i)->get<backtrace_timestamp>();
+            const auto* _bt_cs = _data.at(i)->get<backtrace>();
 
             if(!_bt_ts || !_bt_cs) continue;
             if(_bt_ts->get_tid() != _tid) continue;
 
-            static std::set<std::string> _static_strings{};
-            for(const auto& itr : backtrace::filter_and_patch(_bt_cs->get()))
+            for(const auto& itr : _pp_data.frames.at(i))
             {
-                const auto* _name = _static_strings.emplace(itr).first->c_str();
+                const auto* _name = string_table::get(itr);
                 uint64_t    _beg  = _last_ts;
                 uint64_t    _end  = _bt_ts->get_timestamp();
                 if(!_thread_info->is_valid_lifetime({ _beg, _end })) continue;
@@ -620,9 +805,11 @@ post_process_perfetto(int64_t _tid, const bundle_t* _init,
     };
 
     auto _processing_thread        = threading::get_tid();
-    auto _process_perfetto_wrapper = [&]() {
+    auto _process_perfetto_wrapper = [_processing_thread, _process_perfetto, &_data,
+                                      &_thread_info]() {
         if(threading::get_tid() != _processing_thread)
-            threading::set_thread_name(TIMEMORY_JOIN(" ", "Thread", _tid, "(S)").c_str());
+            threading::set_thread_name(
+                TIMEMORY_JOIN(" ", _thread_info->get_label(), "(S)").c_str());
 
         try
         {
@@ -636,130 +823,148 @@ post_process_perfetto(int64_t _tid, const bundle_t* _init,
         }
     };
 
-    OMNITRACE_SCOPED_SAMPLING_ON_CHILD_THREADS(false);
-    std::thread{ _process_perfetto_wrapper }.join();
+    return std::thread{ _process_perfetto_wrapper };
 }
 
 void
-post_process_timemory(int64_t _tid, const bundle_t* _init,
-                      const std::vector<bundle_t*>& _data)
+post_process_timemory(const std::vector<const post_process_data*>& _pp_data_v)
 {
+    if(_pp_data_v.empty()) return;
+
+    const auto _tid = _pp_data_v.front()->tid;
+
     auto _depth_sum = std::map<int64_t, std::map<int64_t, int64_t>>{};
 
     OMNITRACE_VERBOSE(3 || get_debug_sampling(),
                       "[%li] Post-processing data for timemory...\n", _tid);
 
-    const auto* _last = _init;
-    for(const auto& itr : _data)
+    for(const auto* _pp_data : _pp_data_v)
     {
-        using bundle_t = tim::lightweight_tuple<comp::trip_count, sampling_wall_clock,
-                                                sampling_cpu_clock, hw_counters>;
+        const auto* _init = _pp_data->init;
+        const auto& _data = _pp_data->data;
 
-        auto* _bt_data    = itr->get<backtrace>();
-        auto* _bt_time    = itr->get<backtrace_timestamp>();
-        auto* _bt_metrics = itr->get<backtrace_metrics>();
+        const auto* _last = _init;
+        for(size_t n = 0; n < _data.size(); ++n)
+        {
+            using bundle_t = tim::lightweight_tuple<comp::trip_count, sampling_wall_clock,
+                                                    sampling_cpu_clock, hw_counters>;
 
-        if(!_bt_data || !_bt_time || !_bt_metrics) continue;
+            const auto* itr = _data.at(n);
+            auto* _bt_data    = itr->get<backtrace>();
+            auto* _bt_time    = itr->get<backtrace_timestamp>();
+            auto* _bt_metrics = itr->get<backtrace_metrics>();
 
-        double _elapsed_wc = (_bt_time->get_timestamp() -
-                              _last->get<backtrace_timestamp>()->get_timestamp());
-        double _elapsed_cc = (_bt_metrics->get_cpu_timestamp() -
-                              _last->get<backtrace_metrics>()->get_cpu_timestamp());
+            if(!_bt_data || !_bt_time || !_bt_metrics) continue;
 
-        std::vector<bundle_t> _tc{};
-        _tc.reserve(_bt_data->size());
+            double _elapsed_wc = (_bt_time->get_timestamp() -
+                                  _last->get<backtrace_timestamp>()->get_timestamp());
+            double _elapsed_cc = (_bt_metrics->get_cpu_timestamp() -
+                                  _last->get<backtrace_metrics>()->get_cpu_timestamp());
 
-        // generate the instances of the tuple of components and start them
-        for(const auto& itr : backtrace::filter_and_patch(_bt_data->get()))
-        {
-            _tc.emplace_back(tim::string_view_t{ itr });
-            _tc.back().push(_bt_time->get_tid());
-            _tc.back().start();
-        }
+            std::vector<bundle_t> _tc{};
+            _tc.reserve(_bt_data->size());
 
-        // stop the instances and update the values as needed
-        for(size_t i = 0; i < _tc.size(); ++i)
-        {
-            auto&  itr    = _tc.at(_tc.size() - i - 1);
-            size_t _depth = 0;
-            _depth_sum[_bt_time->get_tid()][_depth] += 1;
-            itr.stop();
-            if constexpr(tim::trait::is_available<sampling_wall_clock>::value)
+            // generate the instances of the tuple of components and start them
+            for(const auto& itr : _pp_data->frames.at(n))
             {
-                auto* _sc = itr.get<sampling_wall_clock>();
-                if(_sc)
-                {
-                    auto _value = _elapsed_wc / sampling_wall_clock::get_unit();
-                    _sc->set_value(_value);
-                    _sc->set_accum(_value);
-                }
+                _tc.emplace_back(tim::string_view_t{ itr });
+                _tc.back().push(_bt_time->get_tid());
+                _tc.back().start();
             }
-            if constexpr(tim::trait::is_available<sampling_cpu_clock>::value)
+
+            // stop the instances and update the values as needed
+            for(size_t i = 0; i < _tc.size(); ++i)
             {
-                auto* _cc = itr.get<sampling_cpu_clock>();
-                if(_cc)
+                auto&  itr    = _tc.at(_tc.size() - i - 1);
+                size_t _depth = 0;
+                _depth_sum[_bt_time->get_tid()][_depth] += 1;
+                itr.stop();
+                if constexpr(tim::trait::is_available<sampling_wall_clock>::value)
                 {
-                    _cc->set_value(_elapsed_cc / sampling_cpu_clock::get_unit());
-                    _cc->set_accum(_elapsed_cc / sampling_cpu_clock::get_unit());
+                    auto* _sc = itr.get<sampling_wall_clock>();
+                    if(_sc)
+                    {
+                        auto _value = _elapsed_wc / sampling_wall_clock::get_unit();
+                        _sc->set_value(_value);
+                        _sc->set_accum(_value);
+                    }
                 }
-            }
-            if constexpr(tim::trait::is_available<hw_counters>::value)
-            {
-                auto _hw_cnt_vals = _bt_metrics->get_hw_counters();
-                if(_last && _bt_metrics->get_hw_counters().size() ==
-                                _last->get<backtrace_metrics>()->get_hw_counters().size())
+                if constexpr(tim::trait::is_available<sampling_cpu_clock>::value)
                 {
-                    for(size_t k = 0; k < _bt_metrics->get_hw_counters().size(); ++k)
+                    auto* _cc = itr.get<sampling_cpu_clock>();
+                    if(_cc)
                     {
-                        if(_last->get<backtrace_metrics>()->get_hw_counters()[k] >
-                           _hw_cnt_vals[k])
-                            _hw_cnt_vals[k] -=
-                                _last->get<backtrace_metrics>()->get_hw_counters()[k];
+                        _cc->set_value(_elapsed_cc / sampling_cpu_clock::get_unit());
+                        _cc->set_accum(_elapsed_cc / sampling_cpu_clock::get_unit());
                     }
                 }
-                auto* _hw_counter = itr.get<hw_counters>();
-                if(_hw_counter)
+                if constexpr(tim::trait::is_available<hw_counters>::value)
                 {
-                    _hw_counter->set_value(_hw_cnt_vals);
-                    _hw_counter->set_accum(_hw_cnt_vals);
+                    auto _hw_cnt_vals = _bt_metrics->get_hw_counters();
+                    if(_last &&
+                       _bt_metrics->get_hw_counters().size() ==
+                           _last->get<backtrace_metrics>()->get_hw_counters().size())
+                    {
+                        for(size_t k = 0; k < _bt_metrics->get_hw_counters().size(); ++k)
+                        {
+                            if(_last->get<backtrace_metrics>()->get_hw_counters()[k] >
+                               _hw_cnt_vals[k])
+                                _hw_cnt_vals[k] -=
+                                    _last->get<backtrace_metrics>()->get_hw_counters()[k];
+                        }
+                    }
+                    auto* _hw_counter = itr.get<hw_counters>();
+                    if(_hw_counter)
+                    {
+                        _hw_counter->set_value(_hw_cnt_vals);
+                        _hw_counter->set_accum(_hw_cnt_vals);
+                    }
                 }
+                itr.pop();
             }
-            itr.pop();
+            _last = itr;
         }
-        _last = itr;
     }
 
-    for(auto&& itr : _data)
+    // the percentages are relative to all the samples of the threads which shared
+    // this thread index
+    for(const auto* _pp_data : _pp_data_v)
     {
-        using bundle_t =
-            tim::lightweight_tuple<sampling_percent, quirk::config<quirk::tree_scope>>;
+        const auto& _data = _pp_data->data;
+
+        for(size_t n = 0; n < _data.size(); ++n)
+        {
+            using bundle_t = tim::lightweight_tuple<sampling_percent,
+                                                    quirk::config<quirk::tree_scope>>;
 
-        auto* _bt_data = itr->get<backtrace>();
-        auto* _bt_time = itr->get<backtrace_timestamp>();
+            const auto* itr = _data.at(n);
+            auto* _bt_data = itr->get<backtrace>();
+            auto* _bt_time = itr->get<backtrace_timestamp>();
 
-        if(!_bt_time || !_bt_data) continue;
-        if(_depth_sum.find(_bt_time->get_tid()) == _depth_sum.end()) continue;
+            if(!_bt_time || !_bt_data) continue;
+            if(_depth_sum.find(_bt_time->get_tid()) == _depth_sum.end()) continue;
 
-        std::vector<bundle_t> _tc{};
-        _tc.reserve(_bt_data->size());
+            std::vector<bundle_t> _tc{};
+            _tc.reserve(_bt_data->size());
 
-        // generate the instances of the tuple of components and start them
-        for(const auto& itr : backtrace::filter_and_patch(_bt_data->get()))
-        {
-            _tc.emplace_back(tim::string_view_t{ itr });
-            _tc.back().push(_bt_time->get_tid());
-            _tc.back().start();
-        }
+            // generate the instances of the tuple of components and start them
+            for(const auto& itr : _pp_data->frames.at(n))
+            {
+                _tc.emplace_back(tim::string_view_t{ itr });
+                _tc.back().push(_bt_time->get_tid());
+                _tc.back().start();
+            }
 
-        // stop the instances and update the values as needed
-        for(size_t i = 0; i < _tc.size(); ++i)
-        {
-            auto&  itr    = _tc.at(_tc.size() - i - 1);
-            size_t _depth = 0;
-            double _value = (1.0 / _depth_sum[_bt_time->get_tid()][_depth]) * 100.0;
-            itr.store(std::plus<double>{}, _value);
-            itr.stop();
-            itr.pop();
+            // stop the instances and update the values as needed
+            for(size_t i = 0; i < _tc.size(); ++i)
+            {
+                auto&  itr    = _tc.at(_tc.size() - i - 1);
+                size_t _depth = 0;
+                double _value = (1.0 / _depth_sum[_bt_time->get_tid()][_depth]) * 100.0;
+                itr.store(std::plus<double>{}, _value);
+                itr.stop();
+                itr.pop();
+            }
         }
     }
 }
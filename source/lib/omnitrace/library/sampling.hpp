@@ -70,6 +70,9 @@ void block_signals(std::set<int> = {});
 
 void unblock_signals(std::set<int> = {});
 
+void
+retire();
+
 void
 post_process();
 
@@ -0,0 +1,182 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "library/string_table.hpp"
+
+#include <timemory/hash.hpp>
+#include <timemory/hash/types.hpp>
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+namespace omnitrace
+{
+namespace string_table
+{
+namespace
+{
+struct node
+{
+    node(id_type _id, std::string_view _name, node* _next)
+    : id{ _id }
+    , name{ _name }
+    , next{ _next }
+    {}
+
+    const id_type     id   = 0;
+    const std::string name = {};
+    node* const       next = nullptr;
+};
+
+constexpr size_t num_shards  = 32;
+constexpr size_t num_buckets = 2048;
+
+// nodes are only ever prepended to a bucket and are never removed or modified after
+// they are published so readers only need an acquire load of the bucket head
+struct shard
+{
+    using bucket_array_t = std::array<std::atomic<node*>, num_buckets>;
+
+    std::mutex          mutex   = {};
+    std::atomic<size_t> count   = { 0 };
+    bucket_array_t      buckets = {};
+};
+
+auto&
+get_shards()
+{
+    // intentional leak: the strings must outlive every static destructor
+    static auto* _v = new std::array<shard, num_shards>{};
+    return *_v;
+}
+
+auto&
+get_shard(id_type _id)
+{
+    return get_shards()[_id % num_shards];
+}
+
+auto&
+get_bucket(id_type _id)
+{
+    return get_shard(_id).buckets[(_id / num_shards) % num_buckets];
+}
+
+id_type
+compute_id(std::string_view _v)
+{
+    return tim::hash::get_hash_id(tim::string_view_t{ _v.data(), _v.length() });
+}
+
+template <typename FuncT>
+const node*
+find_node(id_type _id, FuncT&& _pred)
+{
+    for(const node* itr = get_bucket(_id).load(std::memory_order_acquire);
+        itr != nullptr; itr = itr->next)
+    {
+        if(itr->id == _id && _pred(itr)) return itr;
+    }
+    return nullptr;
+}
+
+template <typename FuncT>
+const node*
+insert_node(id_type _id, std::string_view _name, FuncT&& _pred)
+{
+    auto& _shard  = get_shard(_id);
+    auto& _bucket = get_bucket(_id);
+
+    std::unique_lock<std::mutex> _lk{ _shard.mutex };
+    // another thread may have inserted it before the lock was acquired
+    const auto* _existing = find_node(_id, std::forward<FuncT>(_pred));
+    if(_existing) return _existing;
+
+    auto* _node = new node{ _id, _name, _bucket.load(std::memory_order_relaxed) };
+    _bucket.store(_node, std::memory_order_release);
+    _shard.count.fetch_add(1, std::memory_order_relaxed);
+    return _node;
+}
+
+const node*
+intern(std::string_view _name)
+{
+    auto _id   = compute_id(_name);
+    auto _pred = [_name](const node* _v) { return _v->name == _name; };
+    if(const auto* itr = find_node(_id, _pred)) return itr;
+    return insert_node(_id, _name, _pred);
+}
+}  // namespace
+
+id_type
+get_id(std::string_view _name)
+{
+    return intern(_name)->id;
+}
+
+const char*
+get(std::string_view _name)
+{
+    return intern(_name)->name.c_str();
+}
+
+const char*
+find(id_type _id)
+{
+    const auto* itr = find_node(_id, [](const node*) { return true; });
+    return (itr) ? itr->name.c_str() : nullptr;
+}
+
+const char*
+emplace(id_type _id, std::string_view _name)
+{
+    auto _pred = [](const node*) { return true; };
+    if(const auto* itr = find_node(_id, _pred)) return itr->name.c_str();
+    return insert_node(_id, _name, _pred)->name.c_str();
+}
+
+void
+for_each(const func_type& _func)
+{
+    for(auto& sitr : get_shards())
+    {
+        for(auto& bitr : sitr.buckets)
+        {
+            for(const node* itr = bitr.load(std::memory_order_acquire); itr != nullptr;
+                itr             = itr->next)
+                _func(itr->id, itr->name.c_str());
+        }
+    }
+}
+
+size_t
+size()
+{
+    size_t _n = 0;
+    for(auto& itr : get_shards())
+        _n += itr.count.load(std::memory_order_relaxed);
+    return _n;
+}
+}  // namespace string_table
+}  // namespace omnitrace
@@ -0,0 +1,64 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "library/defines.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace omnitrace
+{
+// a process-wide, thread-safe table of interned strings. Each unique string is
+// assigned a stable identifier (the same value timemory uses as the hash of the
+// string) and a stable null-terminated character array which remains valid for
+// the lifetime of the process. Lookups are lock-free and insertions only lock
+// the shard the string hashes to.
+namespace string_table
+{
+using id_type   = uint64_t;
+using func_type = std::function<void(id_type, const char*)>;
+
+// returns the identifier of the string, interning it if necessary
+id_type get_id(std::string_view);
+
+// returns the stable character array for the string, interning it if necessary
+const char* get(std::string_view);
+
+// returns the stable character array for the identifier or nullptr if unknown
+const char* find(id_type);
+
+// interns the string with an explicit identifier, e.g. for hash aliases
+const char* emplace(id_type, std::string_view);
+
+// invokes the function for every interned string
+void for_each(const func_type&);
+
+// number of interned strings
+size_t
+size();
+}  // namespace string_table
+}  // namespace omnitrace
@@ -0,0 +1,241 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include "library/defines.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace omnitrace
+{
+// array of per-thread data indexed by the thread index which grows as threads are
+// created. The elements are stored in chunks of geometrically increasing size (the
+// first chunk holds base_size elements and every subsequent chunk is twice the size
+// of the previous one) so locating an element in an existing chunk is a bit-scan and
+// a single atomic load without locking. A chunk is allocated on demand the first time
+// one of its elements is accessed: the chunk is run through the initializer and
+// published under a mutex, which is only acquired when a new chunk is needed or the
+// initializer is replaced. Elements never move once they have been accessed, i.e.
+// references to them remain valid for the lifetime of the array. size() is one past
+// the largest index which has been accessed so iterating over the array only visits
+// the threads which have existed
+template <typename Tp>
+class thread_array
+{
+public:
+    static constexpr size_t base_bits  = 5;
+    static constexpr size_t base_size  = (size_t{ 1 } << base_bits);
+    static constexpr size_t max_chunks = 32;
+
+    using value_type    = Tp;
+    using initializer_t = std::function<void(Tp&)>;
+
+    template <typename ArrT, typename Up>
+    struct iterator_base
+    {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type        = std::remove_const_t<Up>;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = Up*;
+        using reference         = Up&;
+
+        reference      operator*() const { return m_array->at(m_index); }
+        pointer        operator->() const { return &m_array->at(m_index); }
+        iterator_base& operator++() { return (++m_index, *this); }
+        iterator_base  operator++(int) { return iterator_base{ m_array, m_index++ }; }
+
+        bool operator==(const iterator_base& _rhs) const
+        {
+            return (m_array == _rhs.m_array && m_index == _rhs.m_index);
+        }
+
+        bool operator!=(const iterator_base& _rhs) const { return !(*this == _rhs); }
+
+        ArrT*  m_array = nullptr;
+        size_t m_index = 0;
+    };
+
+    using iterator       = iterator_base<thread_array, Tp>;
+    using const_iterator = iterator_base<const thread_array, const Tp>;
+
+    thread_array() = default;
+    ~thread_array();
+
+    thread_array(const thread_array&) = delete;
+    thread_array(thread_array&&)      = delete;
+
+    thread_array& operator=(const thread_array&) = delete;
+    thread_array& operator=(thread_array&&) = delete;
+
+    Tp&       at(size_t _idx);
+    const Tp& at(size_t _idx) const;
+
+    Tp&       operator[](size_t _idx) { return at(_idx); }
+    const Tp& operator[](size_t _idx) const { return at(_idx); }
+
+    size_t size() const { return m_size.load(std::memory_order_acquire); }
+    bool   empty() const { return (size() == 0); }
+
+    // applies the function to every existing element and to every element which is
+    // created afterwards
+    void set_initializer(initializer_t);
+
+    iterator       begin() { return iterator{ this, 0 }; }
+    iterator       end() { return iterator{ this, size() }; }
+    const_iterator begin() const { return const_iterator{ this, 0 }; }
+    const_iterator end() const { return const_iterator{ this, size() }; }
+
+private:
+    static size_t get_chunk(size_t _idx);
+    static size_t get_offset(size_t _idx, size_t _chunk);
+    static size_t get_chunk_size(size_t _chunk) { return (base_size << _chunk); }
+
+    Tp* allocate(size_t _chunk);
+
+    std::atomic<Tp*>    m_chunks[max_chunks] = {};
+    std::atomic<size_t> m_size               = { 0 };
+    std::mutex          m_mutex              = {};  // chunk publication + m_init
+    initializer_t*      m_init               = nullptr;
+};
+
+template <typename Tp>
+thread_array<Tp>::~thread_array()
+{
+    for(auto& itr : m_chunks)
+        delete[] itr.exchange(nullptr);
+    delete m_init;
+}
+
+template <typename Tp>
+inline size_t
+thread_array<Tp>::get_chunk(size_t _idx)
+{
+    constexpr size_t _nbits = std::numeric_limits<unsigned long>::digits;
+    static_assert(sizeof(size_t) == sizeof(unsigned long), "unexpected size_t");
+    // the chunk is the position of the highest bit of (idx + base_size), relative to
+    // the highest bit of base_size
+    return (_nbits - 1 - __builtin_clzl(_idx + base_size)) - base_bits;
+}
+
+template <typename Tp>
+inline size_t
+thread_array<Tp>::get_offset(size_t _idx, size_t _chunk)
+{
+    return (_idx + base_size) - get_chunk_size(_chunk);
+}
+
+template <typename Tp>
+inline Tp&
+thread_array<Tp>::at(size_t _idx)
+{
+    auto _chunk = get_chunk(_idx);
+    if(_chunk >= max_chunks)
+        throw std::out_of_range{ "omnitrace::thread_array::at(" + std::to_string(_idx) +
+                                 ")" };
+
+    auto* _data = m_chunks[_chunk].load(std::memory_order_acquire);
+    if(!_data) _data = allocate(_chunk);
+
+    auto _size = m_size.load(std::memory_order_relaxed);
+    while(_size <= _idx && !m_size.compare_exchange_weak(_size, _idx + 1,
+                                                         std::memory_order_release,
+                                                         std::memory_order_relaxed))
+    {}
+
+    return _data[get_offset(_idx, _chunk)];
+}
+
+template <typename Tp>
+inline const Tp&
+thread_array<Tp>::at(size_t _idx) const
+{
+    auto _chunk = get_chunk(_idx);
+    if(_chunk >= max_chunks)
+        throw std::out_of_range{ "omnitrace::thread_array::at(" + std::to_string(_idx) +
+                                 ") const" };
+
+    // elements which have not been created yet are reported as a default-constructed
+    // value instead of allocating the chunk
+    static const auto _empty = Tp{};
+    const auto*       _data  = m_chunks[_chunk].load(std::memory_order_acquire);
+    return (_data) ? _data[get_offset(_idx, _chunk)] : _empty;
+}
+
+template <typename Tp>
+Tp*
+thread_array<Tp>::allocate(size_t _chunk)
+{
+    auto  _n    = get_chunk_size(_chunk);
+    auto* _data = new Tp[_n]();
+
+    // the chunk is initialized and published under the same lock as the initializer
+    // is replaced so a chunk can not be published after set_initializer has visited
+    // the existing chunks without being initialized
+    auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+    if(auto* _existing = m_chunks[_chunk].load(std::memory_order_acquire))
+    {
+        // another thread allocated the chunk first
+        _lk.unlock();
+        delete[] _data;
+        return _existing;
+    }
+
+    if(m_init)
+    {
+        for(size_t i = 0; i < _n; ++i)
+            (*m_init)(_data[i]);
+    }
+    m_chunks[_chunk].store(_data, std::memory_order_release);
+    return _data;
+}
+
+template <typename Tp>
+void
+thread_array<Tp>::set_initializer(initializer_t _func)
+{
+    auto* _init = new initializer_t{ std::move(_func) };
+
+    auto _lk = std::unique_lock<std::mutex>{ m_mutex };
+    std::swap(m_init, _init);
+    delete _init;
+
+    for(size_t i = 0; i < max_chunks; ++i)
+    {
+        auto* _data = m_chunks[i].load(std::memory_order_acquire);
+        if(!_data) continue;
+        for(size_t j = 0; j < get_chunk_size(i); ++j)
+            (*m_init)(_data[j]);
+    }
+}
+}  // namespace omnitrace
@@ -28,11 +28,11 @@
 #include "library/config.hpp"
 #include "library/defines.hpp"
 #include "library/state.hpp"
+#include "library/thread_array.hpp"
 #include "library/timemory.hpp"
 
 #include <timemory/utility/types.hpp>
 
-#include <array>
 #include <cstdint>
 #include <cstdlib>
 #include <memory>
@@ -58,6 +58,8 @@ struct thread_deleter;
 template <typename Tp>
 using unique_ptr_t = std::unique_ptr<Tp, thread_deleter<Tp>>;
 
+// the per-thread data grows with the number of threads. This is only the number of
+// mutexes in the pools of per-thread mutexes, which are indexed modulo this value
 static constexpr size_t max_supported_threads = OMNITRACE_MAX_THREADS;
 
 template <>
@@ -115,11 +117,11 @@ private:
 
 using construct_on_init = std::true_type;
 
-template <typename Tp, typename Tag = void, size_t MaxThreads = max_supported_threads>
+template <typename Tp, typename Tag = void>
 struct thread_data
 {
     using value_type        = unique_ptr_t<Tp>;
-    using instance_array_t  = std::array<value_type, MaxThreads>;
+    using instance_array_t  = thread_array<value_type>;
     using construct_on_init = std::true_type;
 
     template <typename... Args>
@@ -131,7 +133,7 @@ struct thread_data
     template <typename... Args>
     static instance_array_t& instances(construct_on_init, Args&&...);
 
-    static constexpr size_t size() { return MaxThreads; }
+    static size_t size() { return instances().size(); }
 
     decltype(auto) begin() { return instances().begin(); }
     decltype(auto) end() { return instances().end(); }
@@ -140,10 +142,10 @@ struct thread_data
     decltype(auto) end() const { return instances().end(); }
 };
 
-template <typename Tp, typename Tag, size_t MaxThreads>
+template <typename Tp, typename Tag>
 template <typename... Args>
 void
-thread_data<Tp, Tag, MaxThreads>::construct(Args&&... _args)
+thread_data<Tp, Tag>::construct(Args&&... _args)
 {
     // construct outside of lambda to prevent data-race
     static auto&             _instances = instances();
@@ -155,39 +157,42 @@ thread_data<Tp, Tag, MaxThreads>::construct(Args&&... _args)
     (void) _v;
 }
 
-template <typename Tp, typename Tag, size_t MaxThreads>
+template <typename Tp, typename Tag>
 unique_ptr_t<Tp>&
-thread_data<Tp, Tag, MaxThreads>::instance()
+thread_data<Tp, Tag>::instance()
 {
     return instances().at(threading::get_id());
 }
 
-template <typename Tp, typename Tag, size_t MaxThreads>
-typename thread_data<Tp, Tag, MaxThreads>::instance_array_t&
-thread_data<Tp, Tag, MaxThreads>::instances()
+template <typename Tp, typename Tag>
+typename thread_data<Tp, Tag>::instance_array_t&
+thread_data<Tp, Tag>::instances()
 {
     static auto _v = instance_array_t{};
     return _v;
 }
 
-template <typename Tp, typename Tag, size_t MaxThreads>
+template <typename Tp, typename Tag>
 template <typename... Args>
 unique_ptr_t<Tp>&
-thread_data<Tp, Tag, MaxThreads>::instance(construct_on_init, Args&&... _args)
+thread_data<Tp, Tag>::instance(construct_on_init, Args&&... _args)
 {
     construct(std::forward<Args>(_args)...);
     return instances().at(threading::get_id());
 }
 
-template <typename Tp, typename Tag, size_t MaxThreads>
+template <typename Tp, typename Tag>
 template <typename... Args>
-typename thread_data<Tp, Tag, MaxThreads>::instance_array_t&
-thread_data<Tp, Tag, MaxThreads>::instances(construct_on_init, Args&&... _args)
+typename thread_data<Tp, Tag>::instance_array_t&
+thread_data<Tp, Tag>::instances(construct_on_init, Args&&... _args)
 {
+    // every element, including those of threads created later, is generated from
+    // copies of the arguments
     static auto& _v = [&]() -> instance_array_t& {
         auto& _internal = instances();
-        for(size_t i = 0; i < MaxThreads; ++i)
-            _internal.at(i) = generate<value_type>{}(std::forward<Args>(_args)...);
+        _internal.set_initializer([_args...](value_type& _val) {
+            _val = generate<value_type>{}(_args...);
+        });
         return _internal;
     }();
     return _v;
@@ -199,11 +204,11 @@ thread_data<Tp, Tag, MaxThreads>::instances(construct_on_init, Args&&... _args)
 //
 //--------------------------------------------------------------------------------------//
 
-template <typename Tp, typename Tag, size_t MaxThreads>
-struct thread_data<std::optional<Tp>, Tag, MaxThreads>
+template <typename Tp, typename Tag>
+struct thread_data<std::optional<Tp>, Tag>
 {
     using value_type        = std::optional<Tp>;
-    using instance_array_t  = std::array<value_type, MaxThreads>;
+    using instance_array_t  = thread_array<value_type>;
     using construct_on_init = std::true_type;
 
     template <typename... Args>
@@ -215,7 +220,7 @@ struct thread_data<std::optional<Tp>, Tag, MaxThreads>
     template <typename... Args>
     static instance_array_t& instances(construct_on_init, Args&&...);
 
-    static constexpr size_t size() { return MaxThreads; }
+    static size_t size() { return instances().size(); }
 
     decltype(auto) begin() { return instances().begin(); }
     decltype(auto) end() { return instances().end(); }
@@ -224,10 +229,10 @@ struct thread_data<std::optional<Tp>, Tag, MaxThreads>
     decltype(auto) end() const { return instances().end(); }
 };
 
-template <typename Tp, typename Tag, size_t MaxThreads>
+template <typename Tp, typename Tag>
 template <typename... Args>
 void
-thread_data<std::optional<Tp>, Tag, MaxThreads>::construct(Args&&... _args)
+thread_data<std::optional<Tp>, Tag>::construct(Args&&... _args)
 {
     // construct outside of lambda to prevent data-race
     static auto&             _instances = instances();
@@ -239,41 +244,44 @@ thread_data<std::optional<Tp>, Tag, MaxThreads>::construct(Args&&... _args)
     (void) _v;
 }
 
-template <typename Tp, typename Tag, size_t MaxThreads>
+template <typename Tp, typename Tag>
 std::optional<Tp>&
-thread_data<std::optional<Tp>, Tag, MaxThreads>::instance()
+thread_data<std::optional<Tp>, Tag>::instance()
 {
     return instances().at(threading::get_id());
 }
 
-template <typename Tp, typename Tag, size_t MaxThreads>
-typename thread_data<std::optional<Tp>, Tag, MaxThreads>::instance_array_t&
-thread_data<std::optional<Tp>, Tag, MaxThreads>::instances()
+template <typename Tp, typename Tag>
+typename thread_data<std::optional<Tp>, Tag>::instance_array_t&
+thread_data<std::optional<Tp>, Tag>::instances()
 {
     static auto _v = instance_array_t{};
     return _v;
 }
 
-template <typename Tp, typename Tag, size_t MaxThreads>
+template <typename Tp, typename Tag>
 template <typename... Args>
 std::optional<Tp>&
-thread_data<std::optional<Tp>, Tag, MaxThreads>::instance(construct_on_init,
+thread_data<std::optional<Tp>, Tag>::instance(construct_on_init,
                                                           Args&&... _args)
 {
     construct(std::forward<Args>(_args)...);
     return instances().at(threading::get_id());
 }
 
-template <typename Tp, typename Tag, size_t MaxThreads>
+template <typename Tp, typename Tag>
 template <typename... Args>
-typename thread_data<std::optional<Tp>, Tag, MaxThreads>::instance_array_t&
-thread_data<std::optional<Tp>, Tag, MaxThreads>::instances(construct_on_init,
+typename thread_data<std::optional<Tp>, Tag>::instance_array_t&
+thread_data<std::optional<Tp>, Tag>::instances(construct_on_init,
                                                            Args&&... _args)
 {
+    // every element, including those of threads created later, is generated from
+    // copies of the arguments
     static auto& _v = [&]() -> instance_array_t& {
         auto& _internal = instances();
-        for(size_t i = 0; i < MaxThreads; ++i)
-            _internal.at(i) = generate<value_type>{}(std::forward<Args>(_args)...);
+        _internal.set_initializer([_args...](value_type& _val) {
+            _val = generate<value_type>{}(_args...);
+        });
         return _internal;
     }();
     return _v;
@@ -288,11 +296,11 @@ thread_data<std::optional<Tp>, Tag, MaxThreads>::instances(construct_on_init,
 using tim::identity;
 using tim::identity_t;
 
-template <typename Tp, typename Tag, size_t MaxThreads>
-struct thread_data<identity<Tp>, Tag, MaxThreads>
+template <typename Tp, typename Tag>
+struct thread_data<identity<Tp>, Tag>
 {
     using value_type        = Tp;
-    using instance_array_t  = std::array<value_type, MaxThreads>;
+    using instance_array_t  = thread_array<value_type>;
     using construct_on_init = std::true_type;
 
     template <typename... Args>
@@ -304,7 +312,7 @@ struct thread_data<identity<Tp>, Tag, MaxThreads>
     template <typename... Args>
     static instance_array_t& instances(construct_on_init, Args&&...);
 
-    static constexpr size_t size() { return MaxThreads; }
+    static size_t size() { return instances().size(); }
 
     decltype(auto) begin() { return instances().begin(); }
     decltype(auto) end() { return instances().end(); }
@@ -313,10 +321,10 @@ struct thread_data<identity<Tp>, Tag, MaxThreads>
     decltype(auto) end() const { return instances().end(); }
 };
 
-template <typename Tp, typename Tag, size_t MaxThreads>
+template <typename Tp, typename Tag>
 template <typename... Args>
 void
-thread_data<identity<Tp>, Tag, MaxThreads>::construct(Args&&... _args)
+thread_data<identity<Tp>, Tag>::construct(Args&&... _args)
 {
     // construct outside of lambda to prevent data-race
     static auto&             _instances = instances();
@@ -328,39 +336,42 @@ thread_data<identity<Tp>, Tag, MaxThreads>::construct(Args&&... _args)
     (void) _v;
 }
 
-template <typename Tp, typename Tag, size_t MaxThreads>
+template <typename Tp, typename Tag>
 Tp&
-thread_data<identity<Tp>, Tag, MaxThreads>::instance()
+thread_data<identity<Tp>, Tag>::instance()
 {
     return instances().at(threading::get_id());
 }
 
-template <typename Tp, typename Tag, size_t MaxThreads>
-typename thread_data<identity<Tp>, Tag, MaxThreads>::instance_array_t&
-thread_data<identity<Tp>, Tag, MaxThreads>::instances()
+template <typename Tp, typename Tag>
+typename thread_data<identity<Tp>, Tag>::instance_array_t&
+thread_data<identity<Tp>, Tag>::instances()
 {
     static auto _v = instance_array_t{};
     return _v;
 }
 
-template <typename Tp, typename Tag, size_t MaxThreads>
+template <typename Tp, typename Tag>
 template <typename... Args>
 Tp&
-thread_data<identity<Tp>, Tag, MaxThreads>::instance(construct_on_init, Args&&... _args)
+thread_data<identity<Tp>, Tag>::instance(construct_on_init, Args&&... _args)
 {
     construct(std::forward<Args>(_args)...);
     return instances().at(threading::get_id());
 }
 
-template <typename Tp, typename Tag, size_t MaxThreads>
+template <typename Tp, typename Tag>
 template <typename... Args>
-typename thread_data<identity<Tp>, Tag, MaxThreads>::instance_array_t&
-thread_data<identity<Tp>, Tag, MaxThreads>::instances(construct_on_init, Args&&... _args)
+typename thread_data<identity<Tp>, Tag>::instance_array_t&
+thread_data<identity<Tp>, Tag>::instances(construct_on_init, Args&&... _args)
 {
+    // every element, including those of threads created later, is generated from
+    // copies of the arguments
     static auto& _v = [&]() -> instance_array_t& {
         auto& _internal = instances();
-        for(size_t i = 0; i < MaxThreads; ++i)
-            _internal.at(i) = generate<value_type>{}(std::forward<Args>(_args)...);
+        _internal.set_initializer([_args...](value_type& _val) {
+            _val = generate<value_type>{}(_args...);
+        });
         return _internal;
     }();
     return _v;
@@ -372,13 +383,76 @@ thread_data<identity<Tp>, Tag, MaxThreads>::instances(construct_on_init, Args&&.
 // vector<instrumentation_bundle_t> so using vector<instrumentation_bundle_t*> and
 // timemory's ring_buffer_allocator to create contiguous memory-page aligned instances of
 // the bundle
+//
+// the bundles are a stack: properly nested regions are always popped from the top in
+// constant time. A region which is popped out of order is found by searching down
+// the stack and its slot is set to nullptr instead of being erased so that the
+// remaining bundles do not have to be moved. Empty slots are discarded once they
+// reach the top so the top of the stack (if any) is always a valid bundle.
+//
+// every bundle is tagged with the number of bundles emplaced before it so that the
+// number of regions nested within a bundle is known when it is popped
 struct instrumentation_bundles
 {
-    using instance_array_t = std::array<instrumentation_bundles, max_supported_threads>;
+    using instance_array_t = thread_array<instrumentation_bundles>;
 
     bundle_allocator_t                     allocator{};
     std::vector<instrumentation_bundle_t*> bundles{};
+    std::vector<uint64_t>                  sequence{};
+    uint64_t                               count = 0;
+
+    template <typename... Args>
+    instrumentation_bundle_t* emplace(Args&&...);
+    instrumentation_bundle_t** find(size_t _hash);
+    void                       release(instrumentation_bundle_t** _slot);
+    uint64_t                   descendants(instrumentation_bundle_t** _slot) const;
 
     static instance_array_t& instances();
 };
+
+template <typename... Args>
+inline instrumentation_bundle_t*
+instrumentation_bundles::emplace(Args&&... _args)
+{
+    auto* _bundle = allocator.allocate(1);
+    bundles.emplace_back(_bundle);
+    sequence.emplace_back(count++);
+    allocator.construct(_bundle, std::forward<Args>(_args)...);
+    return _bundle;
+}
+
+inline instrumentation_bundle_t**
+instrumentation_bundles::find(size_t _hash)
+{
+    if(bundles.empty()) return nullptr;
+
+    // fast path: properly nested
+    if(bundles.back()->get_hash() == _hash) return &bundles.back();
+
+    // slow path: popped out of order
+    for(auto itr = bundles.rbegin() + 1; itr != bundles.rend(); ++itr)
+    {
+        if(*itr && (*itr)->get_hash() == _hash) return &(*itr);
+    }
+    return nullptr;
+}
+
+inline void
+instrumentation_bundles::release(instrumentation_bundle_t** _slot)
+{
+    allocator.destroy(*_slot);
+    allocator.deallocate(*_slot, 1);
+    *_slot = nullptr;
+    while(!bundles.empty() && bundles.back() == nullptr)
+    {
+        bundles.pop_back();
+        sequence.pop_back();
+    }
+}
+
+inline uint64_t
+instrumentation_bundles::descendants(instrumentation_bundle_t** _slot) const
+{
+    return count - sequence.at(_slot - bundles.data()) - 1;
+}
 }  // namespace omnitrace
@@ -26,6 +26,7 @@
 #include "library/runtime.hpp"
 #include "library/state.hpp"
 #include "library/thread_data.hpp"
+#include "library/timestamp.hpp"
 #include "library/utility.hpp"
 
 #include <timemory/backends/threading.hpp>
@@ -70,6 +71,18 @@ init_index_data(bool _offset = false)
     return itr;
 }
 
+// when thread ids are recycled, several threads share the same internal value. This
+// counts the threads which have been assigned each internal value
+auto&
+get_generation(int64_t _tid)
+{
+    struct thread_generation
+    {};
+    static auto& _v = thread_data<identity<int64_t>, thread_generation>::instances(
+        construct_on_init{}, 0);
+    return _v.at(_tid);
+}
+
 const auto unknown_thread = std::optional<thread_info>{};
 }  // namespace
 
@@ -84,7 +97,8 @@ thread_info::init(bool _offset)
         _info                             = thread_info{};
         _info->is_offset                  = threading::offset_this_id();
         _info->index_data                 = init_index_data(_info->is_offset);
-        _info->lifetime.first = tim::get_clock_real_now<uint64_t, std::nano>();
+        _info->generation = get_generation(_info->index_data->internal_value)++;
+        _info->lifetime.first = timestamp::now();
         if(_info->is_offset) set_thread_state(ThreadState::Disabled);
     };
 
@@ -105,21 +119,19 @@ thread_info::get(int64_t _tid, ThreadIdType _type)
 {
     if(_type == ThreadIdType::LookupTID)
         return thread_info_data_t::instances().at(_tid);
-    else if(_type == ThreadIdType::SystemTID)
-    {
-        const auto& _v = thread_info_data_t::instances();
-        for(const auto& itr : _v)
-        {
-            if(itr && itr->index_data->system_value == _tid) return itr;
-        }
-    }
-    else if(_type == ThreadIdType::InternalTID)
+
+    // system and internal values may be shared by several threads over the lifetime of
+    // the process so search in reverse to find the most recent thread
+    auto& _v = thread_info_data_t::instances();
+    for(size_t i = _v.size(); i > 0; --i)
     {
-        const auto& _v = thread_info_data_t::instances();
-        for(const auto& itr : _v)
-        {
-            if(itr && itr->index_data->internal_value == _tid) return itr;
-        }
+        const auto& itr = _v.at(i - 1);
+        if(!itr || !itr->index_data) continue;
+        if(_type == ThreadIdType::SystemTID && itr->index_data->system_value == _tid)
+            return itr;
+        else if(_type == ThreadIdType::InternalTID &&
+                itr->index_data->internal_value == _tid)
+            return itr;
     }
 
     OMNITRACE_CI_THROW(unknown_thread, "Unknown thread has been assigned a value");
@@ -205,7 +217,18 @@ thread_info::as_string() const
     if(index_data)
         _ss << ", index_data=(" << index_data->lookup_value << ", "
             << index_data->system_value << ", " << index_data->internal_value << ")";
+    if(generation > 0) _ss << ", generation=" << generation;
     _ss << ", lifetime=(" << lifetime.first << ":" << lifetime.second << ")";
     return _ss.str();
 }
+
+std::string
+thread_info::get_label() const
+{
+    // threads which were assigned a recycled index are distinguished by the number of
+    // threads which were previously assigned the same index, e.g. "Thread 3.1"
+    auto _tid = (index_data) ? index_data->internal_value : int64_t{ -1 };
+    if(generation == 0) return JOIN(" ", "Thread", _tid);
+    return JOIN("", "Thread ", _tid, ".", generation);
+}
 }  // namespace omnitrace
@@ -75,12 +75,14 @@ struct thread_info
     lifetime_data_t get_valid_lifetime(lifetime_data_t) const;
 
     std::string as_string() const;
+    std::string get_label() const;
 
     static const std::optional<thread_info>& init(bool _offset = false);
     static const std::optional<thread_info>& get();
     static const std::optional<thread_info>& get(int64_t _tid, ThreadIdType _type);
 
     bool            is_offset  = false;
+    int64_t         generation = 0;  // number of prior threads with same internal value
     index_data_t    index_data = {};
     lifetime_data_t lifetime   = { 0, 0 };
 
@@ -0,0 +1,258 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/throttle.hpp"
+#include "library/config.hpp"
+#include "library/debug.hpp"
+#include "library/string_table.hpp"
+#include "library/tracing.hpp"
+
+#include <timemory/settings.hpp>
+#include <timemory/utility/filepath.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace omnitrace
+{
+namespace throttle
+{
+namespace
+{
+struct region_data
+{
+    size_t   count    = 0;      // number of calls
+    size_t   recorded = 0;      // number of calls which were recorded
+    size_t   timed    = 0;      // number of calls contributing to elapsed
+    uint64_t elapsed  = 0;      // total duration of the timed calls [nsec]
+    bool     disabled = false;  // exceeded the throttle count under the throttle value
+};
+
+struct stack_entry
+{
+    uint64_t     hash     = 0;
+    uint64_t     start    = 0;
+    region_data* data     = nullptr;
+    bool         recorded = false;
+};
+
+// element references of an unordered_map remain valid after a rehash so the stack
+// can refer to the region data directly
+struct thread_throttle
+{
+    std::unordered_map<uint64_t, region_data> regions = {};
+    std::vector<stack_entry>                  stack   = {};
+};
+
+struct throttle_registry
+{
+    std::mutex                    mutex = {};
+    std::vector<thread_throttle*> data  = {};
+};
+
+auto&
+get_registry()
+{
+    // intentional leak: the data of threads which have exited is reported at finalization
+    static auto* _v = new throttle_registry{};
+    return *_v;
+}
+
+thread_throttle&
+get_thread_throttle()
+{
+    static thread_local auto* _v = []() {
+        auto* _data = new thread_throttle{};
+        _data->stack.reserve(512);
+        auto& _reg = get_registry();
+        auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+        _reg.data.emplace_back(_data);
+        return _data;
+    }();
+    return *_v;
+}
+
+std::string
+escape_regex(const std::string& _v)
+{
+    constexpr std::string_view _special = "\\^$.|?*+()[]{}";
+    auto                       _ret     = std::string{};
+    _ret.reserve(_v.length());
+    for(auto itr : _v)
+    {
+        if(_special.find(itr) != std::string_view::npos) _ret += '\\';
+        _ret += itr;
+    }
+    return _ret;
+}
+}  // namespace
+
+bool
+enabled()
+{
+    return (get_instrumentation_interval() > 1 || get_throttle_count() > 0);
+}
+
+bool
+start(uint64_t _hash)
+{
+    static auto _interval = std::max<size_t>(get_instrumentation_interval(), 1);
+    static auto _count    = get_throttle_count();
+
+    auto& _thr     = get_thread_throttle();
+    auto& _data    = _thr.regions[_hash];
+    auto  _n       = _data.count++;
+    auto  _record  = (!_data.disabled && (_n % _interval) == 0);
+    auto  _tracked = (!_data.disabled && _count > 0);
+    auto  _ts      = (_tracked) ? tracing::now() : uint64_t{ 0 };
+
+    if(_record) ++_data.recorded;
+    _thr.stack.emplace_back(stack_entry{ _hash, _ts, &_data, _record });
+    return _record;
+}
+
+bool
+stop(uint64_t _hash)
+{
+    static auto _count = get_throttle_count();
+    static auto _value = get_throttle_value();
+
+    auto& _thr = get_thread_throttle();
+    // find the matching entry. Entries above it were never exited (e.g. the stack was
+    // unwound by an exception or a longjmp) and are discarded. If there is no matching
+    // entry, the entry was not recorded so the exit is not recorded either
+    auto _itr = std::find_if(_thr.stack.rbegin(), _thr.stack.rend(),
+                             [_hash](const stack_entry& _v) { return _v.hash == _hash; });
+    if(_itr == _thr.stack.rend()) return false;
+
+    auto _entry = *_itr;
+    _thr.stack.erase(std::next(_itr).base(), _thr.stack.end());
+
+    auto& _data = *_entry.data;
+    if(_entry.start > 0 && !_data.disabled)
+    {
+        _data.elapsed += (tracing::now() - _entry.start);
+        _data.timed += 1;
+        if(_data.timed >= _count && (_data.elapsed / _data.timed) < _value)
+        {
+            _data.disabled    = true;
+            const auto* _name = string_table::find(_hash);
+            if(!_name) _name = "<unknown>";
+            OMNITRACE_VERBOSE(2,
+                              "[throttle] disabling '%s' after %zu calls (mean = %lu "
+                              "nsec)\n",
+                              _name, _data.count,
+                              static_cast<unsigned long>(_data.elapsed / _data.timed));
+        }
+    }
+
+    return _entry.recorded;
+}
+
+void
+post_process()
+{
+    struct summary
+    {
+        size_t   count    = 0;
+        size_t   recorded = 0;
+        size_t   timed    = 0;
+        size_t   threads  = 0;
+        uint64_t elapsed  = 0;
+    };
+
+    auto _skipped   = size_t{ 0 };
+    auto _summaries = std::map<std::string, summary>{};
+    {
+        auto& _reg = get_registry();
+        auto  _lk  = std::unique_lock<std::mutex>{ _reg.mutex };
+        for(const auto* titr : _reg.data)
+        {
+            for(const auto& ritr : titr->regions)
+            {
+                const auto& _data = ritr.second;
+                _skipped += (_data.count - _data.recorded);
+                if(!_data.disabled) continue;
+
+                const auto* _name = string_table::find(ritr.first);
+                auto&       _v    = _summaries[(_name) ? _name : std::string{}];
+                _v.count += _data.count;
+                _v.recorded += _data.recorded;
+                _v.timed += _data.timed;
+                _v.elapsed += _data.elapsed;
+                _v.threads += 1;
+            }
+        }
+    }
+
+    if(_skipped == 0) return;
+
+    OMNITRACE_VERBOSE(0, "[throttle] %zu region entries were not recorded\n", _skipped);
+    if(_summaries.empty()) return;
+
+    std::stringstream _oss{};
+    _oss << "# regions which were throttled because they were called at least "
+         << get_throttle_count() << " times with a mean duration below "
+         << get_throttle_value() << " nsec\n";
+    _oss << "#" << std::setw(15) << "calls" << std::setw(16) << "recorded"
+         << std::setw(10) << "threads" << std::setw(16) << "mean [nsec]"
+         << "  name\n";
+
+    auto _regex = std::string{};
+    for(const auto& itr : _summaries)
+    {
+        const auto& _v = itr.second;
+        _oss << std::setw(16) << _v.count << std::setw(16) << _v.recorded
+             << std::setw(10) << _v.threads << std::setw(16)
+             << ((_v.timed > 0) ? (_v.elapsed / _v.timed) : 0) << "  " << itr.first
+             << "\n";
+        if(!itr.first.empty())
+            _regex += JOIN("", (_regex.empty()) ? "" : "|", escape_regex(itr.first));
+    }
+    _oss << "#\n# exclude these regions from the instrumentation via:\n";
+    _oss << "#   omnitrace -E '^(" << _regex << ")$' ...\n";
+
+    OMNITRACE_VERBOSE(0, "[throttle] %zu regions were throttled\n", _summaries.size());
+    OMNITRACE_VERBOSE(1, "[throttle] throttled regions:\n%s", _oss.str().c_str());
+
+    auto          _fname = tim::settings::compose_output_filename("throttle", ".txt");
+    std::ofstream ofs{};
+    if(tim::filepath::open(ofs, _fname))
+    {
+        OMNITRACE_VERBOSE(0, "[throttle] Outputting '%s'...\n", _fname.c_str());
+        ofs << _oss.str();
+    }
+    else
+    {
+        OMNITRACE_PRINT("[throttle] Error opening '%s'\n", _fname.c_str());
+    }
+}
+}  // namespace throttle
+}  // namespace omnitrace
@@ -0,0 +1,54 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "library/defines.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace omnitrace
+{
+// per-thread, per-region throttling of the instrumentation. Regions are only recorded
+// once every OMNITRACE_INSTRUMENTATION_INTERVAL calls and, when OMNITRACE_THROTTLE_COUNT
+// is non-zero, a region is no longer recorded on a thread once it has been called that
+// many times with a mean duration below OMNITRACE_THROTTLE_VALUE nanoseconds
+namespace throttle
+{
+// returns true if throttling is configured
+bool
+enabled();
+
+// returns true if the entry into the region should be recorded
+bool start(uint64_t _hash);
+
+// returns true if the exit from the region should be recorded. Always mirrors the
+// decision of the matching start and returns false when there is no matching start
+bool stop(uint64_t _hash);
+
+// reports the throttled regions and writes them to the output folder so that they
+// can be passed to the instrumenter as function exclusions
+void
+post_process();
+}  // namespace throttle
+}  // namespace omnitrace
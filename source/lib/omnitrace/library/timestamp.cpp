@@ -0,0 +1,268 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "library/timestamp.hpp"
+#include "library/config.hpp"
+#include "library/debug.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#if defined(__x86_64__)
+#    include <cpuid.h>
+#endif
+
+namespace omnitrace
+{
+namespace timestamp
+{
+namespace
+{
+#if defined(__x86_64__)
+struct sample_data
+{
+    uint64_t tsc = 0;
+    uint64_t ns  = 0;
+};
+
+// minimum interval of the initial calibration
+constexpr uint64_t initial_calibration_ns = 10000000;
+// a difference between the model and CLOCK_REALTIME larger than this is treated as a
+// step of the system clock instead of drift
+constexpr int64_t max_drift_ns = 1000000;
+
+// counter value and time of the initial calibration. Only modified by initialize()
+// and by the thread which holds the re-calibration flag
+sample_data&
+get_anchor()
+{
+    static auto _v = sample_data{};
+    return _v;
+}
+
+uint64_t&
+get_period_ticks()
+{
+    static uint64_t _v = 0;
+    return _v;
+}
+
+std::atomic<bool>&
+get_recalibrating()
+{
+    static auto _v = std::atomic<bool>{ false };
+    return _v;
+}
+
+bool
+is_invariant_tsc()
+{
+    unsigned int _eax = 0, _ebx = 0, _ecx = 0, _edx = 0;
+    if(__get_cpuid(0x80000000, &_eax, &_ebx, &_ecx, &_edx) == 0 || _eax < 0x80000007)
+        return false;
+    if(__get_cpuid(0x80000007, &_eax, &_ebx, &_ecx, &_edx) == 0) return false;
+    return (_edx & (1u << 8)) != 0;
+}
+
+// the kernel switches away from the TSC when it detects that it is unreliable, e.g.
+// unsynchronized between sockets
+std::string
+get_clocksource()
+{
+    auto _ifs = std::ifstream{ "/sys/devices/system/clocksource/clocksource0/"
+                               "current_clocksource" };
+    auto _v   = std::string{};
+    if(_ifs) _ifs >> _v;
+    return _v;
+}
+
+// pairs a counter value with CLOCK_REALTIME. The clock read is bracketed by counter
+// reads and the tightest of several brackets is used
+sample_data
+sample()
+{
+    auto _v     = sample_data{};
+    auto _width = ~uint64_t{ 0 };
+    for(int i = 0; i < 5; ++i)
+    {
+        auto _beg = static_cast<uint64_t>(__rdtsc());
+        auto _ns  = realtime();
+        auto _end = static_cast<uint64_t>(__rdtsc());
+        if(_end - _beg < _width)
+        {
+            _width = _end - _beg;
+            _v     = sample_data{ _beg + (_width / 2), _ns };
+        }
+    }
+    return _v;
+}
+
+uint64_t
+compute_scale(const sample_data& _beg, const sample_data& _end)
+{
+    auto _ns = static_cast<uint128_t>(_end.ns - _beg.ns) << 32;
+    return static_cast<uint64_t>(_ns / (_end.tsc - _beg.tsc));
+}
+
+void
+publish(uint64_t _tsc, uint64_t _ns, uint64_t _scale, uint64_t _next)
+{
+    auto& _cal = get_calibration();
+    auto  _seq = _cal.sequence.load(std::memory_order_relaxed);
+    _cal.sequence.store(_seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    _cal.tsc.store(_tsc, std::memory_order_relaxed);
+    _cal.ns.store(_ns, std::memory_order_relaxed);
+    _cal.scale.store(_scale, std::memory_order_relaxed);
+    _cal.next.store(_next, std::memory_order_relaxed);
+    _cal.sequence.store(_seq + 2, std::memory_order_release);
+}
+#endif
+}  // namespace
+
+bool
+initialize()
+{
+    if(!config::get_tsc_timestamps()) return false;
+
+#if defined(__x86_64__)
+    if(!is_invariant_tsc())
+    {
+        OMNITRACE_VERBOSE(0, "[timestamp] the time-stamp counter is not invariant. "
+                             "Using CLOCK_REALTIME...\n");
+        return false;
+    }
+
+    auto _clocksource = get_clocksource();
+    if(!_clocksource.empty() && _clocksource != "tsc")
+    {
+        OMNITRACE_VERBOSE(0,
+                          "[timestamp] the kernel clocksource is '%s' instead of 'tsc'. "
+                          "Using CLOCK_REALTIME...\n",
+                          _clocksource.c_str());
+        return false;
+    }
+
+    auto _beg = sample();
+    while(realtime() < _beg.ns + initial_calibration_ns)
+    {}
+    auto _end = sample();
+
+    if(_end.tsc <= _beg.tsc || _end.ns <= _beg.ns)
+    {
+        OMNITRACE_VERBOSE(0, "[timestamp] the time-stamp counter did not advance. "
+                             "Using CLOCK_REALTIME...\n");
+        return false;
+    }
+
+    auto _ghz = static_cast<double>(_end.tsc - _beg.tsc) /
+                static_cast<double>(_end.ns - _beg.ns);
+    if(_ghz < 0.1 || _ghz > 10.0)
+    {
+        OMNITRACE_VERBOSE(0,
+                          "[timestamp] implausible time-stamp counter frequency (%.3f "
+                          "GHz). Using CLOCK_REALTIME...\n",
+                          _ghz);
+        return false;
+    }
+
+    auto _period_ns    = config::get_tsc_calibration_period() * 1000000;
+    get_anchor()       = _beg;
+    get_period_ticks() = static_cast<uint64_t>(static_cast<double>(_period_ns) * _ghz);
+    publish(_end.tsc, _end.ns, compute_scale(_beg, _end),
+            _end.tsc + get_period_ticks());
+    use_tsc() = true;
+
+    OMNITRACE_VERBOSE(1, "[timestamp] using the time-stamp counter (%.3f GHz)\n", _ghz);
+    return true;
+#else
+    OMNITRACE_VERBOSE(0, "[timestamp] the time-stamp counter is not supported on this "
+                         "architecture. Using CLOCK_REALTIME...\n");
+    return false;
+#endif
+}
+
+uint64_t
+recalibrate(uint64_t _tsc)
+{
+#if defined(__x86_64__)
+    auto& _cal = get_calibration();
+
+    // only one thread re-calibrates, the others continue with the current model
+    bool _expected = false;
+    if(!get_recalibrating().compare_exchange_strong(_expected, true))
+    {
+        auto _seq      = _cal.sequence.load(std::memory_order_acquire);
+        auto _base_tsc = _cal.tsc.load(std::memory_order_relaxed);
+        auto _base_ns  = _cal.ns.load(std::memory_order_relaxed);
+        auto _scale    = _cal.scale.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if((_seq & 1) || _seq != _cal.sequence.load(std::memory_order_relaxed))
+            return realtime();
+        return convert(_tsc, _base_tsc, _base_ns, _scale);
+    }
+
+    // this thread is the only writer so the model can be read directly
+    auto  _base_tsc = _cal.tsc.load(std::memory_order_relaxed);
+    auto  _base_ns  = _cal.ns.load(std::memory_order_relaxed);
+    auto  _scale    = _cal.scale.load(std::memory_order_relaxed);
+    auto& _anchor   = get_anchor();
+    auto  _period   = get_period_ticks();
+    auto  _sample   = sample();
+
+    auto _predicted = convert(_sample.tsc, _base_tsc, _base_ns, _scale);
+    auto _drift     = static_cast<int64_t>(_sample.ns - _predicted);
+
+    if(_sample.ns <= _anchor.ns || std::abs(_drift) > max_drift_ns)
+    {
+        // the system clock was stepped: restart the model from the current time
+        _anchor  = _sample;
+        _base_ns = _sample.ns;
+    }
+    else
+    {
+        // the frequency is measured over the entire run and the model is continued
+        // from its current value while the drift is absorbed over the next period so
+        // that the timestamps never jump
+        auto _freq   = static_cast<int64_t>(compute_scale(_anchor, _sample));
+        auto _adjust = static_cast<int128_t>(_drift) * (int128_t{ 1 } << 32) /
+                       static_cast<int128_t>(_period);
+        _base_ns = _predicted;
+        _scale   = static_cast<uint64_t>(
+            std::max<int64_t>(_freq + static_cast<int64_t>(_adjust), _freq / 2));
+    }
+    _base_tsc = _sample.tsc;
+    publish(_base_tsc, _base_ns, _scale, _base_tsc + _period);
+
+    get_recalibrating().store(false, std::memory_order_release);
+
+    return convert(_tsc, _base_tsc, _base_ns, _scale);
+#else
+    (void) _tsc;
+    return realtime();
+#endif
+}
+}  // namespace timestamp
+}  // namespace omnitrace
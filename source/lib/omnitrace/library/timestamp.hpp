@@ -0,0 +1,134 @@
+// MIT License
+//
+// Copyright (c) 2022 Advanced Micro Devices, Inc. All Rights Reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "library/defines.hpp"
+
+#include <timemory/components/timing/backends.hpp>
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#    include <x86intrin.h>
+#endif
+
+namespace omnitrace
+{
+// the timestamp source shared by tracing, the critical trace and sampling. By default,
+// this is CLOCK_REALTIME. When OMNITRACE_TSC_TIMESTAMPS is enabled and the CPU provides
+// an invariant time-stamp counter which the kernel also trusts, the counter is read
+// instead and converted to CLOCK_REALTIME nanoseconds via a linear model which is
+// calibrated at initialization and periodically re-calibrated
+namespace timestamp
+{
+// parameters of the linear model, published via a sequence lock. Readers never wait:
+// if the model is being updated, the reader falls back to CLOCK_REALTIME, which also
+// makes reading the timestamp safe within a signal handler
+struct calibration
+{
+    std::atomic<uint32_t> sequence = { 0 };
+    std::atomic<uint64_t> tsc      = { 0 };  // counter value at base
+    std::atomic<uint64_t> ns       = { 0 };  // nanoseconds at base
+    std::atomic<uint64_t> scale    = { 0 };  // nanoseconds per tick (32.32 fixed point)
+    std::atomic<uint64_t> next     = { 0 };  // counter value when re-calibration is due
+};
+
+inline bool&
+use_tsc()
+{
+    static bool _v = false;
+    return _v;
+}
+
+inline calibration&
+get_calibration()
+{
+    static calibration _v{};
+    return _v;
+}
+
+inline uint64_t
+realtime()
+{
+    return ::tim::get_clock_real_now<uint64_t, std::nano>();
+}
+
+// configures the timestamp source from the settings and performs the initial
+// calibration. Returns true if the time-stamp counter is used
+bool
+initialize();
+
+// re-calibrates the model with the counter value and returns it in nanoseconds
+uint64_t
+recalibrate(uint64_t _tsc);
+
+#if defined(__x86_64__)
+__extension__ typedef __int128 int128_t;
+__extension__ typedef unsigned __int128 uint128_t;
+
+inline uint64_t
+convert(uint64_t _tsc, uint64_t _base_tsc, uint64_t _base_ns, uint64_t _scale)
+{
+    // another thread may have re-calibrated after this counter value was read
+    if(_tsc < _base_tsc)
+    {
+        auto _delta = static_cast<uint128_t>(_base_tsc - _tsc) * _scale;
+        return _base_ns - static_cast<uint64_t>(_delta >> 32);
+    }
+    auto _delta = static_cast<uint128_t>(_tsc - _base_tsc) * _scale;
+    return _base_ns + static_cast<uint64_t>(_delta >> 32);
+}
+
+inline uint64_t
+tsc_now()
+{
+    auto& _cal = get_calibration();
+    auto  _tsc = static_cast<uint64_t>(__rdtsc());
+    auto  _seq = _cal.sequence.load(std::memory_order_acquire);
+    if(_seq & 1) return realtime();
+
+    auto _base_tsc = _cal.tsc.load(std::memory_order_relaxed);
+    auto _base_ns  = _cal.ns.load(std::memory_order_relaxed);
+    auto _scale    = _cal.scale.load(std::memory_order_relaxed);
+    auto _next     = _cal.next.load(std::memory_order_relaxed);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(_seq != _cal.sequence.load(std::memory_order_relaxed)) return realtime();
+
+    if(_tsc >= _next) return recalibrate(_tsc);
+    return convert(_tsc, _base_tsc, _base_ns, _scale);
+}
+#endif
+
+// current time in nanoseconds
+inline uint64_t
+now()
+{
+#if defined(__x86_64__)
+    if(use_tsc()) return tsc_now();
+#endif
+    return realtime();
+}
+}  // namespace timestamp
+}  // namespace omnitrace
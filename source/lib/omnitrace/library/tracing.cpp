@@ -41,19 +41,64 @@ get_finalization_functions()
     return _v;
 }
 
-tim::hash_map_ptr_t&
-get_timemory_hash_ids(int64_t _tid)
+namespace
 {
-    static auto _v = std::array<tim::hash_map_ptr_t, omnitrace::max_supported_threads>{};
-    return _v.at(_tid);
+// holds a reference to the hash maps of the thread so that they are still valid
+// when the thread-local storage of timemory is released. The maps are only read by
+// the thread which owns them since they are modified without synchronization
+struct hash_id_sync
+{
+    ~hash_id_sync() { fold(); }
+
+    void fold() const;
+
+    tim::hash_map_ptr_t   ids     = tim::get_hash_ids();
+    tim::hash_alias_ptr_t aliases = tim::get_hash_aliases();
+};
+
+void
+hash_id_sync::fold() const
+{
+    if(!ids) return;
+    for(const auto& itr : *ids)
+        string_table::emplace(itr.first, itr.second);
+    if(!aliases) return;
+    for(const auto& itr : *aliases)
+    {
+        auto _name = ids->find(itr.second);
+        if(_name != ids->end()) string_table::emplace(itr.first, _name->second);
+    }
+}
+
+auto&
+get_hash_id_sync()
+{
+    static thread_local auto _v = hash_id_sync{};
+    return _v;
+}
+}  // namespace
+
+void
+sync_timemory_hash_ids()
+{
+    (void) get_hash_id_sync();
 }
 
-tim::hash_alias_ptr_t&
-get_timemory_hash_aliases(int64_t _tid)
+void
+copy_timemory_hash_ids()
 {
-    static auto _v =
-        std::array<tim::hash_alias_ptr_t, omnitrace::max_supported_threads>{};
-    return _v.at(_tid);
+    // the maps of the threads which have exited were folded into the string table when
+    // they exited. The threads which are still alive (e.g. thread-pool workers) cannot
+    // be read from this thread but the names omnitrace passes to timemory on those
+    // threads are interned in the string table when they are recorded
+    get_hash_id_sync().fold();
+
+    auto _ids = tim::get_hash_ids();
+    if(!_ids) return;
+    string_table::for_each(
+        [&_ids](string_table::id_type _id, const char* _name) {
+            _ids->emplace(_id, _name);
+        });
 }
 
 void
@@ -61,7 +106,7 @@ record_thread_start_time()
 {
     static thread_local std::once_flag _once{};
     std::call_once(_once,
-                   []() { thread_info::set_start(comp::wall_clock::record(), true); });
+                   []() { thread_info::set_start(tracing::now(), true); });
 }
 }  // namespace tracing
 }  // namespace omnitrace
@@ -26,10 +26,14 @@
 #include "library/config.hpp"
 #include "library/debug.hpp"
 #include "library/defines.hpp"
+#include "library/overhead.hpp"
 #include "library/perfetto.hpp"
 #include "library/runtime.hpp"
 #include "library/sampling.hpp"
+#include "library/string_table.hpp"
+#include "library/thread_info.hpp"
 #include "library/timemory.hpp"
+#include "library/timestamp.hpp"
 #include "library/utility.hpp"
 
 #include <timemory/components/timing/backends.hpp>
@@ -46,17 +50,17 @@ get_trace_session();
 std::vector<std::function<void()>>&
 get_finalization_functions();
 
-tim::hash_map_ptr_t&
-get_timemory_hash_ids(int64_t _tid = threading::get_id());
+void
+sync_timemory_hash_ids();
 
-tim::hash_alias_ptr_t&
-get_timemory_hash_aliases(int64_t _tid = threading::get_id());
+void
+copy_timemory_hash_ids();
 
 template <typename Tp = uint64_t>
 OMNITRACE_INLINE auto
 now()
 {
-    return ::tim::get_clock_real_now<Tp, std::nano>();
+    return static_cast<Tp>(timestamp::now());
 }
 
 void
@@ -116,15 +120,14 @@ thread_init()
     } };
     static thread_local auto _thread_setup = []() {
         if(threading::get_id() > 0)
-            threading::set_thread_name(JOIN(" ", "Thread", threading::get_id()).c_str());
-        thread_data<thread_bundle_t>::construct(JOIN('/', "omnitrace/process",
-                                                     process::get_id(), "thread",
-                                                     threading::get_id()),
-                                                quirk::config<quirk::auto_start>{});
+            threading::set_thread_name(thread_info::init()->get_label().c_str());
+        thread_data<thread_bundle_t>::construct(
+            string_table::get(JOIN('/', "omnitrace/process", process::get_id(),
+                                   "thread", threading::get_id())),
+            quirk::config<quirk::auto_start>{});
         get_interval_data()->reserve(512);
-        // save the hash maps
-        get_timemory_hash_ids()     = tim::get_hash_ids();
-        get_timemory_hash_aliases() = tim::get_hash_aliases();
+        // fold the hashes of this thread into the string table when the thread exits
+        sync_timemory_hash_ids();
         record_thread_start_time();
         return true;
     }();
@@ -151,54 +154,68 @@ thread_init_sampling()
 
 template <typename CategoryT, typename... Args>
 inline void
-push_timemory(CategoryT, const char* name, Args&&... args)
+push_timemory(CategoryT, uint64_t _hash, Args&&... args)
 {
     if(trait::runtime_enabled<CategoryT>::get())
     {
         auto& _data = tracing::get_instrumentation_bundles();
-        // this generates a hash for the raw string array
-        auto  _hash   = tim::add_hash_id(tim::string_view_t{ name });
-        auto* _bundle = _data.allocator.allocate(1);
-        _data.bundles.emplace_back(_bundle);
-        _data.allocator.construct(_bundle, _hash);
-        _bundle->start(std::forward<Args>(args)...);
+        _data.emplace(_hash)->start(std::forward<Args>(args)...);
     }
 }
 
 template <typename CategoryT, typename... Args>
 inline void
-pop_timemory(CategoryT, const char* name, Args&&... args)
+pop_timemory(CategoryT, uint64_t _hash, Args&&... args)
 {
     if(trait::runtime_enabled<CategoryT>::get())
     {
-        auto  _hash = tim::hash::get_hash_id(tim::string_view_t{ name });
         auto& _data = tracing::get_instrumentation_bundles();
         if(_data.bundles.empty())
         {
+            const auto* _name = string_table::find(_hash);
             OMNITRACE_DEBUG("[%s] skipped %s :: empty bundle stack\n",
-                            "omnitrace_pop_trace", name);
+                            "omnitrace_pop_trace", (_name) ? _name : "<unknown>");
             return;
         }
-        for(size_t i = _data.bundles.size(); i > 0; --i)
+        auto** _slot = _data.find(_hash);
+        if(_slot)
         {
-            auto*& _v = _data.bundles.at(i - 1);
-            if(_v->get_hash() == _hash)
-            {
-                _v->stop(std::forward<Args>(args)...);
-                _data.allocator.destroy(_v);
-                _data.allocator.deallocate(_v, 1);
-                _data.bundles.erase(_data.bundles.begin() + (i - 1));
-                break;
-            }
+            auto _nested = _data.descendants(_slot);
+            if(_nested > 0) overhead::compensate(**_slot, _nested);
+            (*_slot)->stop(std::forward<Args>(args)...);
+            _data.release(_slot);
         }
     }
 }
 
+template <typename CategoryT, typename... Args>
+inline void
+push_timemory(CategoryT, const char* name, Args&&... args)
+{
+    if(trait::runtime_enabled<CategoryT>::get())
+    {
+        // the string table id is the timemory hash for the raw string array
+        push_timemory(CategoryT{}, string_table::get_id(name),
+                      std::forward<Args>(args)...);
+    }
+}
+
+template <typename CategoryT, typename... Args>
+inline void
+pop_timemory(CategoryT, const char* name, Args&&... args)
+{
+    if(trait::runtime_enabled<CategoryT>::get())
+    {
+        pop_timemory(CategoryT{}, string_table::get_id(name),
+                     std::forward<Args>(args)...);
+    }
+}
+
 template <typename CategoryT, typename... Args>
 inline void
 push_perfetto(CategoryT, const char* name, Args&&... args)
 {
-    uint64_t _ts = comp::wall_clock::record();
+    uint64_t _ts = tracing::now();
     TRACE_EVENT_BEGIN(trait::name<CategoryT>::value, perfetto::StaticString(name), _ts,
                       std::forward<Args>(args)..., "begin_ns", _ts);
 }
@@ -207,7 +224,7 @@ template <typename CategoryT, typename... Args>
 inline void
 pop_perfetto(CategoryT, const char*, Args&&... args)
 {
-    uint64_t _ts = comp::wall_clock::record();
+    uint64_t _ts = tracing::now();
     TRACE_EVENT_END(trait::name<CategoryT>::value, _ts, std::forward<Args>(args)...,
                     "end_ns", _ts);
 }
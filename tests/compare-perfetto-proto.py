@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+
+import sys
+import argparse
+from perfetto.trace_processor import TraceProcessor
+
+
+def read_slices(fname, categories):
+    """Returns the sorted (name, depth, count) of the slices in the trace"""
+    tp = TraceProcessor(trace=(fname))
+    pdata = {}
+    qr_it = tp.query("SELECT name, depth, category FROM slice")
+    for row in qr_it:
+        if categories and row.category not in categories:
+            continue
+        _key = (row.name, row.depth)
+        pdata[_key] = pdata.get(_key, 0) + 1
+    tp.close()
+    return sorted([[name, depth, count] for (name, depth), count in pdata.items()])
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument(
+        "-m", "--categories", nargs="+", help="Perfetto categories", default=[]
+    )
+    parser.add_argument(
+        "-i", "--inputs", nargs=2, type=str, help="Input files", required=True
+    )
+
+    args = parser.parse_args()
+
+    data = [read_slices(itr, args.categories) for itr in args.inputs]
+
+    ret = 0
+    if not data[0]:
+        print(f"No slices in {args.inputs[0]}")
+        ret = 1
+
+    if len(data[0]) != len(data[1]):
+        print(f"Mismatched number of slices: {len(data[0])} vs. {len(data[1])}")
+        ret = 1
+
+    for litr, ritr in zip(data[0], data[1]):
+        if litr != ritr:
+            print(f"Mismatched slice: {litr} vs. {ritr}")
+            ret = 1
+            break
+
+    if ret == 0:
+        print(f"{args.inputs[0]} and {args.inputs[1]} are identical")
+    sys.exit(ret)
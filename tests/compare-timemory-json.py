@@ -0,0 +1,57 @@
+#!/usr/bin/env python3
+
+import sys
+import json
+import argparse
+
+
+def read_entries(data):
+    """Returns the sorted (call-stack, laps) of every entry in the call-graph.
+
+    The entries are identified by their call-stack instead of their position in the
+    graph so that the comparison does not depend on the order the threads were merged
+    """
+    entries = []
+    stack = []
+    for itr in data:
+        _prefix = itr["prefix"]
+        _depth = itr["depth"]
+        _idx = _prefix.find(">>>")
+        if _idx >= 0:
+            _prefix = _prefix[(_idx + 4) :]
+        _prefix = _prefix.lstrip().lstrip("|_")
+        stack = stack[:_depth] + [_prefix]
+        entries.append(["/".join(stack), itr["entry"]["laps"]])
+    return sorted(entries)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-m", "--metric", type=str, help="JSON metric", required=True)
+    parser.add_argument(
+        "-i", "--inputs", nargs=2, type=str, help="Input files", required=True
+    )
+
+    args = parser.parse_args()
+
+    data = []
+    for itr in args.inputs:
+        with open(itr) as f:
+            data.append(
+                read_entries(json.load(f)["timemory"][args.metric]["ranks"][0]["graph"])
+            )
+
+    ret = 0
+    if len(data[0]) != len(data[1]):
+        print(f"Mismatched number of entries: {len(data[0])} vs. {len(data[1])}")
+        ret = 1
+
+    for litr, ritr in zip(data[0], data[1]):
+        if litr != ritr:
+            print(f"Mismatched entry: {litr} vs. {ritr}")
+            ret = 1
+            break
+
+    if ret == 0:
+        print(f"{args.inputs[0]} and {args.inputs[1]} are identical")
+    sys.exit(ret)
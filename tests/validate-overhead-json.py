@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+
+import sys
+import json
+import argparse
+
+
+def find_value(data, key):
+    """Returns the first value of the key in the nested dictionaries and lists"""
+    if isinstance(data, dict):
+        if key in data:
+            return data[key]
+        data = list(data.values())
+    if isinstance(data, list):
+        for itr in data:
+            _v = find_value(itr, key)
+            if _v is not None:
+                return _v
+    return None
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-i", "--input", type=str, help="Input file", required=True)
+
+    args = parser.parse_args()
+
+    with open(args.input) as f:
+        data = json.load(f)
+
+    values = {}
+    for itr in [
+        "overhead_calibrated_pair_cost_ns",
+        "overhead_corrected_regions",
+        "overhead_corrected_ns",
+    ]:
+        values[itr] = find_value(data, itr)
+        print(f"{itr} = {values[itr]}")
+
+    ret = 0
+    if any([itr is None or itr <= 0 for itr in values.values()]):
+        print("The overhead correction was not applied")
+        ret = 1
+    # at least one push/pop pair was subtracted from the corrected regions
+    elif values["overhead_corrected_ns"] < values["overhead_calibrated_pair_cost_ns"]:
+        print("The overhead correction is less than the cost of a push/pop pair")
+        ret = 1
+
+    if ret == 0:
+        print(f"{args.input} validated")
+    sys.exit(ret)
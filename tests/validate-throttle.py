@@ -0,0 +1,63 @@
+#!/usr/bin/env python3
+
+import sys
+import json
+import argparse
+
+
+def read_throttled(fname):
+    """Returns the {name: (calls, recorded)} of the regions in the throttle report"""
+    regions = {}
+    with open(fname) as f:
+        for itr in f.read().splitlines():
+            if not itr.strip() or itr.startswith("#"):
+                continue
+            _calls, _recorded, _threads, _mean, _name = itr.split(maxsplit=4)
+            regions[_name] = (int(_calls), int(_recorded))
+    return regions
+
+
+def read_laps(data):
+    """Returns the {name: laps} summed over every entry of the call-graph"""
+    laps = {}
+    for itr in data:
+        _prefix = itr["prefix"]
+        _idx = _prefix.find(">>>")
+        if _idx >= 0:
+            _prefix = _prefix[(_idx + 4) :]
+        _prefix = _prefix.lstrip().lstrip("|_")
+        laps[_prefix] = laps.get(_prefix, 0) + itr["entry"]["laps"]
+    return laps
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument("-m", "--metric", type=str, help="JSON metric", required=True)
+    parser.add_argument(
+        "-t", "--throttle", type=str, help="Throttle report", required=True
+    )
+    parser.add_argument("-i", "--input", type=str, help="Input file", required=True)
+
+    args = parser.parse_args()
+
+    regions = read_throttled(args.throttle)
+    with open(args.input) as f:
+        laps = read_laps(json.load(f)["timemory"][args.metric]["ranks"][0]["graph"])
+
+    ret = 0
+    if not regions:
+        print(f"No throttled regions in {args.throttle}")
+        ret = 1
+
+    for name, (calls, recorded) in regions.items():
+        _laps = laps.get(name, 0)
+        # the calls after the region was throttled must not be in the output
+        if _laps != recorded or recorded >= calls:
+            print(
+                f"Mismatched laps for {name}: {_laps} (recorded {recorded} of {calls})"
+            )
+            ret = 1
+
+    if ret == 0:
+        print(f"{args.input} validated")
+    sys.exit(ret)